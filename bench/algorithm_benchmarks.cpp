@@ -0,0 +1,112 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#if VLRX_CPP20
+#include <span>
+#endif
+
+namespace {
+
+constexpr std::uint64_t array_size{1 << 20};
+
+struct pod_struct {
+  int int_field;
+  double double_field;
+  char chars[12];
+
+  friend bool operator==(const pod_struct &lhs, const pod_struct &rhs) {
+    return lhs.int_field == rhs.int_field &&
+           lhs.double_field == rhs.double_field &&
+           std::equal(lhs.chars, lhs.chars + sizeof(lhs.chars), rhs.chars);
+  }
+};
+
+// the same standard algorithms over container iterators, spans converted
+// from containers and raw pointers
+template <typename T> void algorithm_benchmarks(const std::string &type_name) {
+  const vlrx::heap_array<T> source(array_size);
+  vlrx::heap_array<T> target(array_size);
+  const auto prefix = "heap_array<" + type_name + "> 1M ";
+#if VLRX_CPP20
+  const std::span<const T> source_span = source;
+  const std::span<T> target_span = target;
+  bench::run(
+      prefix + "std::copy std::span",
+      [&] {
+        [[maybe_unused]] auto res = std::copy(
+            source_span.begin(), source_span.end(), target_span.begin());
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "std::equal std::span",
+      [&] {
+        bench::do_not_optimize(std::equal(
+            source_span.begin(), source_span.end(), target_span.begin()));
+      },
+      array_size);
+  bench::run(
+      prefix + "std::fill std::span",
+      [&] {
+        std::fill(target_span.begin(), target_span.end(), T{});
+        bench::do_not_optimize(target);
+      },
+      array_size);
+#endif
+  bench::run(
+      prefix + "std::copy iterators",
+      [&] {
+        [[maybe_unused]] auto res =
+            std::copy(source.begin(), source.end(), target.begin());
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "std::copy pointers",
+      [&] {
+        std::copy(source.data(), source.data() + array_size, target.data());
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "std::equal iterators",
+      [&] {
+        bench::do_not_optimize(
+            std::equal(source.begin(), source.end(), target.begin()));
+      },
+      array_size);
+  bench::run(
+      prefix + "std::equal pointers",
+      [&] {
+        bench::do_not_optimize(std::equal(
+            source.data(), source.data() + array_size, target.data()));
+      },
+      array_size);
+  bench::run(
+      prefix + "std::fill iterators",
+      [&] {
+        std::fill(target.begin(), target.end(), T{});
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "std::fill pointers",
+      [&] {
+        std::fill(target.data(), target.data() + array_size, T{});
+        bench::do_not_optimize(target);
+      },
+      array_size);
+}
+
+} // namespace
+
+void run_algorithm_benchmarks() {
+  algorithm_benchmarks<std::uint8_t>("uint8_t");
+  algorithm_benchmarks<std::uint64_t>("uint64_t");
+  algorithm_benchmarks<pod_struct>("pod_struct");
+}
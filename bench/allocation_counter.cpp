@@ -0,0 +1,20 @@
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaced global allocation functions counting every allocation made with
+// operator new, including those of standard containers and of elements.
+// Array and nothrow forms forward to these by default.
+
+void *operator new(std::size_t size) {
+  ++bench::allocation_count();
+  if (void *ptr = std::malloc(size > 0 ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
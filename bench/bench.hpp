@@ -0,0 +1,212 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace bench {
+
+enum class output_format {
+  // aligned columns for reading
+  text,
+  // header line followed by one comma-separated line per benchmark
+  csv,
+  // one JSON object per line
+  jsonl,
+};
+
+struct options {
+  output_format format{output_format::text};
+  // the biggest number of elements used by the containers suite
+  std::uint64_t max_size{1000000};
+};
+
+inline options &settings() noexcept {
+  static options values;
+  return values;
+}
+
+// prevents compiler from optimizing away computation of value
+template <typename T> inline void do_not_optimize(T &&value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+// number of allocations made through operator new and counting_allocator
+inline std::atomic<std::uint64_t> &allocation_count() noexcept {
+  static std::atomic<std::uint64_t> count{};
+  return count;
+}
+
+// resident set size of the process
+inline std::uint64_t resident_bytes() {
+  std::uint64_t total_pages{};
+  std::uint64_t resident_pages{};
+  if (std::FILE *statm = std::fopen("/proc/self/statm", "r")) {
+    if (std::fscanf(statm, "%lu %lu", &total_pages, &resident_pages) != 2) {
+      resident_pages = 0;
+    }
+    std::fclose(statm);
+  }
+  return resident_pages * static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// the biggest resident set size the process had so far
+inline std::uint64_t peak_resident_bytes() {
+  rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+struct measurement {
+  double ns_per_call;
+  double allocations_per_call;
+};
+
+using clock = std::chrono::steady_clock;
+
+inline std::chrono::nanoseconds default_min_time() {
+  return std::chrono::milliseconds{200};
+}
+
+// runs fn repeatedly until min_time is reached
+template <typename Fn>
+measurement measure(Fn &&fn,
+                    const std::chrono::nanoseconds min_time =
+                        default_min_time()) {
+  fn(); // warm up
+  std::uint64_t iterations{1};
+  while (true) {
+    const auto allocations = allocation_count().load();
+    const auto start = clock::now();
+    for (std::uint64_t i{}; i < iterations; ++i) {
+      fn();
+    }
+    const auto elapsed = clock::now() - start;
+    if (elapsed >= min_time) {
+      return {static_cast<double>(
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      elapsed)
+                      .count()) /
+                  static_cast<double>(iterations),
+              static_cast<double>(allocation_count().load() - allocations) /
+                  static_cast<double>(iterations)};
+    }
+    iterations *= 2;
+  }
+}
+
+// runs fn(state) repeatedly until min_time is reached, state is created by
+// setup() and destroyed outside of the measured time
+template <typename Setup, typename Fn>
+measurement measure_with_setup(Setup &&setup, Fn &&fn,
+                               const std::chrono::nanoseconds min_time =
+                                   default_min_time()) {
+  {
+    auto state = setup(); // warm up
+    fn(state);
+  }
+  std::chrono::nanoseconds elapsed{};
+  std::uint64_t allocations{};
+  std::uint64_t calls{};
+  while (elapsed < min_time) {
+    auto state = setup();
+    const auto allocations_before = allocation_count().load();
+    const auto start = clock::now();
+    fn(state);
+    elapsed += clock::now() - start;
+    allocations += allocation_count().load() - allocations_before;
+    ++calls;
+  }
+  return {static_cast<double>(elapsed.count()) / static_cast<double>(calls),
+          static_cast<double>(allocations) / static_cast<double>(calls)};
+}
+
+inline void report(const std::string &name, const measurement &result) {
+  const auto rss = resident_bytes();
+  // the kernel updates the peak lazily, so it may lag behind the current size
+  const auto peak_rss = std::max(peak_resident_bytes(), rss);
+  switch (settings().format) {
+  case output_format::text:
+    std::printf("%-64s %14.1f ns %10.2f allocs %10.1f MiB rss\n", name.c_str(),
+                result.ns_per_call, result.allocations_per_call,
+                static_cast<double>(rss) / (1 << 20));
+    break;
+  case output_format::csv: {
+    static bool header_printed{};
+    if (!header_printed) {
+      std::printf("name,ns_per_op,allocations_per_op,rss_bytes,"
+                  "peak_rss_bytes\n");
+      header_printed = true;
+    }
+    std::printf("\"%s\",%.3f,%.3f,%lu,%lu\n", name.c_str(),
+                result.ns_per_call, result.allocations_per_call, rss,
+                peak_rss);
+    break;
+  }
+  case output_format::jsonl:
+    std::printf("{\"name\":\"%s\",\"ns_per_op\":%.3f,"
+                "\"allocations_per_op\":%.3f,\"rss_bytes\":%lu,"
+                "\"peak_rss_bytes\":%lu}\n",
+                name.c_str(), result.ns_per_call, result.allocations_per_call,
+                rss, peak_rss);
+    break;
+  }
+  std::fflush(stdout);
+}
+
+// measures and reports time and allocations per operation, ops is the
+// number of operations done by each call of fn
+template <typename Fn>
+double run(const std::string &name, Fn &&fn, const std::uint64_t ops = 1) {
+  const auto result = measure(fn);
+  const auto per_op = static_cast<double>(ops);
+  report(name, {result.ns_per_call / per_op,
+                result.allocations_per_call / per_op});
+  return result.ns_per_call / per_op;
+}
+
+// same as run, but fn(state) is measured without setup() creating state and
+// without its destruction
+template <typename Setup, typename Fn>
+double run_with_setup(const std::string &name, Setup &&setup, Fn &&fn,
+                      const std::uint64_t ops = 1) {
+  const auto result = measure_with_setup(setup, fn);
+  const auto per_op = static_cast<double>(ops);
+  report(name, {result.ns_per_call / per_op,
+                result.allocations_per_call / per_op});
+  return result.ns_per_call / per_op;
+}
+
+// heap_allocator which counts allocations
+template <typename T> struct counting_allocator : vlrx::heap_allocator<T> {
+  using value_type = T;
+
+  counting_allocator() noexcept = default;
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &) noexcept {}
+
+  template <typename U> struct rebind {
+    using other = counting_allocator<U>;
+  };
+
+  [[nodiscard]] T *allocate(const std::size_t size) {
+    ++allocation_count();
+    return vlrx::heap_allocator<T>::allocate(size);
+  }
+
+  [[nodiscard]] T *allocate_zeroed(const std::size_t size) {
+    ++allocation_count();
+    return vlrx::heap_allocator<T>::allocate_zeroed(size);
+  }
+};
+
+} // namespace bench
@@ -0,0 +1,258 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Compares heap_array with std::vector, std::unique_ptr<T[]> and std::array
+// on every operation of the fixed-size container interface.
+
+namespace {
+
+struct large_struct {
+  std::uint64_t values[32];
+
+  friend bool operator==(const large_struct &lhs, const large_struct &rhs) {
+    return std::equal(std::begin(lhs.values), std::end(lhs.values),
+                      std::begin(rhs.values));
+  }
+};
+
+template <typename T> T make_value();
+
+template <> std::uint64_t make_value<std::uint64_t>() { return 42; }
+
+// longer than the small string buffer, so every string allocates
+template <> std::string make_value<std::string>() {
+  return std::string(32, 'x');
+}
+
+template <> large_struct make_value<large_struct>() {
+  large_struct value{};
+  std::fill(std::begin(value.values), std::end(value.values), 42);
+  return value;
+}
+
+std::uint64_t weight(const std::uint64_t value) { return value; }
+
+std::uint64_t weight(const std::string &value) { return value.size(); }
+
+std::uint64_t weight(const large_struct &value) { return value.values[0]; }
+
+// std::unique_ptr<T[]> with its size, as fixed-size arrays are often written
+// by hand
+template <typename T> class unique_ptr_array {
+public:
+  using value_type = T;
+
+  unique_ptr_array(const std::uint64_t size, const T &value)
+      : data_{new T[size]}, size_{size} {
+    std::fill_n(data_.get(), size_, value);
+  }
+
+  unique_ptr_array(const unique_ptr_array &other)
+      : data_{new T[other.size_]}, size_{other.size_} {
+    std::copy_n(other.data_.get(), size_, data_.get());
+  }
+
+  unique_ptr_array(unique_ptr_array &&) noexcept = default;
+
+  unique_ptr_array &operator=(unique_ptr_array &&) noexcept = default;
+
+  unique_ptr_array &operator=(const unique_ptr_array &other) {
+    if (this != &other) {
+      if (size_ != other.size_) {
+        data_.reset(new T[other.size_]);
+        size_ = other.size_;
+      }
+      std::copy_n(other.data_.get(), size_, data_.get());
+    }
+    return *this;
+  }
+
+  T &operator[](const std::uint64_t pos) noexcept { return data_[pos]; }
+
+  const T &operator[](const std::uint64_t pos) const noexcept {
+    return data_[pos];
+  }
+
+  const T *begin() const noexcept { return data_.get(); }
+
+  const T *end() const noexcept { return data_.get() + size_; }
+
+  std::uint64_t size() const noexcept { return size_; }
+
+  friend void swap(unique_ptr_array &lhs, unique_ptr_array &rhs) noexcept {
+    std::swap(lhs.data_, rhs.data_);
+    std::swap(lhs.size_, rhs.size_);
+  }
+
+  friend bool operator==(const unique_ptr_array &lhs,
+                         const unique_ptr_array &rhs) {
+    return lhs.size_ == rhs.size_ &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+private:
+  std::unique_ptr<T[]> data_;
+  std::uint64_t size_;
+};
+
+template <typename Container> struct container_traits {
+  static constexpr bool is_resizable{true};
+
+  static Container make(const std::uint64_t size,
+                        const typename Container::value_type &value) {
+    return Container(size, value);
+  }
+};
+
+template <typename T, std::size_t N> struct container_traits<std::array<T, N>> {
+  static constexpr bool is_resizable{false};
+
+  static std::array<T, N> make(const std::uint64_t, const T &value) {
+    std::array<T, N> result;
+    result.fill(value);
+    return result;
+  }
+};
+
+// objects built or destroyed per measured call, so small sizes are not
+// dominated by clock reads
+std::uint64_t batch_size(const std::uint64_t size) {
+  return std::clamp<std::uint64_t>((std::uint64_t{1} << 16) / size, 1, 1024);
+}
+
+template <typename Container>
+void container_benchmarks(const std::string &name, const std::uint64_t size) {
+  using traits = container_traits<Container>;
+  using value_type = typename Container::value_type;
+  const auto prefix = name + "/" + std::to_string(size) + "/";
+  const auto value = make_value<value_type>();
+  const auto batch = batch_size(size);
+  const auto make_batch = [batch] {
+    std::vector<Container> containers;
+    containers.reserve(batch);
+    return containers;
+  };
+
+  bench::run_with_setup(
+      prefix + "construct", make_batch,
+      [&](std::vector<Container> &containers) {
+        for (std::uint64_t i{}; i < batch; ++i) {
+          containers.push_back(traits::make(size, value));
+        }
+      },
+      batch);
+  const auto source = traits::make(size, value);
+  bench::run_with_setup(
+      prefix + "copy construct", make_batch,
+      [&](std::vector<Container> &containers) {
+        for (std::uint64_t i{}; i < batch; ++i) {
+          containers.push_back(source);
+        }
+      },
+      batch);
+  auto target = traits::make(size, value);
+  bench::run(prefix + "copy assign same size", [&] {
+    target = source;
+    bench::do_not_optimize(target);
+  });
+  if constexpr (traits::is_resizable) {
+    const auto smaller = traits::make(size / 2, value);
+    bool toggle{};
+    bench::run(prefix + "copy assign different size", [&] {
+      target = toggle ? source : smaller;
+      toggle = !toggle;
+      bench::do_not_optimize(target);
+    });
+    target = source;
+  }
+  bench::run(
+      prefix + "iterate",
+      [&] {
+        std::uint64_t sum{};
+        for (const auto &element : source) {
+          sum += weight(element);
+        }
+        bench::do_not_optimize(sum);
+      },
+      size);
+  std::vector<std::uint64_t> indices(4096);
+  std::mt19937_64 random{7};
+  for (auto &idx : indices) {
+    idx = random() % size;
+  }
+  bench::run(
+      prefix + "random access",
+      [&] {
+        std::uint64_t sum{};
+        for (const auto idx : indices) {
+          sum += weight(source[idx]);
+        }
+        bench::do_not_optimize(sum);
+      },
+      indices.size());
+  bench::run(prefix + "compare equal", [&] {
+    bool equal = source == target;
+    bench::do_not_optimize(equal);
+  });
+  auto other = traits::make(size, value);
+  bench::run(prefix + "swap", [&] {
+    using std::swap;
+    swap(target, other);
+    bench::do_not_optimize(target);
+  });
+  bench::run_with_setup(
+      prefix + "destroy",
+      [&] {
+        auto containers = make_batch();
+        for (std::uint64_t i{}; i < batch; ++i) {
+          containers.push_back(source);
+        }
+        return containers;
+      },
+      [](std::vector<Container> &containers) { containers.clear(); },
+      batch);
+}
+
+template <typename T>
+void compared_benchmarks(const std::string &type_name,
+                         const std::uint64_t size) {
+  container_benchmarks<
+      vlrx::heap_array<T, std::uint64_t, bench::counting_allocator<T>>>(
+      "vlrx::heap_array<" + type_name + ">", size);
+  container_benchmarks<std::vector<T>>("std::vector<" + type_name + ">", size);
+  container_benchmarks<unique_ptr_array<T>>(
+      "std::unique_ptr<" + type_name + "[]>", size);
+}
+
+template <typename T, std::size_t... Sizes>
+void std_array_benchmarks(const std::string &type_name) {
+  (container_benchmarks<std::array<T, Sizes>>(
+       "std::array<" + type_name + ", N>", Sizes),
+   ...);
+}
+
+template <typename T> void type_benchmarks(const std::string &type_name) {
+  for (std::uint64_t size{1}; size <= bench::settings().max_size;
+       size *= 1000) {
+    compared_benchmarks<T>(type_name, size);
+  }
+  std_array_benchmarks<T, 1, 1000>(type_name);
+}
+
+} // namespace
+
+void run_container_benchmarks() {
+  type_benchmarks<std::uint64_t>("uint64_t");
+  type_benchmarks<std::string>("std::string");
+  type_benchmarks<large_struct>("large_struct");
+}
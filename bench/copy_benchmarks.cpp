@@ -0,0 +1,59 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct pod_struct {
+  int int_field;
+  double double_field;
+  char chars[12];
+};
+
+constexpr std::uint64_t array_size{1 << 20};
+
+template <typename Container>
+void copy_benchmarks(const std::string &container_name,
+                     const std::string &type_name) {
+  using value_type = typename Container::value_type;
+  const auto prefix = container_name + "<" + type_name + ">/";
+  const Container source(array_size, value_type{});
+  bench::run(prefix + "copy construct", [&] {
+    Container copy{source};
+    bench::do_not_optimize(copy);
+  });
+  Container same_size(array_size, value_type{});
+  bench::run(prefix + "copy assign same size", [&] {
+    same_size = source;
+    bench::do_not_optimize(same_size);
+  });
+  const Container smaller(array_size / 2, value_type{});
+  Container different_size(array_size, value_type{});
+  bool toggle{};
+  bench::run(prefix + "copy assign different size", [&] {
+    different_size = toggle ? source : smaller;
+    toggle = !toggle;
+    bench::do_not_optimize(different_size);
+  });
+  bench::run(prefix + "fill construct", [&] {
+    Container filled(array_size, value_type{});
+    bench::do_not_optimize(filled);
+  });
+}
+
+template <typename T> void copy_benchmarks(const std::string &type_name) {
+  copy_benchmarks<std::vector<T>>("std::vector", type_name);
+  copy_benchmarks<vlrx::heap_array<T>>("vlrx::heap_array", type_name);
+}
+
+} // namespace
+
+void run_copy_benchmarks() {
+  copy_benchmarks<int>("int");
+  copy_benchmarks<double>("double");
+  copy_benchmarks<pod_struct>("pod_struct");
+}
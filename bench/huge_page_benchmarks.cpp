@@ -0,0 +1,51 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "mmap_allocator.hpp"
+
+#include <cstdint>
+#include <string>
+
+// Run under `perf stat -e dTLB-load-misses,dTLB-loads heap_array_bench
+// huge_pages` to compare TLB misses of the storage modes.
+
+namespace {
+
+constexpr std::uint64_t table_size{std::uint64_t{32} << 20}; // 256 MiB
+constexpr std::uint64_t lookup_count{1 << 22};
+
+template <typename Array> void huge_page_benchmarks(const std::string &name) {
+  const auto generator = [](const std::uint64_t idx) { return idx * 7; };
+  bench::run(name + "/construct", [&] {
+    Array table(table_size, vlrx::from_generator, generator);
+    bench::do_not_optimize(table);
+  });
+  const Array table(table_size, vlrx::from_generator, generator);
+  bench::run(
+      name + "/random lookup",
+      [&] {
+        std::uint64_t sum{};
+        std::uint64_t state{12345};
+        for (std::uint64_t i{}; i < lookup_count; ++i) {
+          state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+          sum += table[(state >> 17) % table_size];
+        }
+        bench::do_not_optimize(sum);
+      },
+      lookup_count);
+}
+
+} // namespace
+
+void run_huge_page_benchmarks() {
+  huge_page_benchmarks<vlrx::heap_array<std::uint64_t>>(
+      "vlrx::heap_array<uint64_t> 256MiB");
+  huge_page_benchmarks<vlrx::mmap_heap_array<
+      std::uint64_t, std::uint64_t, vlrx::huge_pages::none>>(
+      "vlrx::mmap_heap_array<uint64_t, none> 256MiB");
+  huge_page_benchmarks<vlrx::mmap_heap_array<std::uint64_t>>(
+      "vlrx::mmap_heap_array<uint64_t, transparent> 256MiB");
+  huge_page_benchmarks<vlrx::mmap_heap_array<
+      std::uint64_t, std::uint64_t, vlrx::huge_pages::explicit_pool>>(
+      "vlrx::mmap_heap_array<uint64_t, explicit_pool> 256MiB");
+}
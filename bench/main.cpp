@@ -0,0 +1,110 @@
+#include "bench.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void run_container_benchmarks();
+void run_copy_benchmarks();
+void run_small_array_benchmarks();
+void run_huge_page_benchmarks();
+void run_stream_benchmarks();
+void run_parallel_benchmarks();
+void run_soa_benchmarks();
+void run_mdarray_benchmarks();
+void run_shared_benchmarks();
+void run_publisher_benchmarks();
+void run_pool_benchmarks();
+void run_algorithm_benchmarks();
+void run_reallocate_benchmarks();
+void run_simd_benchmarks();
+void run_search_index_benchmarks();
+void run_packed_benchmarks();
+void run_relocate_benchmarks();
+
+namespace {
+
+int usage(const char *program) {
+  std::fprintf(stderr,
+               "usage: %s [suite] [--format=text|csv|jsonl] "
+               "[--max-size=N]\n",
+               program);
+  return 1;
+}
+
+} // namespace
+
+// runs all suites, or only the one passed as the first positional argument
+int main(int argc, char *argv[]) {
+  const char *suite{};
+  for (int idx{1}; idx < argc; ++idx) {
+    const char *arg = argv[idx];
+    if (std::strcmp(arg, "--format=text") == 0) {
+      bench::settings().format = bench::output_format::text;
+    } else if (std::strcmp(arg, "--format=csv") == 0) {
+      bench::settings().format = bench::output_format::csv;
+    } else if (std::strcmp(arg, "--format=jsonl") == 0) {
+      bench::settings().format = bench::output_format::jsonl;
+    } else if (std::strncmp(arg, "--max-size=", 11) == 0) {
+      bench::settings().max_size = std::strtoull(arg + 11, nullptr, 10);
+    } else if (arg[0] == '-' || suite != nullptr) {
+      return usage(argv[0]);
+    } else {
+      suite = arg;
+    }
+  }
+  const auto enabled = [&](const char *name) {
+    return suite == nullptr || std::strcmp(suite, name) == 0;
+  };
+  if (enabled("containers")) {
+    run_container_benchmarks();
+  }
+  if (enabled("copy")) {
+    run_copy_benchmarks();
+  }
+  if (enabled("small_array")) {
+    run_small_array_benchmarks();
+  }
+  if (enabled("huge_pages")) {
+    run_huge_page_benchmarks();
+  }
+  if (enabled("stream")) {
+    run_stream_benchmarks();
+  }
+  if (enabled("parallel")) {
+    run_parallel_benchmarks();
+  }
+  if (enabled("soa")) {
+    run_soa_benchmarks();
+  }
+  if (enabled("mdarray")) {
+    run_mdarray_benchmarks();
+  }
+  if (enabled("shared")) {
+    run_shared_benchmarks();
+  }
+  if (enabled("publisher")) {
+    run_publisher_benchmarks();
+  }
+  if (enabled("pool")) {
+    run_pool_benchmarks();
+  }
+  if (enabled("algorithms")) {
+    run_algorithm_benchmarks();
+  }
+  if (enabled("reallocate")) {
+    run_reallocate_benchmarks();
+  }
+  if (enabled("simd")) {
+    run_simd_benchmarks();
+  }
+  if (enabled("search")) {
+    run_search_index_benchmarks();
+  }
+  if (enabled("packed")) {
+    run_packed_benchmarks();
+  }
+  if (enabled("relocate")) {
+    run_relocate_benchmarks();
+  }
+}
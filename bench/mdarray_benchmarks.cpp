@@ -0,0 +1,37 @@
+#include "bench.hpp"
+
+#include "heap_mdarray.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t matrix_size{4096};
+
+template <typename Matrix> void transpose_benchmark(const std::string &name) {
+  Matrix source(matrix_size, matrix_size);
+  source.for_each_index([&](const std::uint64_t i, const std::uint64_t j) {
+    source(i, j) = static_cast<float>(i ^ j);
+  });
+  Matrix target(matrix_size, matrix_size);
+  bench::run(
+      name,
+      [&] {
+        source.for_each_index(
+            [&](const std::uint64_t i, const std::uint64_t j) {
+              target(j, i) = source(i, j);
+            });
+        bench::do_not_optimize(target);
+      },
+      matrix_size * matrix_size);
+}
+
+} // namespace
+
+void run_mdarray_benchmarks() {
+  transpose_benchmark<vlrx::heap_mdarray<float, 2>>(
+      "transpose 4096x4096 float, layout_right");
+  transpose_benchmark<vlrx::heap_mdarray<float, 2, vlrx::layout_tiled<32>>>(
+      "transpose 4096x4096 float, layout_tiled<32>");
+}
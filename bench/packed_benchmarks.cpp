@@ -0,0 +1,78 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "packed_heap_array.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t column_size{std::uint64_t{1} << 28}; // 256M
+
+std::string mebibytes(const std::uint64_t bytes) {
+  return std::to_string(bytes >> 20) + " MiB";
+}
+
+// a column of bytes compared with the same values packed into Bits bits,
+// each call scans the whole column
+template <typename Packed, typename Generator>
+void packed_benchmarks(const std::string &name, Generator generator) {
+  using value_type = typename Packed::value_type;
+  const vlrx::heap_array<value_type> plain(column_size, vlrx::from_generator,
+                                           generator);
+  const Packed packed{plain};
+  const value_type needle{generator(std::uint64_t{1})};
+  // the only match of absent is the last element
+  const value_type absent{generator(std::uint64_t{0})};
+  vlrx::heap_array<value_type> with_last{plain};
+  std::replace(with_last.begin(), with_last.end(), absent, needle);
+  with_last.back() = absent;
+  Packed packed_with_last{with_last};
+
+  const auto plain_prefix = "heap_array<" + name + "> 256M (" +
+                            mebibytes(column_size * sizeof(value_type)) + ") ";
+  const auto packed_prefix =
+      "packed " + name + " 256M (" +
+      mebibytes(packed.words().size() * sizeof(std::uint64_t)) + ") ";
+
+  bench::run(
+      plain_prefix + "std::count",
+      [&] {
+        bench::do_not_optimize(std::count(plain.begin(), plain.end(), needle));
+      },
+      column_size);
+  bench::run(
+      packed_prefix + "count",
+      [&] { bench::do_not_optimize(packed.count(needle)); }, column_size);
+  bench::run(
+      plain_prefix + "std::find",
+      [&] {
+        bench::do_not_optimize(
+            std::find(with_last.begin(), with_last.end(), absent));
+      },
+      column_size);
+  bench::run(
+      packed_prefix + "find",
+      [&] { bench::do_not_optimize(packed_with_last.find(absent)); },
+      column_size);
+  bench::run(
+      plain_prefix + "copy",
+      [&] { bench::do_not_optimize(vlrx::heap_array<value_type>{plain}); },
+      column_size);
+  bench::run(
+      packed_prefix + "to_heap_array",
+      [&] { bench::do_not_optimize(packed.to_heap_array()); }, column_size);
+}
+
+} // namespace
+
+void run_packed_benchmarks() {
+  packed_benchmarks<vlrx::bit_heap_array<>>(
+      "bool", [](const std::uint64_t idx) { return idx % 3 == 1; });
+  packed_benchmarks<vlrx::packed_heap_array<3>>(
+      "3-bit uint8_t", [](const std::uint64_t idx) {
+        return static_cast<std::uint8_t>(idx * 5 % 8);
+      });
+}
@@ -0,0 +1,48 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "parallel_policy.hpp"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr std::uint64_t table_size{std::uint64_t{32} << 20}; // 256 MiB
+
+} // namespace
+
+void run_parallel_benchmarks() {
+  const auto generator = [](const std::uint64_t idx) { return idx * 7; };
+  const vlrx::heap_array<std::uint64_t> table(table_size, vlrx::from_generator,
+                                              generator);
+  const auto threads = std::thread::hardware_concurrency();
+  const std::string suffix = " 256MiB, " + std::to_string(threads) + " threads";
+  bench::run("serial generate" + suffix, [&] {
+    vlrx::heap_array<std::uint64_t> array(table_size, vlrx::from_generator,
+                                          generator);
+    bench::do_not_optimize(array);
+  });
+  bench::run("parallel generate" + suffix, [&] {
+    vlrx::heap_array<std::uint64_t> array(table_size, vlrx::from_generator,
+                                          generator,
+                                          vlrx::parallel_policy<>{threads});
+    bench::do_not_optimize(array);
+  });
+  bench::run("serial copy" + suffix, [&] {
+    vlrx::heap_array<std::uint64_t> copy(table);
+    bench::do_not_optimize(copy);
+  });
+  bench::run("parallel copy" + suffix, [&] {
+    vlrx::heap_array<std::uint64_t> copy(table,
+                                         vlrx::parallel_policy<>{threads});
+    bench::do_not_optimize(copy);
+  });
+  bench::run("parallel interleaved copy" + suffix, [&] {
+    vlrx::heap_array<std::uint64_t> copy(
+        table,
+        vlrx::parallel_policy<>{threads, vlrx::numa_placement::interleaved});
+    bench::do_not_optimize(copy);
+  });
+}
@@ -0,0 +1,51 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "pool_allocator.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace {
+
+// sizes recurring in a hot loop
+constexpr std::uint64_t recurring_sizes[] = {16, 100, 24, 1000, 64, 300};
+
+template <typename Array> void create_and_destroy(const std::string &name) {
+  for (const auto size : {std::uint64_t{16}, std::uint64_t{1000}}) {
+    bench::run(name + " create and destroy " + std::to_string(size), [&] {
+      Array array(size, vlrx::for_overwrite);
+      bench::do_not_optimize(array);
+    });
+  }
+  bench::run(
+      name + " create and destroy recurring sizes",
+      [&] {
+        for (const auto size : recurring_sizes) {
+          Array array(size, vlrx::for_overwrite);
+          bench::do_not_optimize(array);
+        }
+      },
+      std::size(recurring_sizes));
+  bench::run(
+      name + " 64 live arrays of recurring sizes",
+      [&] {
+        vlrx::heap_array<Array> arrays(64, vlrx::from_generator,
+                                       [](const std::uint64_t idx) {
+                                         return Array(
+                                             recurring_sizes[idx % 6],
+                                             vlrx::for_overwrite);
+                                       });
+        bench::do_not_optimize(arrays);
+      },
+      64);
+}
+
+} // namespace
+
+void run_pool_benchmarks() {
+  create_and_destroy<vlrx::heap_array<std::uint64_t>>(
+      "heap_array<uint64_t> (malloc)");
+  create_and_destroy<vlrx::pooled_heap_array<std::uint64_t>>(
+      "pooled_heap_array<uint64_t>");
+}
@@ -0,0 +1,70 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "heap_array_publisher.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr std::uint64_t table_size{1024};
+
+vlrx::heap_array<std::uint64_t> make_table(const std::uint64_t version) {
+  return vlrx::heap_array<std::uint64_t>(
+      table_size, vlrx::from_generator,
+      [&](const std::uint64_t idx) { return version + idx; });
+}
+
+// runs update(version) in a loop on a background thread while fn is measured
+template <typename Update, typename Fn>
+void run_with_updates(const std::string &name, Update &&update, Fn &&fn) {
+  std::atomic<bool> done{};
+  std::thread writer{[&] {
+    for (std::uint64_t version{}; !done.load(std::memory_order_relaxed);
+         ++version) {
+      update(version);
+    }
+  }};
+  bench::run(name, fn);
+  done = true;
+  writer.join();
+}
+
+} // namespace
+
+void run_publisher_benchmarks() {
+  vlrx::heap_array_publisher<std::uint64_t> publisher{make_table(0)};
+  auto reader = publisher.make_reader();
+  std::uint64_t idx{};
+  const auto read_published = [&] {
+    const auto table = reader.acquire();
+    bench::do_not_optimize((*table)[idx++ % table_size]);
+  };
+  bench::run("heap_array_publisher acquire and read, no updates",
+             read_published);
+  run_with_updates(
+      "heap_array_publisher acquire and read, continuous updates",
+      [&](const std::uint64_t version) {
+        publisher.publish(make_table(version));
+      },
+      read_published);
+
+  std::mutex mutex;
+  auto locked_table = make_table(0);
+  const auto read_locked = [&] {
+    const std::lock_guard<std::mutex> lock{mutex};
+    bench::do_not_optimize(locked_table[idx++ % table_size]);
+  };
+  bench::run("mutex-protected heap_array read, no updates", read_locked);
+  run_with_updates(
+      "mutex-protected heap_array read, continuous updates",
+      [&](const std::uint64_t version) {
+        auto table = make_table(version);
+        const std::lock_guard<std::mutex> lock{mutex};
+        locked_table.swap(table);
+      },
+      read_locked);
+}
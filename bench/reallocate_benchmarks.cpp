@@ -0,0 +1,47 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "mmap_allocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t base_size{std::uint64_t{8} << 20}; // 64 MiB
+
+// each call grows the array to twice its size and shrinks it back, added
+// elements are left uninitialized so only relocation is measured
+template <typename Array> void reallocate_benchmarks(const std::string &name) {
+  Array table(base_size, vlrx::from_generator,
+              [](const std::uint64_t idx) { return idx; });
+  bench::run(
+      name + "/copy into new buffer",
+      [&] {
+        for (const auto size : {base_size * 2, base_size}) {
+          Array next(size, vlrx::for_overwrite);
+          std::copy_n(table.data(), std::min(size, table.size()), next.data());
+          table = std::move(next);
+        }
+        bench::do_not_optimize(table);
+      },
+      2);
+  bench::run(
+      name + "/reallocate",
+      [&] {
+        table.reallocate(base_size * 2, vlrx::for_overwrite);
+        table.reallocate(base_size);
+        bench::do_not_optimize(table);
+      },
+      2);
+}
+
+} // namespace
+
+void run_reallocate_benchmarks() {
+  reallocate_benchmarks<vlrx::heap_array<std::uint64_t>>(
+      "vlrx::heap_array<uint64_t> 64MiB");
+  reallocate_benchmarks<vlrx::mmap_heap_array<std::uint64_t>>(
+      "vlrx::mmap_heap_array<uint64_t> 64MiB");
+}
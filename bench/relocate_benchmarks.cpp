@@ -0,0 +1,119 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t array_count{1000000};
+constexpr std::uint64_t array_size{16};
+
+using int_array = vlrx::heap_array<int>;
+
+// heap_array as it was before its move constructor became noexcept, so
+// std::vector copies it when it grows
+struct copied_on_growth {
+  explicit copied_on_growth(int_array &&array) : array_{std::move(array)} {}
+  copied_on_growth(const copied_on_growth &) = default;
+  copied_on_growth(copied_on_growth &&other)
+      : array_{std::move(other.array_)} {}
+  int_array array_;
+};
+
+template <typename Container> struct growth_state {
+  vlrx::heap_array<int_array> arrays;
+  Container grown;
+};
+
+template <typename Container> growth_state<Container> make_growth_state() {
+  return {vlrx::heap_array<int_array>(
+              array_count, vlrx::from_generator,
+              [](const std::uint64_t idx) {
+                return int_array(array_size, static_cast<int>(idx));
+              }),
+          Container{}};
+}
+
+// a million arrays are moved one by one into a container which doubles its
+// capacity when it is full, creating and destroying arrays is not measured
+void growth_benchmarks() {
+  const std::string prefix{"1M heap_array<int>(16) "};
+  bench::run_with_setup(
+      prefix + "std::vector push_back, copy on growth",
+      make_growth_state<std::vector<copied_on_growth>>,
+      [](auto &state) {
+        for (auto &array : state.arrays) {
+          state.grown.emplace_back(std::move(array));
+        }
+        bench::do_not_optimize(state.grown);
+      },
+      array_count);
+  bench::run_with_setup(
+      prefix + "std::vector push_back, move on growth",
+      make_growth_state<std::vector<int_array>>,
+      [](auto &state) {
+        for (auto &array : state.arrays) {
+          state.grown.push_back(std::move(array));
+        }
+        bench::do_not_optimize(state.grown);
+      },
+      array_count);
+  bench::run_with_setup(
+      prefix + "heap_array reallocate, relocate on growth",
+      make_growth_state<vlrx::heap_array<int_array>>,
+      [](auto &state) {
+        std::uint64_t size{};
+        for (auto &array : state.arrays) {
+          if (size == state.grown.size()) {
+            state.grown.reallocate(size == 0 ? 1 : size * 2);
+          }
+          state.grown[size++] = std::move(array);
+        }
+        bench::do_not_optimize(state.grown);
+      },
+      array_count);
+}
+
+// a million arrays are moved between two uninitialized buffers and back
+void relocation_benchmarks() {
+  std::allocator<int_array> alloc;
+  auto *first = alloc.allocate(array_count);
+  auto *second = alloc.allocate(array_count);
+  for (std::uint64_t idx{}; idx < array_count; ++idx) {
+    new (first + idx) int_array(array_size, static_cast<int>(idx));
+  }
+  const std::string prefix{"1M heap_array<int>(16) "};
+  bench::run(
+      prefix + "std::uninitialized_move_n + std::destroy_n",
+      [&] {
+        std::uninitialized_move_n(first, array_count, second);
+        std::destroy_n(first, array_count);
+        std::uninitialized_move_n(second, array_count, first);
+        std::destroy_n(second, array_count);
+        bench::do_not_optimize(first);
+      },
+      array_count * 2);
+  bench::run(
+      prefix + "vlrx::uninitialized_relocate_n",
+      [&] {
+        vlrx::uninitialized_relocate_n(first, array_count, second);
+        vlrx::uninitialized_relocate_n(second, array_count, first);
+        bench::do_not_optimize(first);
+      },
+      array_count * 2);
+  std::destroy_n(first, array_count);
+  alloc.deallocate(second, array_count);
+  alloc.deallocate(first, array_count);
+}
+
+} // namespace
+
+void run_relocate_benchmarks() {
+  growth_benchmarks();
+  relocation_benchmarks();
+}
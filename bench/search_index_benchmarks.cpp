@@ -0,0 +1,65 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "heap_search_index.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t query_count{1 << 20};
+
+// random lookups into a sorted table of size keys: binary search on the
+// table, then the index one query at a time and in batches
+void search_index_benchmarks(const std::uint64_t size,
+                             const std::string &size_name) {
+  const vlrx::heap_array<std::uint64_t> table(
+      size, vlrx::from_generator,
+      [](const std::uint64_t idx) { return idx * 2; });
+  const vlrx::heap_search_index<std::uint64_t> index{table};
+  std::mt19937_64 random{size};
+  const vlrx::heap_array<std::uint64_t> queries(
+      query_count, vlrx::from_generator,
+      [&](std::uint64_t) { return random() % (size * 2); });
+  vlrx::heap_array<std::uint64_t> positions(query_count);
+  const auto prefix = "heap_array<uint64_t> " + size_name + " ";
+
+  bench::run(
+      prefix + "std::lower_bound",
+      [&] {
+        for (std::uint64_t idx{}; idx < query_count; ++idx) {
+          positions[idx] = static_cast<std::uint64_t>(
+              std::lower_bound(table.begin(), table.end(), queries[idx]) -
+              table.begin());
+        }
+        bench::do_not_optimize(positions);
+      },
+      query_count);
+  bench::run(
+      prefix + "heap_search_index lower_bound",
+      [&] {
+        for (std::uint64_t idx{}; idx < query_count; ++idx) {
+          positions[idx] = index.lower_bound(queries[idx]);
+        }
+        bench::do_not_optimize(positions);
+      },
+      query_count);
+  bench::run(
+      prefix + "heap_search_index batched lower_bound",
+      [&] {
+        index.lower_bound(queries.data(), query_count, positions.data());
+        bench::do_not_optimize(positions);
+      },
+      query_count);
+}
+
+} // namespace
+
+void run_search_index_benchmarks() {
+  search_index_benchmarks(std::uint64_t{1} << 16, "64K");
+  search_index_benchmarks(std::uint64_t{1} << 20, "1M");
+  search_index_benchmarks(std::uint64_t{1} << 26, "64M");
+}
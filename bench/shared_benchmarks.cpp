@@ -0,0 +1,58 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "shared_heap_array.hpp"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t table_size{std::uint64_t{1} << 20};
+
+constexpr unsigned reader_count{4};
+
+constexpr std::uint64_t snapshots_per_reader{std::uint64_t{1} << 16};
+
+} // namespace
+
+void run_shared_benchmarks() {
+  const vlrx::heap_array<std::uint64_t> table(
+      table_size, vlrx::from_generator, [](const std::uint64_t idx) {
+        return idx;
+      });
+  const vlrx::shared_heap_array<std::uint64_t> shared_table(table);
+  bench::run("heap_array<uint64_t> snapshot (deep copy) 1M", [&] {
+    auto snapshot = table;
+    bench::do_not_optimize(snapshot);
+  });
+  bench::run("shared_heap_array<uint64_t> snapshot 1M", [&] {
+    auto snapshot = shared_table;
+    bench::do_not_optimize(snapshot);
+  });
+  bench::run("shared_heap_array<uint64_t> snapshot and detach 1M", [&] {
+    auto snapshot = shared_table;
+    snapshot[0] = 1;
+    bench::do_not_optimize(snapshot);
+  });
+  bench::run(
+      "shared_heap_array<uint64_t> snapshots by 4 threads",
+      [&] {
+        std::vector<std::thread> readers;
+        for (unsigned reader{}; reader < reader_count; ++reader) {
+          readers.emplace_back([&] {
+            std::uint64_t sum{};
+            for (std::uint64_t idx{}; idx < snapshots_per_reader; ++idx) {
+              const auto snapshot = shared_table;
+              sum += snapshot[idx % table_size];
+            }
+            bench::do_not_optimize(sum);
+          });
+        }
+        for (auto &reader : readers) {
+          reader.join();
+        }
+      },
+      reader_count * snapshots_per_reader);
+}
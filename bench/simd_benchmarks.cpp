@@ -0,0 +1,166 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "simd_algorithms.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <string>
+
+namespace {
+
+// fits into L2 cache, so kernels are not limited by memory bandwidth
+constexpr std::uint64_t array_size{1 << 14};
+
+const char *level_name(const vlrx::simd::level level) {
+  switch (level) {
+  case vlrx::simd::level::scalar:
+    return "scalar";
+  case vlrx::simd::level::sse2:
+    return "sse2";
+  case vlrx::simd::level::avx2:
+    return "avx2";
+  case vlrx::simd::level::avx512:
+    return "avx512";
+  }
+  return "";
+}
+
+// std:: equivalents over container iterators, then kernels at every level
+// supported by the CPU
+template <typename T> void simd_benchmarks(const std::string &type_name) {
+  const vlrx::heap_array<T> source(
+      array_size, vlrx::from_generator, [](const std::uint64_t idx) {
+        return static_cast<T>((idx * 37 + 11) % 101);
+      });
+  vlrx::heap_array<T> target{source};
+  const auto prefix = "heap_array<" + type_name + "> 16K ";
+  const T absent{static_cast<T>(120)};
+
+  bench::run(
+      prefix + "sum std::accumulate",
+      [&] {
+        bench::do_not_optimize(
+            std::accumulate(source.begin(), source.end(), T{}));
+      },
+      array_size);
+  bench::run(
+      prefix + "min std::min_element",
+      [&] {
+        bench::do_not_optimize(
+            *std::min_element(source.begin(), source.end()));
+      },
+      array_size);
+  bench::run(
+      prefix + "find std::find",
+      [&] {
+        bench::do_not_optimize(
+            std::find(source.begin(), source.end(), absent));
+      },
+      array_size);
+  bench::run(
+      prefix + "count std::count",
+      [&] {
+        bench::do_not_optimize(
+            std::count(source.begin(), source.end(), T{7}));
+      },
+      array_size);
+  bench::run(
+      prefix + "fill std::fill",
+      [&] {
+        std::fill(target.begin(), target.end(), T{3});
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "scale std::transform",
+      [&] {
+        [[maybe_unused]] auto res =
+            std::transform(target.begin(), target.end(), target.begin(),
+                           [](const T value) { return value * T{3}; });
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "axpy std::transform",
+      [&] {
+        [[maybe_unused]] auto res = std::transform(
+            source.begin(), source.end(), target.begin(), target.begin(),
+            [](const T x, const T y) { return y + T{3} * x; });
+        bench::do_not_optimize(target);
+      },
+      array_size);
+  bench::run(
+      prefix + "clamp std::transform",
+      [&] {
+        [[maybe_unused]] auto res = std::transform(
+            target.begin(), target.end(), target.begin(), [](const T value) {
+              return std::clamp(value, T{10}, T{40});
+            });
+        bench::do_not_optimize(target);
+      },
+      array_size);
+
+  for (const auto level :
+       {vlrx::simd::level::scalar, vlrx::simd::level::sse2,
+        vlrx::simd::level::avx2, vlrx::simd::level::avx512}) {
+    if (level > vlrx::simd::supported_level()) {
+      break;
+    }
+    vlrx::simd::set_level_limit(level);
+    const auto suffix = std::string{" simd "} + level_name(level);
+    bench::run(
+        prefix + "sum" + suffix,
+        [&] { bench::do_not_optimize(vlrx::simd::sum(source)); }, array_size);
+    bench::run(
+        prefix + "min" + suffix,
+        [&] { bench::do_not_optimize(vlrx::simd::min(source)); }, array_size);
+    bench::run(
+        prefix + "find" + suffix,
+        [&] { bench::do_not_optimize(vlrx::simd::find(source, absent)); },
+        array_size);
+    bench::run(
+        prefix + "count" + suffix,
+        [&] { bench::do_not_optimize(vlrx::simd::count(source, T{7})); },
+        array_size);
+    bench::run(
+        prefix + "fill" + suffix,
+        [&] {
+          vlrx::simd::fill(target, T{3});
+          bench::do_not_optimize(target);
+        },
+        array_size);
+    bench::run(
+        prefix + "scale" + suffix,
+        [&] {
+          vlrx::simd::scale(target, T{3});
+          bench::do_not_optimize(target);
+        },
+        array_size);
+    bench::run(
+        prefix + "axpy" + suffix,
+        [&] {
+          vlrx::simd::axpy(T{3}, source, target);
+          bench::do_not_optimize(target);
+        },
+        array_size);
+    bench::run(
+        prefix + "clamp" + suffix,
+        [&] {
+          vlrx::simd::clamp(target, T{10}, T{40});
+          bench::do_not_optimize(target);
+        },
+        array_size);
+  }
+  vlrx::simd::set_level_limit(vlrx::simd::level::avx512);
+}
+
+} // namespace
+
+void run_simd_benchmarks() {
+  simd_benchmarks<float>("float");
+  simd_benchmarks<double>("double");
+  simd_benchmarks<std::int32_t>("int32_t");
+  simd_benchmarks<std::uint8_t>("uint8_t");
+}
@@ -0,0 +1,86 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "small_heap_array.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t array_count{200000};
+constexpr std::uint64_t lookup_count{1000000};
+
+// mostly tiny arrays with a tail of bigger ones, like per-key attribute lists
+std::vector<std::uint64_t> make_sizes() {
+  std::mt19937_64 generator{42};
+  std::uniform_int_distribution<int> bucket{0, 99};
+  std::uniform_int_distribution<std::uint64_t> tiny{1, 2};
+  std::uniform_int_distribution<std::uint64_t> small{3, 8};
+  std::uniform_int_distribution<std::uint64_t> big{9, 32};
+  std::vector<std::uint64_t> sizes(array_count);
+  for (auto &size : sizes) {
+    const auto value = bucket(generator);
+    size = value < 50 ? tiny(generator)
+                      : (value < 85 ? small(generator) : big(generator));
+  }
+  return sizes;
+}
+
+template <typename Array>
+void small_array_benchmarks(const std::string &name,
+                            const std::vector<std::uint64_t> &sizes) {
+  const auto generator = [](const std::uint64_t idx) {
+    return static_cast<std::uint32_t>(idx);
+  };
+  bench::run(
+      name + "/build and destroy",
+      [&] {
+        std::vector<Array> arrays;
+        arrays.reserve(sizes.size());
+        for (const auto size : sizes) {
+          arrays.emplace_back(size, vlrx::from_generator, generator);
+        }
+        bench::do_not_optimize(arrays);
+      },
+      sizes.size());
+
+  std::vector<Array> arrays;
+  arrays.reserve(sizes.size());
+  for (const auto size : sizes) {
+    arrays.emplace_back(size, vlrx::from_generator, generator);
+  }
+
+  std::mt19937_64 random{7};
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> lookups(lookup_count);
+  for (auto &lookup : lookups) {
+    lookup.first = random() % arrays.size();
+    lookup.second = random() % sizes[lookup.first];
+  }
+  bench::run(
+      name + "/random lookup",
+      [&] {
+        std::uint64_t sum{};
+        for (const auto &lookup : lookups) {
+          sum += arrays[lookup.first][lookup.second];
+        }
+        bench::do_not_optimize(sum);
+      },
+      lookups.size());
+}
+
+} // namespace
+
+void run_small_array_benchmarks() {
+  const auto sizes = make_sizes();
+  small_array_benchmarks<vlrx::heap_array<
+      std::uint32_t, std::uint64_t, bench::counting_allocator<std::uint32_t>>>(
+      "vlrx::heap_array<uint32_t>", sizes);
+  small_array_benchmarks<
+      vlrx::small_heap_array<std::uint32_t, 8, std::uint64_t,
+                             bench::counting_allocator<std::uint32_t>>>(
+      "vlrx::small_heap_array<uint32_t, 8>", sizes);
+}
@@ -0,0 +1,75 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "heap_soa_array.hpp"
+
+#include <cstdint>
+#include <tuple>
+
+namespace {
+
+constexpr std::uint64_t record_count{std::uint64_t{1} << 22};
+
+struct record {
+  double price;
+  double quantity;
+  std::uint64_t id;
+  std::uint32_t flags;
+  char name[36];
+};
+
+} // namespace
+
+void run_soa_benchmarks() {
+  const auto make_record = [](const std::uint64_t idx) {
+    return record{idx * 0.25, idx * 0.5, idx, 0, {}};
+  };
+  const vlrx::heap_array<record> aos(record_count, vlrx::from_generator,
+                                     make_record);
+  const vlrx::heap_soa_array<double, double, std::uint64_t, std::uint32_t>
+      soa(record_count, vlrx::from_generator, [](const std::uint64_t idx) {
+        return std::tuple{idx * 0.25, idx * 0.5, idx, std::uint32_t{}};
+      });
+  bench::run(
+      "AoS heap_array<record> sum of one field 4M",
+      [&] {
+        double sum{};
+        for (const auto &element : aos) {
+          sum += element.price;
+        }
+        bench::do_not_optimize(sum);
+      },
+      record_count);
+  bench::run(
+      "heap_soa_array column sum of one field 4M",
+      [&] {
+        double sum{};
+        for (const auto price : soa.column<0>()) {
+          sum += price;
+        }
+        bench::do_not_optimize(sum);
+      },
+      record_count);
+  bench::run(
+      "AoS heap_array<record> dot product of two fields 4M",
+      [&] {
+        double sum{};
+        for (const auto &element : aos) {
+          sum += element.price * element.quantity;
+        }
+        bench::do_not_optimize(sum);
+      },
+      record_count);
+  bench::run(
+      "heap_soa_array dot product of two columns 4M",
+      [&] {
+        const auto prices = soa.column<0>();
+        const auto quantities = soa.column<1>();
+        double sum{};
+        for (std::uint64_t idx{}; idx < prices.size(); ++idx) {
+          sum += prices[idx] * quantities[idx];
+        }
+        bench::do_not_optimize(sum);
+      },
+      record_count);
+}
@@ -0,0 +1,81 @@
+#include "bench.hpp"
+
+#include "heap_array.hpp"
+#include "heap_array_stream.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t element_count{std::uint64_t{16} << 20}; // 128 MiB
+constexpr std::uint64_t string_count{1 << 20};
+
+struct string_codec {
+  void encode(const std::string &value, std::string &out) const {
+    out += value;
+  }
+
+  std::string decode(const char *data, const std::size_t size) const {
+    return std::string{data, size};
+  }
+};
+
+} // namespace
+
+void run_stream_benchmarks() {
+  const auto path =
+      (std::filesystem::temp_directory_path() / "heap_array_bench.stream")
+          .string();
+  {
+    const vlrx::heap_array<std::uint64_t> array(
+        element_count, vlrx::from_generator,
+        [](const std::uint64_t idx) { return idx; });
+    std::ofstream out{path, std::ios::binary};
+    vlrx::write_to(out, array);
+  }
+  bench::run(
+      "per element istream::read 128MiB",
+      [&] {
+        std::ifstream in{path, std::ios::binary};
+        in.seekg(sizeof(vlrx::detail::stream_header));
+        vlrx::heap_array<std::uint64_t> array(element_count,
+                                              vlrx::for_overwrite);
+        for (auto &element : array) {
+          in.read(reinterpret_cast<char *>(&element), sizeof(element));
+        }
+        bench::do_not_optimize(array);
+      },
+      element_count);
+  bench::run(
+      "vlrx::read_from 128MiB",
+      [&] {
+        std::ifstream in{path, std::ios::binary};
+        const auto array =
+            vlrx::read_from<vlrx::heap_array<std::uint64_t>>(in);
+        bench::do_not_optimize(array);
+      },
+      element_count);
+
+  {
+    const vlrx::heap_array<std::string> array(
+        string_count, vlrx::from_generator, [](const std::uint64_t idx) {
+          return std::string(16 + idx % 32, 'x');
+        });
+    std::ofstream out{path, std::ios::binary};
+    vlrx::write_to(out, array, string_codec{});
+  }
+  bench::run(
+      "vlrx::read_from with codec 1M strings",
+      [&] {
+        std::ifstream in{path, std::ios::binary};
+        const auto array = vlrx::read_from<vlrx::heap_array<std::string>>(
+            in, string_codec{});
+        bench::do_not_optimize(array);
+      },
+      string_count);
+  std::remove(path.c_str());
+}
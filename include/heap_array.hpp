@@ -1,497 +1,1811 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <initializer_list>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <new>
 #include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+// C++20 additions, e.g. contiguous iterators, which make containers
+// implicitly convertible to std::span
+#if __cplusplus >= 202002L
+#define VLRX_CPP20 1
+#else
+#define VLRX_CPP20 0
+#endif
+
+// members which may be used in constant expressions since C++20, where
+// memory allocated during the evaluation may be used within it
+#if VLRX_CPP20
+#define VLRX_CONSTEXPR20 constexpr
+#else
+#define VLRX_CONSTEXPR20
+#endif
+
 namespace vlrx {
 
-template <typename T, typename SizeType = std::uint64_t>
-class heap_array final {
-  template <bool is_const = false>
-  class [[nodiscard]] random_access_iterator final {
-  public:
-    random_access_iterator() noexcept : ptr_{} {};
+namespace detail {
 
-    random_access_iterator(const random_access_iterator &other)
-        : ptr_{other.ptr_} {}
+// Keeps the allocator as an (empty) base when possible, so stateless
+// allocators do not increase the size of the container.
+template <typename Allocator,
+          bool use_ebo = std::is_empty_v<Allocator> &&
+                         !std::is_final_v<Allocator>>
+class allocator_holder : private Allocator {
+protected:
+  constexpr explicit allocator_holder(const Allocator &alloc) noexcept
+      : Allocator(alloc) {}
 
-    random_access_iterator(random_access_iterator && other) : ptr_{other.ptr_} {
-      other.ptr_ = nullptr;
-    }
+  constexpr Allocator &get_allocator_ref() noexcept { return *this; }
 
-    template <bool is_const_ = is_const,
-              typename std::enable_if<is_const_, int>::type = 1>
-    random_access_iterator(const random_access_iterator<false> &other)
-        : ptr_{other.ptr_} {}
+  constexpr const Allocator &get_allocator_ref() const noexcept {
+    return *this;
+  }
+};
 
-    template <bool is_const_ = is_const,
-              typename std::enable_if<is_const_, int>::type = 1>
-    random_access_iterator(random_access_iterator<false> && other)
-        : ptr_{other.ptr_} {
-      other.ptr_ = nullptr;
-    }
+template <typename Allocator>
+class allocator_holder<Allocator, false> {
+protected:
+  constexpr explicit allocator_holder(const Allocator &alloc) noexcept
+      : alloc_(alloc) {}
 
-    random_access_iterator &operator=(const random_access_iterator &other) {
-      ptr_ = other.ptr_;
-      return *this;
-    }
+  constexpr Allocator &get_allocator_ref() noexcept { return alloc_; }
 
-    random_access_iterator &operator=(random_access_iterator &&other) {
-      ptr_ = other.ptr_;
-      other.ptr_ = nullptr;
-      return *this;
-    }
+  constexpr const Allocator &get_allocator_ref() const noexcept {
+    return alloc_;
+  }
 
-    template <bool is_const_ = is_const,
-              typename std::enable_if<is_const_, int>::type = 1>
-    random_access_iterator &operator=(
-        const random_access_iterator<false> &other) {
-      ptr_ = other.ptr_;
-      return *this;
-    }
+private:
+  Allocator alloc_;
+};
 
-    template <bool is_const_ = is_const,
-              typename std::enable_if<is_const_, int>::type = 1>
-    random_access_iterator &operator=(random_access_iterator<false> &&other) {
-      ptr_ = other.ptr_;
-      other.ptr_ = nullptr;
-      return *this;
-    }
+// Keeps size in the container object, or nothing if it is stored elsewhere.
+template <typename SizeType, bool stored = true> class size_holder {
+protected:
+  [[nodiscard]] constexpr SizeType held_size() const noexcept {
+    return size_;
+  }
 
-    using difference_type = std::ptrdiff_t;
-    using value_type = T;
-    using pointer =
-        typename std::conditional_t<is_const, const value_type *, value_type *>;
-    using reference =
-        typename std::conditional_t<is_const, const value_type &, value_type &>;
-    using const_pointer = const value_type *;
-    using const_reference = const value_type &;
-    using iterator_category = std::random_access_iterator_tag;
+  constexpr void hold_size(const SizeType size) noexcept { size_ = size; }
 
-    reference operator*() noexcept { return *ptr_; }
+private:
+  SizeType size_{};
+};
 
-    const_reference operator*() const noexcept { return *ptr_; }
+template <typename SizeType> class size_holder<SizeType, false> {
+protected:
+  constexpr void hold_size(const SizeType) noexcept {}
+};
 
-    pointer operator->() noexcept { return ptr_; }
+template <typename Allocator, typename = void>
+struct has_allocate_zeroed : std::false_type {};
+
+template <typename Allocator>
+struct has_allocate_zeroed<
+    Allocator, std::void_t<decltype(std::declval<Allocator &>().allocate_zeroed(
+                   std::declval<std::size_t>()))>> : std::true_type {};
+
+// reallocate(ptr, old_size, new_size) resizes the block in place or moves
+// its bytes, nullptr is returned (and ptr stays valid) when it is not able to
+template <typename Allocator, typename = void>
+struct has_reallocate : std::false_type {};
+
+template <typename Allocator>
+struct has_reallocate<
+    Allocator,
+    std::void_t<decltype(std::declval<Allocator &>().reallocate(
+        std::declval<typename Allocator::value_type *>(),
+        std::declval<std::size_t>(), std::declval<std::size_t>()))>>
+    : std::true_type {};
+
+// types for which value initialization is the same as filling the memory
+// with zero bytes
+template <typename T>
+inline constexpr bool is_zero_initializable_v =
+    std::is_scalar_v<T> && !std::is_member_pointer_v<T>;
+
+// true during constant evaluation, where memcpy, placement new and
+// instrumentation are not available
+[[nodiscard]] constexpr bool is_constant_evaluated() noexcept {
+#if VLRX_CPP20
+  return std::is_constant_evaluated();
+#else
+  return false;
+#endif
+}
 
-    const_pointer operator->() const noexcept { return ptr_; }
+template <typename Iterator, typename = void>
+struct is_forward_iterator : std::false_type {};
+
+template <typename Iterator>
+struct is_forward_iterator<
+    Iterator,
+    std::enable_if_t<std::is_base_of_v<
+        std::forward_iterator_tag,
+        typename std::iterator_traits<Iterator>::iterator_category>>>
+    : std::true_type {};
+
+template <typename Iterator>
+inline constexpr bool is_forward_iterator_v =
+    is_forward_iterator<Iterator>::value;
+
+template <typename Allocator, typename Pointer, typename ArgsList,
+          typename = void>
+struct has_construct : std::false_type {};
+
+template <typename Allocator, typename Pointer, typename... Args>
+struct has_construct<Allocator, Pointer, std::tuple<Args...>,
+                     std::void_t<decltype(std::declval<Allocator &>().construct(
+                         std::declval<Pointer>(), std::declval<Args>()...))>>
+    : std::true_type {};
+
+template <typename Allocator> struct is_std_allocator : std::false_type {};
+
+template <typename T>
+struct is_std_allocator<std::allocator<T>> : std::true_type {};
+
+// true if allocator_traits::construct is the same as placement new
+template <typename Allocator, typename T, typename... Args>
+inline constexpr bool uses_default_construct_v =
+    is_std_allocator<Allocator>::value ||
+    !has_construct<Allocator, T *, std::tuple<Args...>>::value;
+
+// Iterator over contiguous elements, shared by all containers of the library.
+template <typename T, bool is_const = false>
+class [[nodiscard]] random_access_iterator final {
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = T;
+  using pointer =
+      typename std::conditional_t<is_const, const value_type *, value_type *>;
+  using reference =
+      typename std::conditional_t<is_const, const value_type &, value_type &>;
+  using const_pointer = const value_type *;
+  using const_reference = const value_type &;
+  using iterator_category = std::random_access_iterator_tag;
+#if VLRX_CPP20
+  // lets std::to_address and algorithms treat elements as contiguous memory
+  using iterator_concept = std::contiguous_iterator_tag;
+  using element_type = std::conditional_t<is_const, const T, T>;
+#endif
+
+  constexpr random_access_iterator() noexcept : ptr_{} {};
+
+  constexpr explicit random_access_iterator(const pointer ptr) noexcept
+      : ptr_{ptr} {}
+
+  // trivially copyable, so it is passed in registers and moved-from
+  // iterators keep their position, like pointers
+  constexpr random_access_iterator(const random_access_iterator &) noexcept =
+      default;
+
+  constexpr random_access_iterator &
+  operator=(const random_access_iterator &) noexcept = default;
+
+  template <bool is_const_ = is_const,
+            typename std::enable_if<is_const_, int>::type = 1>
+  constexpr random_access_iterator(
+      const random_access_iterator<T, false> &other) noexcept
+      : ptr_{other.ptr_} {}
+
+  template <bool is_const_ = is_const,
+            typename std::enable_if<is_const_, int>::type = 1>
+  constexpr random_access_iterator &
+  operator=(const random_access_iterator<T, false> &other) noexcept {
+    ptr_ = other.ptr_;
+    return *this;
+  }
 
-    reference operator[](const difference_type shift) noexcept {
-      return *(ptr_ + shift);
-    }
+  constexpr reference operator*() const noexcept { return *ptr_; }
 
-    const_reference operator[](const difference_type shift) const noexcept {
-      return *(ptr_ + shift);
-    }
+  constexpr pointer operator->() const noexcept { return ptr_; }
 
-    friend random_access_iterator &operator++(
-        random_access_iterator &iter) noexcept {
-      ++iter.ptr_;
-      return iter;
-    }
+  constexpr reference operator[](const difference_type shift) const noexcept {
+    return *(ptr_ + shift);
+  }
 
-    friend random_access_iterator operator++(random_access_iterator &iter,
-                                             int) noexcept {
-      auto retval = iter;
-      ++iter.ptr_;
-      return retval;
-    }
+  friend constexpr random_access_iterator &operator++(
+      random_access_iterator &iter) noexcept {
+    ++iter.ptr_;
+    return iter;
+  }
 
-    random_access_iterator &operator--() noexcept {
-      --ptr_;
-      return *this;
-    }
+  friend constexpr random_access_iterator
+  operator++(random_access_iterator &iter, int) noexcept {
+    auto retval = iter;
+    ++iter.ptr_;
+    return retval;
+  }
 
-    random_access_iterator operator--(int) noexcept {
-      auto retval = *this;
-      --(*this).ptr_;
-      return retval;
-    }
+  constexpr random_access_iterator &operator--() noexcept {
+    --ptr_;
+    return *this;
+  }
 
-    random_access_iterator &operator+=(const difference_type shift) {
-      (*this).ptr_ += shift;
-      return *this;
-    }
+  constexpr random_access_iterator operator--(int) noexcept {
+    auto retval = *this;
+    --(*this).ptr_;
+    return retval;
+  }
 
-    random_access_iterator &operator-=(const difference_type shift) {
-      (*this).ptr_ -= shift;
-      return *this;
-    }
+  constexpr random_access_iterator &operator+=(const difference_type shift) {
+    (*this).ptr_ += shift;
+    return *this;
+  }
 
-    friend random_access_iterator operator+(const random_access_iterator &iter,
-                                            const difference_type shift) {
-      return random_access_iterator{iter.ptr_ + shift};
-    }
+  constexpr random_access_iterator &operator-=(const difference_type shift) {
+    (*this).ptr_ -= shift;
+    return *this;
+  }
 
-    friend random_access_iterator operator+(
-        const difference_type shift, const random_access_iterator &iter) {
-      return random_access_iterator{iter.ptr_ + shift};
-    }
+  friend constexpr random_access_iterator
+  operator+(const random_access_iterator &iter, const difference_type shift) {
+    return random_access_iterator{iter.ptr_ + shift};
+  }
 
-    friend random_access_iterator operator-(const random_access_iterator &iter,
-                                            const difference_type shift) {
-      return random_access_iterator{iter.ptr_ - shift};
-    }
+  friend constexpr random_access_iterator operator+(
+      const difference_type shift, const random_access_iterator &iter) {
+    return random_access_iterator{iter.ptr_ + shift};
+  }
 
-    friend difference_type operator-(const random_access_iterator &lhs,
-                                     const random_access_iterator &rhs) {
-      return static_cast<difference_type>(lhs.ptr_ - rhs.ptr_);
-    }
+  friend constexpr random_access_iterator
+  operator-(const random_access_iterator &iter, const difference_type shift) {
+    return random_access_iterator{iter.ptr_ - shift};
+  }
 
-    friend random_access_iterator operator-(
-        const difference_type shift, const random_access_iterator &iter) {
-      return random_access_iterator{iter.ptr_ - shift};
-    }
+  friend constexpr difference_type
+  operator-(const random_access_iterator &lhs,
+            const random_access_iterator &rhs) {
+    return static_cast<difference_type>(lhs.ptr_ - rhs.ptr_);
+  }
 
-    friend bool operator==(const random_access_iterator &lhs,
-                           const random_access_iterator &rhs) {
-      return lhs.ptr_ == rhs.ptr_;
-    }
+  friend constexpr random_access_iterator operator-(
+      const difference_type shift, const random_access_iterator &iter) {
+    return random_access_iterator{iter.ptr_ - shift};
+  }
+
+  friend constexpr bool operator==(const random_access_iterator &lhs,
+                                   const random_access_iterator &rhs) {
+    return lhs.ptr_ == rhs.ptr_;
+  }
+
+  friend constexpr bool operator!=(const random_access_iterator &lhs,
+                                   const random_access_iterator &rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend constexpr bool operator<(const random_access_iterator &lhs,
+                                  const random_access_iterator &rhs) {
+    return lhs.ptr_ < rhs.ptr_;
+  }
+
+  friend constexpr bool operator>(const random_access_iterator &lhs,
+                                  const random_access_iterator &rhs) {
+    return rhs.ptr_ < lhs.ptr_;
+  }
+
+  friend constexpr bool operator<=(const random_access_iterator &lhs,
+                                   const random_access_iterator &rhs) {
+    return !(lhs.ptr_ > rhs.ptr_);
+  }
+
+  friend constexpr bool operator>=(const random_access_iterator &lhs,
+                                   const random_access_iterator &rhs) {
+    return !(lhs.ptr_ < rhs.ptr_);
+  }
+
+private:
+  template <typename, bool> friend class random_access_iterator;
+
+  pointer ptr_;
+};
+
+// element-wise comparisons shared by comparison operators of containers
+template <typename Lhs, typename Rhs>
+[[nodiscard]] inline VLRX_CONSTEXPR20 bool equal_elements(const Lhs &lhs,
+                                                          const Rhs &rhs) {
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Lhs, typename Rhs>
+[[nodiscard]] inline VLRX_CONSTEXPR20 bool less_elements(const Lhs &lhs,
+                                                         const Rhs &rhs) {
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+                                      rhs.end());
+}
+
+template <std::size_t Alignment, typename T>
+[[nodiscard]] inline T *assume_aligned(T *ptr) noexcept {
+#if defined(__GNUC__)
+  return static_cast<T *>(__builtin_assume_aligned(ptr, Alignment));
+#else
+  return ptr;
+#endif
+}
+
+} // namespace detail
+
+// Tag for the constructor which builds elements from a forward range.
+struct from_range_t {
+  explicit from_range_t() = default;
+};
+
+inline constexpr from_range_t from_range{};
+
+// Tag for the constructor which builds i-th element in place from the result
+// of generator(i).
+struct from_generator_t {
+  explicit from_generator_t() = default;
+};
+
+inline constexpr from_generator_t from_generator{};
+
+// Tag for the sized constructor which default-initializes elements, hence
+// leaves trivially default constructible elements uninitialized.
+struct for_overwrite_t {
+  explicit for_overwrite_t() = default;
+};
 
-    friend bool operator!=(const random_access_iterator &lhs,
-                           const random_access_iterator &rhs) {
-      return !(lhs == rhs);
+inline constexpr for_overwrite_t for_overwrite{};
+
+// Whether objects of T may be moved to another address with memcpy, without
+// calling the move constructor and the destructor. It holds for trivially
+// copyable types and may be specialized for others, e.g. for types which
+// only own heap memory through a pointer.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// Moves count objects from first to uninitialized memory at dest and ends
+// their lifetime at first, as if each was move-constructed and destroyed.
+// Trivially relocatable objects are copied with a single memcpy. Otherwise,
+// if a move constructor throws, objects already moved to dest are destroyed
+// and all of the source objects stay alive. Ranges must not overlap.
+template <typename T>
+T *uninitialized_relocate_n(T *first, const std::size_t count, T *dest) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    if (count > 0) {
+      std::memcpy(static_cast<void *>(dest), static_cast<const void *>(first),
+                  sizeof(T) * count);
     }
+    return dest + count;
+  } else {
+    const auto last = std::uninitialized_move_n(first, count, dest).second;
+    std::destroy_n(first, count);
+    return last;
+  }
+}
+
+// Counters of allocations and copies made by heap_array, compiled in only
+// when VLRX_HEAP_ARRAY_INSTRUMENTATION is defined (the same way in every
+// translation unit). Otherwise the hooks are empty and counters stay zero.
+namespace instrumentation {
+
+#if defined(VLRX_HEAP_ARRAY_INSTRUMENTATION)
+inline constexpr bool enabled{true};
+#else
+inline constexpr bool enabled{false};
+#endif
+
+enum class event {
+  allocation,
+  deallocation,
+  copy_construction,
+  // copy assignment to an array of the same size, its buffer is kept
+  reusing_copy_assignment,
+  // copy assignment which allocated a new buffer
+  reallocating_copy_assignment,
+  move,
+};
+
+struct counters {
+  std::uint64_t allocations;
+  std::uint64_t deallocations;
+  // allocated minus deallocated bytes since the last reset
+  std::int64_t live_bytes;
+  std::uint64_t copy_constructions;
+  std::uint64_t reusing_copy_assignments;
+  std::uint64_t reallocating_copy_assignments;
+  std::uint64_t moves;
+};
+
+// Called for each event with the number of bytes it allocated, released or
+// copied, and with the innermost tag set by scoped_tag on the calling
+// thread, or nullptr.
+using observer = void (*)(event kind, std::size_t bytes, const char *tag);
+
+namespace detail {
+
+struct state {
+  std::atomic<std::uint64_t> allocations{};
+  std::atomic<std::uint64_t> deallocations{};
+  std::atomic<std::int64_t> live_bytes{};
+  std::atomic<std::uint64_t> copy_constructions{};
+  std::atomic<std::uint64_t> reusing_copy_assignments{};
+  std::atomic<std::uint64_t> reallocating_copy_assignments{};
+  std::atomic<std::uint64_t> moves{};
+  std::atomic<observer> observer_callback{};
+};
+
+inline state global_state;
+
+inline thread_local const char *current_tag{};
+
+} // namespace detail
+
+[[nodiscard]] inline counters snapshot() noexcept {
+  constexpr auto order = std::memory_order_relaxed;
+  const auto &state = detail::global_state;
+  return {state.allocations.load(order),
+          state.deallocations.load(order),
+          state.live_bytes.load(order),
+          state.copy_constructions.load(order),
+          state.reusing_copy_assignments.load(order),
+          state.reallocating_copy_assignments.load(order),
+          state.moves.load(order)};
+}
+
+inline void reset() noexcept {
+  constexpr auto order = std::memory_order_relaxed;
+  auto &state = detail::global_state;
+  state.allocations.store(0, order);
+  state.deallocations.store(0, order);
+  state.live_bytes.store(0, order);
+  state.copy_constructions.store(0, order);
+  state.reusing_copy_assignments.store(0, order);
+  state.reallocating_copy_assignments.store(0, order);
+  state.moves.store(0, order);
+}
+
+// replaces the observer, nullptr removes it
+inline void set_observer(const observer callback) noexcept {
+  detail::global_state.observer_callback.store(callback,
+                                               std::memory_order_release);
+}
+
+[[nodiscard]] inline const char *current_tag() noexcept {
+  return detail::current_tag;
+}
+
+// Attributes events on the calling thread to tag (a string which outlives
+// the scope) until the end of the scope. Scopes nest.
+class [[nodiscard]] scoped_tag final {
+public:
+  explicit scoped_tag(const char *tag) noexcept
+      : previous_{detail::current_tag} {
+    detail::current_tag = tag;
+  }
+
+  scoped_tag(const scoped_tag &) = delete;
+
+  scoped_tag &operator=(const scoped_tag &) = delete;
 
-    friend bool operator<(const random_access_iterator &lhs,
-                          const random_access_iterator &rhs) {
-      return lhs.ptr_ < rhs.ptr_;
+  ~scoped_tag() { detail::current_tag = previous_; }
+
+private:
+  const char *previous_;
+};
+
+} // namespace instrumentation
+
+namespace detail {
+
+inline VLRX_CONSTEXPR20 void
+record([[maybe_unused]] const instrumentation::event kind,
+       [[maybe_unused]] const std::size_t bytes) noexcept {
+#if defined(VLRX_HEAP_ARRAY_INSTRUMENTATION)
+  if (is_constant_evaluated()) {
+    return;
+  }
+  using instrumentation::event;
+  constexpr auto order = std::memory_order_relaxed;
+  auto &state = instrumentation::detail::global_state;
+  switch (kind) {
+  case event::allocation:
+    state.allocations.fetch_add(1, order);
+    state.live_bytes.fetch_add(static_cast<std::int64_t>(bytes), order);
+    break;
+  case event::deallocation:
+    state.deallocations.fetch_add(1, order);
+    state.live_bytes.fetch_sub(static_cast<std::int64_t>(bytes), order);
+    break;
+  case event::copy_construction:
+    state.copy_constructions.fetch_add(1, order);
+    break;
+  case event::reusing_copy_assignment:
+    state.reusing_copy_assignments.fetch_add(1, order);
+    break;
+  case event::reallocating_copy_assignment:
+    state.reallocating_copy_assignments.fetch_add(1, order);
+    break;
+  case event::move:
+    state.moves.fetch_add(1, order);
+    break;
+  }
+  if (const auto callback =
+          state.observer_callback.load(std::memory_order_acquire)) {
+    callback(kind, bytes, instrumentation::detail::current_tag);
+  }
+#endif
+}
+
+} // namespace detail
+
+class thread_executor;
+
+// Policy of parallel construction, defined in parallel_policy.hpp.
+template <typename Executor = thread_executor> class parallel_policy;
+
+// Default allocator of heap_array. It is stateless and backed by
+// malloc/calloc, so zero-initialized buffers may come directly from calloc
+// (for big sizes these are lazily zeroed pages provided by the kernel).
+// In constant expressions memory comes from std::allocator.
+template <typename T>
+class heap_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+
+  heap_allocator() noexcept = default;
+
+  template <typename U>
+  constexpr heap_allocator(const heap_allocator<U> &) noexcept {}
+
+  [[nodiscard]] VLRX_CONSTEXPR20 T *allocate(const std::size_t size) {
+    if (detail::is_constant_evaluated()) {
+      return std::allocator<T>{}.allocate(size);
     }
+    return static_cast<T *>(allocate_bytes(size, false));
+  }
 
-    friend bool operator>(const random_access_iterator &lhs,
-                          const random_access_iterator &rhs) {
-      return rhs.ptr_ < lhs.ptr_;
+  // same as allocate, but the memory is filled with zero bytes
+  [[nodiscard]] T *allocate_zeroed(const std::size_t size) {
+    return static_cast<T *>(allocate_bytes(size, true));
+  }
+
+  // Resizes the block with realloc, which keeps its contents and may extend
+  // it in place (or remap pages of big blocks). Returns nullptr when realloc
+  // fails or alignment of T exceeds the one guaranteed by malloc.
+  [[nodiscard]] T *reallocate(T *ptr, const std::size_t old_size,
+                              const std::size_t new_size) noexcept {
+    if constexpr (alignof(T) <= alignof(std::max_align_t)) {
+      if (new_size > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+        return nullptr;
+      }
+      if (auto resized =
+              std::realloc(static_cast<void *>(ptr), new_size * sizeof(T))) {
+        return static_cast<T *>(resized);
+      }
+      // a block which failed to shrink is still big enough
+      return new_size <= old_size ? ptr : nullptr;
+    } else {
+      return nullptr;
     }
+  }
 
-    friend bool operator<=(const random_access_iterator &lhs,
-                           const random_access_iterator &rhs) {
-      return !(lhs.ptr_ > rhs.ptr_);
+  VLRX_CONSTEXPR20 void deallocate(T *ptr, const std::size_t size) noexcept {
+    if (detail::is_constant_evaluated()) {
+      std::allocator<T>{}.deallocate(ptr, size);
+      return;
     }
+    std::free(ptr);
+  }
+
+  template <typename U>
+  friend constexpr bool operator==(const heap_allocator &,
+                                   const heap_allocator<U> &) noexcept {
+    return true;
+  }
 
-    friend bool operator>=(const random_access_iterator &lhs,
-                           const random_access_iterator &rhs) {
-      return !(lhs.ptr_ < rhs.ptr_);
+  template <typename U>
+  friend constexpr bool operator!=(const heap_allocator &,
+                                   const heap_allocator<U> &) noexcept {
+    return false;
+  }
+
+private:
+  static void *allocate_bytes(const std::size_t size, const bool zeroed) {
+    if (size > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    void *ptr{};
+    if constexpr (alignof(T) <= alignof(std::max_align_t)) {
+      ptr = zeroed ? std::calloc(size, sizeof(T))
+                   : std::malloc(size * sizeof(T));
+    } else {
+      // aligned_alloc requires size to be a multiple of alignment
+      const auto bytes =
+          (size * sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+      ptr = std::aligned_alloc(alignof(T), bytes);
+      if (ptr != nullptr && zeroed) {
+        std::memset(ptr, 0, bytes);
+      }
     }
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+};
+
+// Storage layout where elements are aligned as required by their type and
+// there is no padding after the last element.
+struct natural_layout {
+  template <typename T> static constexpr std::size_t alignment = alignof(T);
+  static constexpr bool size_in_header = false;
+};
+
+// Storage layout where the buffer is aligned to Alignment bytes (or more if
+// type requires) and its size is rounded up to a multiple of the alignment,
+// so vector loads of Alignment bytes never read past the buffer. Padding
+// bytes after the last element are zeroed.
+template <std::size_t Alignment> struct aligned_layout {
+  static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of two");
+
+  template <typename T>
+  static constexpr std::size_t alignment = std::max(Alignment, alignof(T));
+  static constexpr bool size_in_header = false;
+};
+
+inline constexpr std::size_t cache_line_size{64};
 
-  private:
-    friend heap_array<value_type>;
+using cache_line_layout = aligned_layout<cache_line_size>;
 
-    explicit random_access_iterator(const pointer ptr) noexcept : ptr_{ptr} {}
+// Layout where the container is a single pointer: size is stored in a header
+// in front of the elements in the heap buffer, and empty container holds
+// nullptr. Alignment and padding are the same as of BaseLayout.
+template <typename BaseLayout = natural_layout> struct compact_layout {
+  template <typename T>
+  static constexpr std::size_t alignment =
+      BaseLayout::template alignment<T>;
+  static constexpr bool size_in_header = true;
+};
 
-    pointer ptr_;
-  };
+template <typename T, typename SizeType = std::uint64_t,
+          typename Allocator = heap_allocator<T>,
+          typename Layout = natural_layout>
+class heap_array final
+    : private detail::allocator_holder<Allocator>,
+      private detail::size_holder<SizeType, !Layout::size_in_header> {
+  static_assert(std::is_same_v<typename Allocator::value_type, T>,
+                "Allocator::value_type must be the same as T");
 
 public:
   using value_type = T;
   using size_type = SizeType;
+  using allocator_type = Allocator;
   using reference = value_type &;
   using const_reference = const value_type &;
   using pointer = value_type *;
   using const_pointer = const T *;
-  using iterator = random_access_iterator<false>;
-  using const_iterator = random_access_iterator<true>;
+  using iterator = detail::random_access_iterator<value_type, false>;
+  using const_iterator = detail::random_access_iterator<value_type, true>;
   using reverse_iterator = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using layout_type = Layout;
+
+  // guaranteed alignment of data()
+  static constexpr std::size_t alignment =
+      Layout::template alignment<value_type>;
+  // whether the container is a single pointer, with size stored in front of
+  // the elements in the heap buffer
+  static constexpr bool size_in_header = Layout::size_in_header;
+
+  VLRX_CONSTEXPR20 heap_array() noexcept(noexcept(allocator_type()))
+      : heap_array(allocator_type()) {}
+
+  VLRX_CONSTEXPR20 explicit heap_array(const allocator_type &alloc) noexcept
+      : allocator_base{alloc}, storage_{} {}
+
+  // value-initializes size elements
+  VLRX_CONSTEXPR20 explicit heap_array(
+      const size_type size, const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    if constexpr (detail::is_zero_initializable_v<value_type>) {
+      set_up_storage(allocate_zeroed_buffer(size), size);
+    } else {
+      auto buffer = allocate_buffer(size);
+      try {
+        construct_each(buffer, size);
+      } catch (...) {
+        deallocate_buffer(buffer, size);
+        throw;
+      }
+      set_up_storage(buffer, size);
+    }
+  }
+
+  VLRX_CONSTEXPR20 heap_array(const size_type size, const value_type &value,
+                              const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    auto buffer = allocate_buffer(size);
+    try {
+      construct_each(buffer, size, value);
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    set_up_storage(buffer, size);
+  }
 
-  heap_array(std::initializer_list<value_type> init) : storage_{}, size_{} {
+  // default-initializes size elements, trivially default constructible
+  // elements are left uninitialized
+  VLRX_CONSTEXPR20 heap_array(const size_type size, for_overwrite_t,
+                              const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    auto buffer = allocate_buffer(size);
+    if (detail::is_constant_evaluated()) {
+      // constant expressions may not leave elements uninitialized
+      try {
+        construct_each(buffer, size);
+      } catch (...) {
+        deallocate_buffer(buffer, size);
+        throw;
+      }
+    } else if constexpr (!std::is_trivially_default_constructible_v<
+                             value_type>) {
+      size_type idx{};
+      try {
+        for (; idx < size; ++idx) {
+          ::new (static_cast<void *>(buffer + idx)) value_type;
+        }
+      } catch (...) {
+        destroy_range(buffer, idx);
+        deallocate_buffer(buffer, size);
+        throw;
+      }
+    }
+    set_up_storage(buffer, size);
+  }
+
+  // builds i-th element in place from generator(i), no temporaries are
+  // created unless allocator customizes construct
+  template <typename Generator>
+  VLRX_CONSTEXPR20 heap_array(const size_type size, from_generator_t,
+                              Generator &&generator,
+                              const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    auto buffer = allocate_buffer(size);
+    try {
+      generate_range(buffer, 0, size, generator);
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    set_up_storage(buffer, size);
+  }
+
+  // Parallel counterparts of the constructors above, elements are built in
+  // chunks of whole pages by the tasks of policy (see parallel_policy.hpp).
+  // The generator is called concurrently.
+  template <typename Executor>
+  heap_array(const size_type size, const parallel_policy<Executor> &policy,
+             const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    auto buffer = allocate_placed_buffer(size, policy);
+    try {
+      construct_in_parallel(
+          buffer, size, policy,
+          [&](const size_type first, const size_type last) {
+            if constexpr (detail::is_zero_initializable_v<value_type>) {
+              std::memset(static_cast<void *>(buffer + first), 0,
+                          sizeof(storage_type) * (last - first));
+            } else {
+              construct_each(buffer + first, last - first);
+            }
+          });
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    set_up_storage(buffer, size);
+  }
+
+  template <typename Executor>
+  heap_array(const size_type size, const value_type &value,
+             const parallel_policy<Executor> &policy,
+             const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    auto buffer = allocate_placed_buffer(size, policy);
+    try {
+      construct_in_parallel(
+          buffer, size, policy,
+          [&](const size_type first, const size_type last) {
+            construct_each(buffer + first, last - first, value);
+          });
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    set_up_storage(buffer, size);
+  }
+
+  template <typename Generator, typename Executor>
+  heap_array(const size_type size, from_generator_t, Generator &&generator,
+             const parallel_policy<Executor> &policy,
+             const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    auto buffer = allocate_placed_buffer(size, policy);
+    try {
+      construct_in_parallel(
+          buffer, size, policy,
+          [&](const size_type first, const size_type last) {
+            generate_range(buffer, first, last, generator);
+          });
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    set_up_storage(buffer, size);
+  }
+
+  // elements are constructed from *iter, so std::move_iterator may be used
+  // to move them from the source
+  template <typename ForwardIt,
+            typename std::enable_if_t<detail::is_forward_iterator_v<ForwardIt>,
+                                      int> = 1>
+  VLRX_CONSTEXPR20 heap_array(ForwardIt first, ForwardIt last,
+                              const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
+    const auto distance = std::distance(first, last);
+    assert(distance >= 0 &&
+           static_cast<std::make_unsigned_t<decltype(distance)>>(distance) <=
+               std::numeric_limits<size_type>::max());
+    const auto size = static_cast<size_type>(distance);
+    auto buffer = allocate_buffer(size);
+    try {
+      fill_buffer(first, buffer, size);
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    set_up_storage(buffer, size);
+  }
+
+  template <typename ForwardRange>
+  VLRX_CONSTEXPR20 heap_array(from_range_t, ForwardRange &&range,
+                              const allocator_type &alloc = allocator_type())
+      : heap_array(std::begin(range), std::end(range), alloc) {}
+
+  VLRX_CONSTEXPR20 heap_array(std::initializer_list<value_type> init,
+                              const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, storage_{} {
     assert(init.size() <= std::numeric_limits<size_type>::max());
     auto buffer = allocate_buffer(static_cast<size_type>(init.size()));
     try {
       fill_buffer(init.begin(), buffer, static_cast<size_type>(init.size()));
     } catch (...) {
-      delete[] buffer;
+      deallocate_buffer(buffer, static_cast<size_type>(init.size()));
       throw;
     }
     set_up_storage(buffer, static_cast<size_type>(init.size()));
   }
 
-  heap_array(const heap_array &other) : storage_{}, size_{} {
-    auto buffer = allocate_buffer(other.size_);
+  VLRX_CONSTEXPR20 heap_array(const heap_array &other)
+      : heap_array(other, alloc_traits::select_on_container_copy_construction(
+                              other.get_allocator_ref())) {}
+
+  VLRX_CONSTEXPR20 heap_array(const heap_array &other,
+                              const allocator_type &alloc)
+      : allocator_base{alloc}, storage_{} {
+    copy_into_empty(other);
+    detail::record(instrumentation::event::copy_construction,
+                   element_bytes());
+  }
+
+  template <typename Executor>
+  heap_array(const heap_array &other, const parallel_policy<Executor> &policy)
+      : allocator_base{alloc_traits::select_on_container_copy_construction(
+            other.get_allocator_ref())},
+        storage_{} {
+    auto buffer = allocate_placed_buffer(other.size(), policy);
     try {
-      fill_buffer(other.begin(), buffer, other.size_);
+      construct_in_parallel(
+          buffer, other.size(), policy,
+          [&](const size_type first, const size_type last) {
+            if constexpr (is_bitwise_copy_constructible) {
+              std::memcpy(static_cast<void *>(buffer + first),
+                          static_cast<const void *>(other.storage_ + first),
+                          sizeof(storage_type) * (last - first));
+            } else {
+              fill_buffer(other.data() + first, buffer + first, last - first);
+            }
+          });
     } catch (...) {
-      delete[] buffer;
+      deallocate_buffer(buffer, other.size());
       throw;
     }
-    set_up_storage(buffer, other.size_);
+    set_up_storage(buffer, other.size());
+    detail::record(instrumentation::event::copy_construction,
+                   element_bytes());
   }
 
-  heap_array &operator=(const heap_array &other) {
-    if (other.size_ != size_) {
-      auto buffer = allocate_buffer(other.size_);
+  VLRX_CONSTEXPR20 heap_array &operator=(const heap_array &other) {
+    if (this == &other) {
+      return *this;
+    }
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value &&
+                  !alloc_traits::is_always_equal::value) {
+      if (get_allocator_ref() != other.get_allocator_ref()) {
+        // our buffer can not be reused, as it has to be released by our
+        // allocator, so build the copy with the new one and swap both
+        heap_array copy{other.get_allocator_ref()};
+        copy.copy_into_empty(other);
+        swap_storage(copy);
+        swap_allocators(copy);
+        detail::record(instrumentation::event::reallocating_copy_assignment,
+                       element_bytes());
+        return *this;
+      }
+    }
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value) {
+      get_allocator_ref() = other.get_allocator_ref();
+    }
+    if (other.size() != size()) {
+      auto buffer = allocate_buffer(other.size());
       try {
-        fill_buffer(other.begin(), buffer, other.size_);
+        copy_construct_buffer(other, buffer);
       } catch (...) {
-        delete[] buffer;
+        deallocate_buffer(buffer, other.size());
         throw;
       }
       destroy_stored_objects();
       deallocate_storage();
-      set_up_storage(buffer, other.size_);
+      set_up_storage(buffer, other.size());
+      detail::record(instrumentation::event::reallocating_copy_assignment,
+                     element_bytes());
+      return *this;
+    }
+    if (std::is_trivially_copy_assignable_v<value_type> &&
+        !detail::is_constant_evaluated()) {
+      if (size() > 0) {
+        std::memcpy(static_cast<void *>(storage_),
+                    static_cast<const void *>(other.storage_),
+                    sizeof(storage_type) * size());
+      }
     } else {
       [[maybe_unused]] auto res =
-          std::copy(other.begin(), other.end(), begin());
+          std::copy(other.data(), other.data() + other.size(), data());
     }
+    detail::record(instrumentation::event::reusing_copy_assignment,
+                   element_bytes());
     return *this;
   }
 
-  heap_array(heap_array &&other) : storage_{}, size_{} {
-    size_ = static_cast<size_type>(other.size_);
-    storage_ = other.storage_;
-    other.size_ = 0;
-    other.storage_ = nullptr;
+  VLRX_CONSTEXPR20 heap_array(heap_array &&other) noexcept
+      : allocator_base{std::move(other.get_allocator_ref())}, storage_{} {
+    set_up_storage(other.storage_, other.size());
+    other.set_up_storage(nullptr, 0);
+    detail::record(instrumentation::event::move, element_bytes());
   }
 
-  heap_array<value_type, size_type> &operator=(heap_array &&other) {
+  // elements are moved one by one into a new buffer when alloc is not equal
+  // to the allocator of other
+  VLRX_CONSTEXPR20 heap_array(heap_array &&other,
+                              const allocator_type &alloc) noexcept(
+      alloc_traits::is_always_equal::value)
+      : allocator_base{alloc}, storage_{} {
+    if constexpr (!alloc_traits::is_always_equal::value) {
+      if (get_allocator_ref() != other.get_allocator_ref()) {
+        auto buffer = allocate_buffer(other.size());
+        try {
+          fill_buffer(std::make_move_iterator(other.begin()), buffer,
+                      other.size());
+        } catch (...) {
+          deallocate_buffer(buffer, other.size());
+          throw;
+        }
+        set_up_storage(buffer, other.size());
+        detail::record(instrumentation::event::move, element_bytes());
+        return;
+      }
+    }
+    set_up_storage(other.storage_, other.size());
+    other.set_up_storage(nullptr, 0);
+    detail::record(instrumentation::event::move, element_bytes());
+  }
+
+  VLRX_CONSTEXPR20 heap_array &operator=(heap_array &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
+    if constexpr (!alloc_traits::propagate_on_container_move_assignment::
+                      value &&
+                  !alloc_traits::is_always_equal::value) {
+      if (get_allocator_ref() != other.get_allocator_ref()) {
+        // buffer of other can not be released by our allocator, hence
+        // elements are moved one by one
+        if (other.size() != size()) {
+          auto buffer = allocate_buffer(other.size());
+          try {
+            fill_buffer(std::make_move_iterator(other.begin()), buffer,
+                        other.size());
+          } catch (...) {
+            deallocate_buffer(buffer, other.size());
+            throw;
+          }
+          destroy_stored_objects();
+          deallocate_storage();
+          set_up_storage(buffer, other.size());
+        } else {
+          [[maybe_unused]] auto res =
+              std::move(other.begin(), other.end(), begin());
+        }
+        detail::record(instrumentation::event::move, element_bytes());
+        return *this;
+      }
+    }
     destroy_stored_objects();
     deallocate_storage();
-    size_ = static_cast<size_type>(other.size_);
-    storage_ = other.storage_;
-    other.size_ = 0;
-    other.storage_ = nullptr;
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                      value) {
+      get_allocator_ref() = std::move(other.get_allocator_ref());
+    }
+    set_up_storage(other.storage_, other.size());
+    other.set_up_storage(nullptr, 0);
+    detail::record(instrumentation::event::move, element_bytes());
     return *this;
   }
 
-  [[nodiscard]] const_reference at(const size_type pos) const {
-    if (pos >= size_) {
+  [[nodiscard]] VLRX_CONSTEXPR20 allocator_type get_allocator() const noexcept {
+    return get_allocator_ref();
+  }
+
+  [[nodiscard]] VLRX_CONSTEXPR20 const_reference at(const size_type pos) const {
+    if (pos >= size()) {
       throw std::out_of_range("Trying to access element which is out of range");
     }
     return *to_value_type_pointer(storage_ + pos);
   }
 
-      [[nodiscard]] reference at(const size_type pos) {
-    if (pos >= size_) {
+  [[nodiscard]] VLRX_CONSTEXPR20 reference at(const size_type pos) {
+    if (pos >= size()) {
       throw std::out_of_range("Trying to access element which is out of range");
     }
     return *to_value_type_pointer(storage_ + pos);
   }
 
-  [[nodiscard]] const_reference operator[](const size_type pos) const noexcept {
-    assert(pos < size_);
+  [[nodiscard]] VLRX_CONSTEXPR20 const_reference
+  operator[](const size_type pos) const noexcept {
+    assert(pos < size());
     return *to_value_type_pointer(storage_ + pos);
   }
 
-  [[nodiscard]] reference operator[](const size_type pos) noexcept {
-    assert(pos < size_);
+  [[nodiscard]] VLRX_CONSTEXPR20 reference
+  operator[](const size_type pos) noexcept {
+    assert(pos < size());
     return *to_value_type_pointer(storage_ + pos);
   }
 
-  [[nodiscard]] reference front() noexcept {
+  [[nodiscard]] VLRX_CONSTEXPR20 reference front() noexcept {
     return *to_value_type_pointer(storage_);
   }
 
-  [[nodiscard]] const_reference front() const noexcept {
+  [[nodiscard]] VLRX_CONSTEXPR20 const_reference front() const noexcept {
     return *to_value_type_pointer(storage_);
   }
 
-  [[nodiscard]] reference back() noexcept {
-    return *to_value_type_pointer(storage_ + size_ - 1);
+  [[nodiscard]] VLRX_CONSTEXPR20 reference back() noexcept {
+    return *to_value_type_pointer(storage_ + size() - 1);
   }
 
-  [[nodiscard]] const_reference back() const noexcept {
-    return *to_value_type_pointer(storage_ + size_ - 1);
+  [[nodiscard]] VLRX_CONSTEXPR20 const_reference back() const noexcept {
+    return *to_value_type_pointer(storage_ + size() - 1);
   }
 
-  [[nodiscard]] pointer data() noexcept {
+  [[nodiscard]] VLRX_CONSTEXPR20 pointer data() noexcept {
     return to_value_type_pointer(storage_);
   }
 
-  [[nodiscard]] const_pointer data() const noexcept {
+  [[nodiscard]] VLRX_CONSTEXPR20 const_pointer data() const noexcept {
     return to_value_type_pointer(storage_);
   }
 
-  iterator begin() noexcept {
+  // same as data(), but lets compiler know the pointer is aligned to
+  // alignment bytes, so loops over it are vectorized without peeling
+  [[nodiscard]] pointer aligned_data() noexcept {
+    return detail::assume_aligned<alignment>(data());
+  }
+
+  [[nodiscard]] const_pointer aligned_data() const noexcept {
+    return detail::assume_aligned<alignment>(data());
+  }
+
+  // number of elements which fit into the allocated buffer, elements past
+  // size() are zero bytes which may be only read (e.g. by vector loads of
+  // trivially copyable types)
+  [[nodiscard]] size_type padded_size() const noexcept {
+    if (empty()) {
+      return 0;
+    }
+    return static_cast<size_type>(
+        (block_count(size()) * sizeof(block_type) - header_bytes) /
+        sizeof(storage_type));
+  }
+
+  VLRX_CONSTEXPR20 iterator begin() noexcept {
     return iterator{to_value_type_pointer(storage_)};
   }
 
-  const_iterator begin() const noexcept {
+  VLRX_CONSTEXPR20 const_iterator begin() const noexcept {
     return const_iterator{to_value_type_pointer(storage_)};
   }
 
-  const_iterator cbegin() const noexcept {
+  VLRX_CONSTEXPR20 const_iterator cbegin() const noexcept {
     return const_iterator{to_value_type_pointer(storage_)};
   }
 
-  reverse_iterator rbegin() noexcept {
-    return reverse_iterator{iterator{to_value_type_pointer(storage_ + size_)}};
+  VLRX_CONSTEXPR20 reverse_iterator rbegin() noexcept {
+    return reverse_iterator{
+        iterator{to_value_type_pointer(storage_ + size())}};
   }
 
-  const_reverse_iterator rbegin() const noexcept {
+  VLRX_CONSTEXPR20 const_reverse_iterator rbegin() const noexcept {
     return const_reverse_iterator{
-        const_iterator{to_value_type_pointer(storage_ + size_)}};
+        const_iterator{to_value_type_pointer(storage_ + size())}};
   }
 
-  const_reverse_iterator crbegin() const noexcept {
+  VLRX_CONSTEXPR20 const_reverse_iterator crbegin() const noexcept {
     return const_reverse_iterator{
-        const_iterator{to_value_type_pointer(storage_ + size_)}};
+        const_iterator{to_value_type_pointer(storage_ + size())}};
   }
 
-  iterator end() noexcept {
-    return iterator{to_value_type_pointer(storage_ + size_)};
+  VLRX_CONSTEXPR20 iterator end() noexcept {
+    return iterator{to_value_type_pointer(storage_ + size())};
   }
 
-  const_iterator end() const noexcept {
-    return const_iterator{to_value_type_pointer(storage_ + size_)};
+  VLRX_CONSTEXPR20 const_iterator end() const noexcept {
+    return const_iterator{to_value_type_pointer(storage_ + size())};
   }
 
-  const_iterator cend() const noexcept {
-    return const_iterator{to_value_type_pointer(storage_ + size_)};
+  VLRX_CONSTEXPR20 const_iterator cend() const noexcept {
+    return const_iterator{to_value_type_pointer(storage_ + size())};
   }
 
-  reverse_iterator rend() noexcept {
+  VLRX_CONSTEXPR20 reverse_iterator rend() noexcept {
     return reverse_iterator{iterator{to_value_type_pointer(storage_)}};
   }
 
-  const_reverse_iterator rend() const noexcept {
+  VLRX_CONSTEXPR20 const_reverse_iterator rend() const noexcept {
     return const_reverse_iterator{
         const_iterator{to_value_type_pointer(storage_)}};
   }
 
-  const_reverse_iterator crend() const noexcept {
+  VLRX_CONSTEXPR20 const_reverse_iterator crend() const noexcept {
     return const_reverse_iterator{
         const_iterator{to_value_type_pointer(storage_)}};
   }
 
-  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] VLRX_CONSTEXPR20 bool empty() const noexcept {
+    if constexpr (size_in_header) {
+      return storage_ == nullptr;
+    } else {
+      return size() == 0;
+    }
+  }
+
+  [[nodiscard]] VLRX_CONSTEXPR20 size_type size() const noexcept {
+    if constexpr (size_in_header) {
+      return storage_ == nullptr ? 0 : *header_pointer(storage_);
+    } else {
+      return size_base::held_size();
+    }
+  }
 
-  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] VLRX_CONSTEXPR20 size_type max_size() const noexcept {
+    return size();
+  }
 
-  [[nodiscard]] size_type max_size() const noexcept { return size_; }
+  // Changes the number of elements to new_size, the first elements are kept
+  // and added ones are value-initialized (arrays of types which are not
+  // default constructible may only shrink, growing them throws). Trivially
+  // relocatable elements are moved bitwise, and when allocator provides
+  // reallocate the buffer is resized in place or by remapping its pages
+  // instead of copying (realloc for heap_allocator, mremap for
+  // mmap_allocator). Other elements are move-constructed into a new buffer,
+  // or copied if their move constructor may throw. Returns whether elements
+  // moved to another address, the array is unchanged if an exception is
+  // thrown.
+  bool reallocate(const size_type new_size) {
+    return reallocate_storage<false>(new_size);
+  }
 
-  void swap(heap_array &other) {
-    const auto temp_storage = storage_;
-    const auto temp_size = size_;
-    storage_ = other.storage_;
-    size_ = other.size_;
-    other.size_ = temp_size;
-    other.storage_ = temp_storage;
+  // same as above, but added elements are default-initialized, so trivially
+  // default constructible ones are left uninitialized
+  bool reallocate(const size_type new_size, for_overwrite_t) {
+    return reallocate_storage<true>(new_size);
   }
 
-  ~heap_array() {
-    if constexpr (std::is_trivially_destructible_v<value_type> == false) {
-      destroy_stored_objects();
+  VLRX_CONSTEXPR20 void swap(heap_array &other) noexcept {
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      swap_allocators(other);
+    } else {
+      assert(get_allocator_ref() == other.get_allocator_ref());
     }
+    swap_storage(other);
+  }
+
+  // destroys elements in chunks run by policy and releases the buffer, the
+  // array becomes empty
+  template <typename Executor>
+  void reset(const parallel_policy<Executor> &policy) {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      policy.for_each_chunk(
+          storage_, static_cast<std::size_t>(size()), sizeof(storage_type),
+          [&](const std::size_t first, const std::size_t last) {
+            destroy_range(storage_ + first,
+                          static_cast<size_type>(last - first));
+          },
+          [](std::size_t, std::size_t) {});
+    }
+    deallocate_storage();
+  }
+
+  VLRX_CONSTEXPR20 ~heap_array() {
+    destroy_stored_objects();
     deallocate_storage();
   }
 
-  template <typename VType, typename SType>
-  friend void swap(heap_array<VType, SType> &lhs,
-                   heap_array<VType, SType> &rhs);
-  template <typename VType, typename SType>
-  friend bool operator==(const heap_array<VType, SType> &lhs,
-                         const heap_array<VType, SType> &rhs);
-  template <typename VType, typename SType>
-  friend bool operator!=(const heap_array<VType, SType> &lhs,
-                         const heap_array<VType, SType> &rhs);
-  template <typename VType, typename SType>
-  friend bool operator<(const heap_array<VType, SType> &lhs,
-                        const heap_array<VType, SType> &rhs);
-  template <typename VType, typename SType>
-  friend bool operator>(const heap_array<VType, SType> &lhs,
-                        const heap_array<VType, SType> &rhs);
-  template <typename VType, typename SType>
-  friend bool operator<=(const heap_array<VType, SType> &lhs,
-                         const heap_array<VType, SType> &rhs);
-  template <typename VType, typename SType>
-  friend bool operator>=(const heap_array<VType, SType> &lhs,
-                         const heap_array<VType, SType> &rhs);
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 void
+  swap(heap_array<VType, SType, Alloc, LType> &lhs,
+       heap_array<VType, SType, Alloc, LType> &rhs) noexcept;
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 bool
+  operator==(const heap_array<VType, SType, Alloc, LType> &lhs,
+             const heap_array<VType, SType, Alloc, LType> &rhs);
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 bool
+  operator!=(const heap_array<VType, SType, Alloc, LType> &lhs,
+             const heap_array<VType, SType, Alloc, LType> &rhs);
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 bool
+  operator<(const heap_array<VType, SType, Alloc, LType> &lhs,
+            const heap_array<VType, SType, Alloc, LType> &rhs);
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 bool
+  operator>(const heap_array<VType, SType, Alloc, LType> &lhs,
+            const heap_array<VType, SType, Alloc, LType> &rhs);
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 bool
+  operator<=(const heap_array<VType, SType, Alloc, LType> &lhs,
+             const heap_array<VType, SType, Alloc, LType> &rhs);
+  template <typename VType, typename SType, typename Alloc, typename LType>
+  friend VLRX_CONSTEXPR20 bool
+  operator>=(const heap_array<VType, SType, Alloc, LType> &lhs,
+             const heap_array<VType, SType, Alloc, LType> &rhs);
 
 private:
-  using storage_type = typename std::aligned_storage<sizeof(value_type),
-                                                     alignof(value_type)>::type;
+  using allocator_base = detail::allocator_holder<allocator_type>;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+  // elements live in memory allocated for value_type, as in std::vector,
+  // so they may be created in constant expressions
+  using storage_type = value_type;
+  using size_base = detail::size_holder<size_type, !size_in_header>;
+
+  // compact layouts keep size in the header in front of the elements
+  static constexpr std::size_t header_bytes =
+      size_in_header
+          ? (sizeof(size_type) + alignment - 1) / alignment * alignment
+          : 0;
+  static constexpr std::size_t block_alignment =
+      size_in_header ? std::max(alignment, alignof(size_type)) : alignment;
+
+  // unit of allocation, the buffer consists of whole blocks
+  using block_type = std::conditional_t<
+      block_alignment == alignof(value_type) && header_bytes == 0,
+      storage_type,
+      typename std::aligned_storage<block_alignment, block_alignment>::type>;
+  using storage_allocator_type =
+      typename alloc_traits::template rebind_alloc<block_type>;
+  using storage_traits = std::allocator_traits<storage_allocator_type>;
+
+  static_assert(std::is_same_v<typename storage_traits::pointer, block_type *>,
+                "Allocators with fancy pointers are not supported");
+
+  using allocator_base::get_allocator_ref;
+
   storage_type *storage_;
-  size_type size_;
 
-  pointer to_value_type_pointer(storage_type *storage_pointer) {
-    return std::launder(reinterpret_cast<value_type *>(storage_pointer));
+  VLRX_CONSTEXPR20 pointer
+  to_value_type_pointer(storage_type *storage_pointer) {
+    if (detail::is_constant_evaluated()) {
+      return storage_pointer;
+    }
+    return std::launder(storage_pointer);
+  }
+
+  VLRX_CONSTEXPR20 const_pointer
+  to_value_type_pointer(storage_type *storage_pointer) const {
+    if (detail::is_constant_evaluated()) {
+      return storage_pointer;
+    }
+    return std::launder(storage_pointer);
   }
 
-  const_pointer to_value_type_pointer(storage_type *storage_pointer) const {
-    return std::launder(reinterpret_cast<value_type *>(storage_pointer));
+  // bytes taken by elements, reported by instrumentation
+  [[nodiscard]] constexpr std::size_t element_bytes() const noexcept {
+    return sizeof(value_type) * static_cast<std::size_t>(size());
   }
 
-  void destroy_stored_objects() noexcept {
-    for (size_type i{}; i < size_; ++i) {
-      to_value_type_pointer(storage_ + i)->~value_type();
+  VLRX_CONSTEXPR20 void destroy_stored_objects() noexcept {
+    destroy_range(storage_, size());
+  }
+
+  VLRX_CONSTEXPR20 void destroy_range(storage_type *storage,
+                                      const size_type size) noexcept {
+    if constexpr (std::is_trivially_destructible_v<value_type> == false) {
+      for (size_type i{}; i < size; ++i) {
+        alloc_traits::destroy(get_allocator_ref(),
+                              to_value_type_pointer(storage + i));
+      }
     }
   }
 
-  void deallocate_storage() noexcept {
-    delete[] storage_;
-    size_ = 0;
-    storage_ = nullptr;
+  VLRX_CONSTEXPR20 void deallocate_storage() noexcept {
+    deallocate_buffer(storage_, size());
+    set_up_storage(nullptr, 0);
   }
 
-  void set_up_storage(storage_type *buffer, const size_type size) noexcept {
+  // in compact layouts size is already written to the header of the buffer
+  constexpr void set_up_storage(storage_type *buffer,
+                                const size_type size) noexcept {
     storage_ = buffer;
-    size_ = size;
+    size_base::hold_size(size);
+  }
+
+  constexpr void swap_storage(heap_array &other) noexcept {
+    const auto temp_storage = storage_;
+    const auto temp_size = size();
+    set_up_storage(other.storage_, other.size());
+    other.set_up_storage(temp_storage, temp_size);
+  }
+
+  VLRX_CONSTEXPR20 void swap_allocators(heap_array &other) noexcept {
+    using std::swap;
+    swap(get_allocator_ref(), other.get_allocator_ref());
+  }
+
+  [[nodiscard]] static constexpr std::size_t block_count(
+      const size_type size) noexcept {
+    return (header_bytes +
+            static_cast<std::size_t>(size) * sizeof(storage_type) +
+            sizeof(block_type) - 1) /
+           sizeof(block_type);
   }
 
-  [[nodiscard]] storage_type *allocate_buffer(const size_type size) {
+  [[nodiscard]] static size_type *header_pointer(
+      storage_type *buffer) noexcept {
+    return std::launder(reinterpret_cast<size_type *>(
+        reinterpret_cast<unsigned char *>(buffer) - sizeof(size_type)));
+  }
+
+  // elements start right after the header, size is stored in its last bytes
+  [[nodiscard]] static constexpr storage_type *
+  set_up_blocks(block_type *blocks, const size_type size) noexcept {
+    if constexpr (std::is_same_v<block_type, storage_type>) {
+      return blocks;
+    } else {
+      const auto buffer = reinterpret_cast<storage_type *>(
+          reinterpret_cast<unsigned char *>(blocks) + header_bytes);
+      if constexpr (size_in_header) {
+        ::new (static_cast<void *>(reinterpret_cast<unsigned char *>(buffer) -
+                                   sizeof(size_type))) size_type(size);
+      }
+      return buffer;
+    }
+  }
+
+  [[nodiscard]] static constexpr block_type *
+  blocks_of(storage_type *buffer) noexcept {
+    if constexpr (std::is_same_v<block_type, storage_type>) {
+      return buffer;
+    } else {
+      return reinterpret_cast<block_type *>(
+          reinterpret_cast<unsigned char *>(buffer) - header_bytes);
+    }
+  }
+
+  // padding after the last element of buffer is filled with zero bytes
+  static VLRX_CONSTEXPR20 void zero_padding(storage_type *buffer,
+                                            const size_type size) noexcept {
+    if constexpr (sizeof(block_type) != sizeof(storage_type)) {
+      const auto used_bytes = header_bytes + sizeof(storage_type) * size;
+      std::memset(reinterpret_cast<unsigned char *>(blocks_of(buffer)) +
+                      used_bytes,
+                  0, block_count(size) * sizeof(block_type) - used_bytes);
+    }
+  }
+
+  [[nodiscard]] VLRX_CONSTEXPR20 storage_type *
+  allocate_buffer(const size_type size) {
     storage_type *buffer{};
     if (size > 0) {
-      buffer = new storage_type[size];
+      storage_allocator_type storage_allocator{get_allocator_ref()};
+      buffer = set_up_blocks(
+          storage_traits::allocate(storage_allocator, block_count(size)), size);
+      detail::record(instrumentation::event::allocation,
+                     sizeof(block_type) * block_count(size));
+      zero_padding(buffer, size);
+    }
+    return buffer;
+  }
+
+  // buffer filled with zero bytes, calloc-like allocation is used when
+  // allocator supports it (in constant expressions elements are value
+  // initialized one by one instead)
+  [[nodiscard]] VLRX_CONSTEXPR20 storage_type *
+  allocate_zeroed_buffer(const size_type size) {
+    storage_type *buffer{};
+    if (detail::is_constant_evaluated()) {
+      buffer = allocate_buffer(size);
+      construct_each(buffer, size);
+    } else if (size > 0) {
+      storage_allocator_type storage_allocator{get_allocator_ref()};
+      block_type *blocks{};
+      if constexpr (detail::has_allocate_zeroed<
+                        storage_allocator_type>::value) {
+        blocks = storage_allocator.allocate_zeroed(block_count(size));
+      } else {
+        blocks = storage_traits::allocate(storage_allocator, block_count(size));
+        std::memset(static_cast<void *>(blocks), 0,
+                    sizeof(block_type) * block_count(size));
+      }
+      buffer = set_up_blocks(blocks, size);
+      detail::record(instrumentation::event::allocation,
+                     sizeof(block_type) * block_count(size));
     }
     return buffer;
   }
 
+  VLRX_CONSTEXPR20 void deallocate_buffer(storage_type *buffer,
+                                          const size_type size) noexcept {
+    if (buffer != nullptr) {
+      storage_allocator_type storage_allocator{get_allocator_ref()};
+      storage_traits::deallocate(storage_allocator, blocks_of(buffer),
+                                 block_count(size));
+      detail::record(instrumentation::event::deallocation,
+                     sizeof(block_type) * block_count(size));
+    }
+  }
+
+  // elements of trivially copyable types are copied with memcpy, unless
+  // allocator customizes construct
+  static constexpr bool is_bitwise_copy_constructible =
+      std::is_trivially_copy_constructible_v<value_type> &&
+      detail::uses_default_construct_v<allocator_type, value_type,
+                                       const value_type &>;
+
+  // gives an empty array a copy of elements of other, records no event
+  VLRX_CONSTEXPR20 void copy_into_empty(const heap_array &other) {
+    auto buffer = allocate_buffer(other.size());
+    try {
+      copy_construct_buffer(other, buffer);
+    } catch (...) {
+      deallocate_buffer(buffer, other.size());
+      throw;
+    }
+    set_up_storage(buffer, other.size());
+  }
+
+  VLRX_CONSTEXPR20 void copy_construct_buffer(const heap_array &other,
+                                              storage_type *storage) {
+    if constexpr (is_bitwise_copy_constructible) {
+      if (!detail::is_constant_evaluated()) {
+        if (other.size() > 0) {
+          std::memcpy(static_cast<void *>(storage),
+                      static_cast<const void *>(other.storage_),
+                      sizeof(storage_type) * other.size());
+        }
+        return;
+      }
+    }
+    fill_buffer(other.data(), storage, other.size());
+  }
+
+  // whether elements added by reallocate are built without exceptions
+  template <bool overwrite>
+  static constexpr bool is_nothrow_tail_constructible =
+      overwrite ? std::is_nothrow_default_constructible_v<value_type>
+                : detail::is_zero_initializable_v<value_type> ||
+                      (std::is_nothrow_default_constructible_v<value_type> &&
+                       detail::uses_default_construct_v<allocator_type,
+                                                        value_type>);
+
+  // builds elements [first, last) added by reallocate, they are destroyed
+  // if any of constructors throws
+  template <bool overwrite>
+  void construct_tail(storage_type *storage, const size_type first,
+                      const size_type last) {
+    if (first >= last) {
+      return;
+    }
+    if constexpr (!std::is_default_constructible_v<value_type>) {
+      throw std::length_error(
+          "Array of elements which are not default constructible can only "
+          "shrink");
+    } else if constexpr (overwrite) {
+      if constexpr (!std::is_trivially_default_constructible_v<value_type>) {
+        auto idx = first;
+        try {
+          for (; idx < last; ++idx) {
+            ::new (static_cast<void *>(storage + idx)) value_type;
+          }
+        } catch (...) {
+          destroy_range(storage + first, idx - first);
+          throw;
+        }
+      }
+    } else if constexpr (detail::is_zero_initializable_v<value_type>) {
+      std::memset(static_cast<void *>(storage + first), 0,
+                  sizeof(storage_type) * (last - first));
+    } else {
+      construct_each(storage + first, last - first);
+    }
+  }
+
+  template <bool overwrite>
+  bool reallocate_storage(const size_type new_size) {
+    const auto old_size = size();
+    if (new_size == old_size) {
+      return false;
+    }
+    const auto kept = std::min(old_size, new_size);
+    if constexpr (is_trivially_relocatable_v<value_type> &&
+                  detail::has_reallocate<storage_allocator_type>::value &&
+                  is_nothrow_tail_constructible<overwrite>) {
+      // destructors of removed elements would have to run before the
+      // block shrinks, and it may fail to
+      if (storage_ != nullptr && new_size > 0 &&
+          (new_size > old_size ||
+           std::is_trivially_destructible_v<value_type>)) {
+        storage_allocator_type storage_allocator{get_allocator_ref()};
+        if (const auto blocks = storage_allocator.reallocate(
+                blocks_of(storage_), block_count(old_size),
+                block_count(new_size))) {
+          detail::record(instrumentation::event::deallocation,
+                         sizeof(block_type) * block_count(old_size));
+          detail::record(instrumentation::event::allocation,
+                         sizeof(block_type) * block_count(new_size));
+          const auto buffer = set_up_blocks(blocks, new_size);
+          zero_padding(buffer, new_size);
+          construct_tail<overwrite>(buffer, old_size, new_size);
+          const auto moved = buffer != storage_;
+          set_up_storage(buffer, new_size);
+          return moved;
+        }
+      }
+    }
+    auto buffer = allocate_buffer(new_size);
+    try {
+      construct_tail<overwrite>(buffer, kept, new_size);
+    } catch (...) {
+      deallocate_buffer(buffer, new_size);
+      throw;
+    }
+    if constexpr (is_trivially_relocatable_v<value_type>) {
+      if (kept > 0) {
+        std::memcpy(static_cast<void *>(buffer),
+                    static_cast<const void *>(storage_),
+                    sizeof(storage_type) * kept);
+      }
+      destroy_range(storage_ + kept, old_size - kept);
+    } else {
+      size_type idx{};
+      try {
+        for (; idx < kept; ++idx) {
+          alloc_traits::construct(
+              get_allocator_ref(), buffer + idx,
+              std::move_if_noexcept(*to_value_type_pointer(storage_ + idx)));
+        }
+      } catch (...) {
+        destroy_range(buffer, idx);
+        destroy_range(buffer + kept, new_size - kept);
+        deallocate_buffer(buffer, new_size);
+        throw;
+      }
+      destroy_stored_objects();
+    }
+    deallocate_buffer(storage_, old_size);
+    set_up_storage(buffer, new_size);
+    return true;
+  }
+
+  // constructs size elements from the same args, already constructed
+  // elements are destroyed if any of constructors throws
+  template <typename... Args>
+  VLRX_CONSTEXPR20 void construct_each(storage_type *storage,
+                                       const size_type size,
+                                       const Args &...args) {
+    if constexpr (sizeof...(Args) == 1 && is_bitwise_copy_constructible &&
+                  (std::is_same_v<Args, value_type> && ...)) {
+      if (!detail::is_constant_evaluated()) {
+        // lowered to memset or vectorized stores, and unlike fill_n it
+        // constructs elements rather than assigns them
+        std::uninitialized_fill_n(storage, size, args...);
+        return;
+      }
+    }
+    size_type idx{};
+    try {
+      for (; idx < size; ++idx) {
+        alloc_traits::construct(get_allocator_ref(), storage + idx, args...);
+      }
+    } catch (...) {
+      destroy_range(storage, idx);
+      throw;
+    }
+  }
+
+  // constructs elements [first, last) from generator(idx), already
+  // constructed elements are destroyed if any of constructors throws
+  template <typename Generator>
+  VLRX_CONSTEXPR20 void generate_range(storage_type *storage,
+                                       const size_type first,
+                                       const size_type last,
+                                       Generator &generator) {
+    using result_type = std::invoke_result_t<Generator &, size_type>;
+    auto idx = first;
+    try {
+      for (; idx < last; ++idx) {
+        const auto element = storage + idx;
+        if constexpr (detail::uses_default_construct_v<
+                          allocator_type, value_type, result_type>) {
+          if constexpr (std::is_constructible_v<value_type, result_type>) {
+            if (detail::is_constant_evaluated()) {
+              // placement new is not allowed in constant expressions, so
+              // the result is moved into place
+              alloc_traits::construct(get_allocator_ref(), element,
+                                      generator(idx));
+              continue;
+            }
+          }
+          ::new (static_cast<void *>(element)) value_type(generator(idx));
+        } else {
+          alloc_traits::construct(get_allocator_ref(), element,
+                                  generator(idx));
+        }
+      }
+    } catch (...) {
+      destroy_range(storage + first, idx - first);
+      throw;
+    }
+  }
+
+  template <typename Executor>
+  [[nodiscard]] storage_type *
+  allocate_placed_buffer(const size_type size,
+                         const parallel_policy<Executor> &policy) {
+    auto buffer = allocate_buffer(size);
+    policy.place(buffer, sizeof(storage_type) * static_cast<std::size_t>(size));
+    return buffer;
+  }
+
+  // construct_range(first, last) builds elements [first, last) and destroys
+  // them itself if it throws, completed chunks are destroyed by policy
+  template <typename Executor, typename ConstructRange>
+  void construct_in_parallel(storage_type *storage, const size_type size,
+                             const parallel_policy<Executor> &policy,
+                             ConstructRange &&construct_range) {
+    policy.for_each_chunk(
+        storage, static_cast<std::size_t>(size), sizeof(storage_type),
+        [&](const std::size_t first, const std::size_t last) {
+          construct_range(static_cast<size_type>(first),
+                          static_cast<size_type>(last));
+        },
+        [&](const std::size_t first, const std::size_t last) {
+          destroy_range(storage + first, static_cast<size_type>(last - first));
+        });
+  }
+
+  // constructs size elements from [iter, iter + size), already constructed
+  // elements are destroyed if any of constructors throws
   template <typename Input>
-  void fill_buffer(Input &&iter, storage_type *&storage, const size_type size) {
-    for (size_type idx{}; idx < size; ++idx) {
-      new (storage + idx) value_type(iter[idx]);
+  VLRX_CONSTEXPR20 void fill_buffer(Input iter, storage_type *storage,
+                                    const size_type size) {
+    size_type idx{};
+    try {
+      for (; idx < size; ++idx, ++iter) {
+        alloc_traits::construct(get_allocator_ref(), storage + idx, *iter);
+      }
+    } catch (...) {
+      destroy_range(storage, idx);
+      throw;
     }
   }
 };
 
-template <typename VType, typename SType>
-inline void swap(heap_array<VType, SType> &lhs, heap_array<VType, SType> &rhs) {
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 void
+swap(heap_array<VType, SType, Alloc, LType> &lhs,
+     heap_array<VType, SType, Alloc, LType> &rhs) noexcept {
   lhs.swap(rhs);
 }
 
-template <typename VType, typename SType>
-inline bool operator==(const heap_array<VType, SType> &lhs,
-                       const heap_array<VType, SType> &rhs) {
-  return lhs.size_ == rhs.size_ &&
-         std::equal(lhs.begin(), lhs.end(), rhs.begin());
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 bool
+operator==(const heap_array<VType, SType, Alloc, LType> &lhs,
+           const heap_array<VType, SType, Alloc, LType> &rhs) {
+  return detail::equal_elements(lhs, rhs);
 }
 
-template <typename VType, typename SType>
-inline bool operator!=(const heap_array<VType, SType> &lhs,
-                       const heap_array<VType, SType> &rhs) {
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 bool
+operator!=(const heap_array<VType, SType, Alloc, LType> &lhs,
+           const heap_array<VType, SType, Alloc, LType> &rhs) {
   return !(lhs == rhs);
 }
 
-template <typename VType, typename SType>
-inline bool operator<(const heap_array<VType, SType> &lhs,
-                      const heap_array<VType, SType> &rhs) {
-  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
-                                      rhs.end());
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 bool
+operator<(const heap_array<VType, SType, Alloc, LType> &lhs,
+          const heap_array<VType, SType, Alloc, LType> &rhs) {
+  return detail::less_elements(lhs, rhs);
 }
 
-template <typename VType, typename SType>
-inline bool operator>(const heap_array<VType, SType> &lhs,
-                      const heap_array<VType, SType> &rhs) {
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 bool
+operator>(const heap_array<VType, SType, Alloc, LType> &lhs,
+          const heap_array<VType, SType, Alloc, LType> &rhs) {
   return rhs < lhs;
 }
 
-template <typename VType, typename SType>
-inline bool operator<=(const heap_array<VType, SType> &lhs,
-                       const heap_array<VType, SType> &rhs) {
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 bool
+operator<=(const heap_array<VType, SType, Alloc, LType> &lhs,
+           const heap_array<VType, SType, Alloc, LType> &rhs) {
   return !(lhs > rhs);
 }
 
-template <typename VType, typename SType>
-inline bool operator>=(const heap_array<VType, SType> &lhs,
-                       const heap_array<VType, SType> &rhs) {
+template <typename VType, typename SType, typename Alloc, typename LType>
+inline VLRX_CONSTEXPR20 bool
+operator>=(const heap_array<VType, SType, Alloc, LType> &lhs,
+           const heap_array<VType, SType, Alloc, LType> &rhs) {
   return !(lhs < rhs);
 }
 
+// the buffer does not point back into the array, so it relocates with its
+// allocator
+template <typename VType, typename SType, typename Alloc, typename LType>
+struct is_trivially_relocatable<heap_array<VType, SType, Alloc, LType>>
+    : is_trivially_relocatable<Alloc> {};
+
+namespace pmr {
+
+template <typename T, typename SizeType = std::uint64_t>
+using heap_array =
+    vlrx::heap_array<T, SizeType, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace pmr
+
+template <typename T, typename SizeType = std::uint64_t>
+using compact_heap_array =
+    heap_array<T, SizeType, heap_allocator<T>, compact_layout<>>;
+
+template <typename T, std::size_t Alignment = cache_line_size,
+          typename SizeType = std::uint64_t>
+using aligned_heap_array =
+    heap_array<T, SizeType, heap_allocator<T>, aligned_layout<Alignment>>;
+
 } // namespace vlrx
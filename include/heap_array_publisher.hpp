@@ -0,0 +1,226 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vlrx {
+
+namespace detail {
+
+// Epoch announced by one reader, zero while the reader holds no snapshot.
+struct alignas(cache_line_size) reader_slot {
+  std::atomic<std::uint64_t> epoch{};
+  std::atomic<bool> claimed{};
+};
+
+} // namespace detail
+
+// Holder of the current version of a heap_array, which is replaced by
+// writers and read by many threads at once. Readers acquire the current
+// version wait-free: an acquire is one load and one store of the epoch
+// announced in the reader's own slot, followed by one load of the current
+// version. Replaced versions are destroyed by writers once every reader
+// which could have acquired them has released its snapshot (epoch-based
+// reclamation).
+//
+// Each reading thread creates its own reader with make_reader(), the number
+// of readers alive at once is limited by max_readers. Readers must not
+// outlive the publisher.
+template <typename T, typename SizeType = std::uint64_t,
+          typename Allocator = heap_allocator<T>,
+          typename Layout = natural_layout>
+class heap_array_publisher final {
+public:
+  using array_type = heap_array<T, SizeType, Allocator, Layout>;
+
+  static constexpr std::size_t default_max_readers{64};
+
+  // Version acquired by a reader, it stays alive until the snapshot is
+  // destroyed even if newer versions are published meanwhile.
+  class [[nodiscard]] snapshot final {
+  public:
+    snapshot(snapshot &&other) noexcept
+        : array_{std::exchange(other.array_, nullptr)},
+          depth_{std::exchange(other.depth_, nullptr)},
+          slot_{other.slot_} {}
+
+    snapshot(const snapshot &) = delete;
+
+    snapshot &operator=(const snapshot &) = delete;
+
+    snapshot &operator=(snapshot &&) = delete;
+
+    ~snapshot() {
+      if (depth_ != nullptr && --*depth_ == 0) {
+        slot_->epoch.store(0, std::memory_order_release);
+      }
+    }
+
+    [[nodiscard]] const array_type &get() const noexcept { return *array_; }
+
+    [[nodiscard]] const array_type &operator*() const noexcept {
+      return *array_;
+    }
+
+    [[nodiscard]] const array_type *operator->() const noexcept {
+      return array_;
+    }
+
+  private:
+    friend class heap_array_publisher;
+
+    snapshot(const array_type *array, std::size_t *depth,
+             detail::reader_slot *slot) noexcept
+        : array_{array}, depth_{depth}, slot_{slot} {}
+
+    const array_type *array_;
+    std::size_t *depth_;
+    detail::reader_slot *slot_;
+  };
+
+  // Handle of one reading thread. Snapshots acquired by the same reader may
+  // nest, the reader must not be used by several threads at once.
+  class reader final {
+  public:
+    reader(reader &&other) noexcept
+        : publisher_{std::exchange(other.publisher_, nullptr)},
+          slot_{other.slot_}, depth_{other.depth_} {
+      assert(depth_ == 0);
+    }
+
+    reader(const reader &) = delete;
+
+    reader &operator=(const reader &) = delete;
+
+    reader &operator=(reader &&) = delete;
+
+    ~reader() {
+      assert(depth_ == 0);
+      if (publisher_ != nullptr) {
+        slot_->claimed.store(false, std::memory_order_release);
+      }
+    }
+
+    // the current version, wait-free
+    [[nodiscard]] snapshot acquire() noexcept {
+      assert(publisher_ != nullptr);
+      if (depth_++ == 0) {
+        // the announcement has to be visible to writers before the version
+        // is loaded, hence sequentially consistent operations
+        slot_->epoch.store(publisher_->epoch_.load(std::memory_order_seq_cst),
+                           std::memory_order_seq_cst);
+      }
+      return snapshot{publisher_->current_.load(std::memory_order_seq_cst),
+                      &depth_, slot_};
+    }
+
+  private:
+    friend class heap_array_publisher;
+
+    reader(heap_array_publisher *publisher, detail::reader_slot *slot) noexcept
+        : publisher_{publisher}, slot_{slot} {}
+
+    heap_array_publisher *publisher_;
+    detail::reader_slot *slot_;
+    std::size_t depth_{};
+  };
+
+  explicit heap_array_publisher(
+      array_type initial = array_type(),
+      const std::size_t max_readers = default_max_readers)
+      : slots_(max_readers),
+        current_{new array_type(std::move(initial))} {}
+
+  heap_array_publisher(const heap_array_publisher &) = delete;
+
+  heap_array_publisher &operator=(const heap_array_publisher &) = delete;
+
+  ~heap_array_publisher() {
+    assert(std::none_of(slots_.begin(), slots_.end(),
+                        [](const detail::reader_slot &slot) {
+                          return slot.claimed.load();
+                        }));
+    delete current_.load(std::memory_order_relaxed);
+  }
+
+  // claims a free reader slot, throws if all of them are taken
+  [[nodiscard]] reader make_reader() {
+    for (auto &slot : slots_) {
+      bool claimed{};
+      if (!slot.claimed.load(std::memory_order_relaxed) &&
+          slot.claimed.compare_exchange_strong(claimed, true,
+                                               std::memory_order_acquire)) {
+        return reader{this, &slot};
+      }
+    }
+    throw std::runtime_error("All reader slots of the publisher are taken");
+  }
+
+  // Makes array the current version, the replaced one is destroyed as soon
+  // as no reader holds it, possibly by a later call to publish or reclaim.
+  void publish(array_type array) {
+    auto next = std::make_unique<array_type>(std::move(array));
+    const std::lock_guard<std::mutex> lock{writer_mutex_};
+    retired_.reserve(retired_.size() + 1);
+    std::unique_ptr<const array_type> previous{
+        current_.exchange(next.release(), std::memory_order_seq_cst)};
+    // readers which may hold previous announced an epoch not newer than
+    // this one
+    const auto epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+    retired_.push_back({std::move(previous), epoch});
+    collect();
+  }
+
+  // destroys replaced versions which are no longer held by readers
+  void reclaim() {
+    const std::lock_guard<std::mutex> lock{writer_mutex_};
+    collect();
+  }
+
+  // number of replaced versions which are not destroyed yet
+  [[nodiscard]] std::size_t retired_count() {
+    const std::lock_guard<std::mutex> lock{writer_mutex_};
+    return retired_.size();
+  }
+
+private:
+  struct retired_version {
+    std::unique_ptr<const array_type> array;
+    std::uint64_t epoch;
+  };
+
+  heap_array<detail::reader_slot> slots_;
+  std::atomic<const array_type *> current_;
+  // zero is announced by readers which hold no snapshot
+  std::atomic<std::uint64_t> epoch_{1};
+  std::mutex writer_mutex_;
+  std::vector<retired_version> retired_;
+
+  void collect() {
+    auto oldest = std::numeric_limits<std::uint64_t>::max();
+    for (const auto &slot : slots_) {
+      const auto epoch = slot.epoch.load(std::memory_order_seq_cst);
+      if (epoch != 0 && epoch < oldest) {
+        oldest = epoch;
+      }
+    }
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [&](const retired_version &version) {
+                                    return version.epoch < oldest;
+                                  }),
+                   retired_.end());
+  }
+};
+
+} // namespace vlrx
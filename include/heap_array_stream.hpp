@@ -0,0 +1,337 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vlrx {
+
+inline constexpr std::size_t default_chunk_size{std::size_t{4} << 20};
+
+namespace detail {
+
+inline constexpr char stream_magic[8] = {'V', 'L', 'R', 'X',
+                                         'H', 'S', 'T', 'R'};
+inline constexpr std::uint32_t stream_version{3};
+// elements are encoded by a codec and framed with their length, records are
+// written in frames which are preceded by their length and the payload ends
+// with an empty frame
+inline constexpr std::uint32_t stream_flag_codec{1};
+
+struct stream_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t element_size;
+  std::uint64_t count;
+  // bytes which follow the header, so that readers stop exactly at the end
+  // of the array on streams holding more data, zero for framed payload
+  std::uint64_t payload_bytes;
+};
+
+using record_length_type = std::uint32_t;
+using frame_length_type = std::uint64_t;
+
+inline void write_header(std::ostream &out, const std::uint32_t flags,
+                         const std::uint64_t element_size,
+                         const std::uint64_t count,
+                         const std::uint64_t payload_bytes) {
+  stream_header header{};
+  std::memcpy(header.magic, stream_magic, sizeof(header.magic));
+  header.version = stream_version;
+  header.flags = flags;
+  header.element_size = element_size;
+  header.count = count;
+  header.payload_bytes = payload_bytes;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+inline void write_frame(std::ostream &out, const std::string &frame) {
+  const auto length = static_cast<frame_length_type>(frame.size());
+  out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+}
+
+[[nodiscard]] inline stream_header
+read_header(std::istream &in, const std::uint32_t flags,
+            const std::uint64_t element_size) {
+  stream_header header{};
+  in.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (in.gcount() != static_cast<std::streamsize>(sizeof(header)) ||
+      std::memcmp(header.magic, stream_magic, sizeof(header.magic)) != 0) {
+    throw std::runtime_error("Stream does not hold heap_array");
+  }
+  if (header.version != stream_version) {
+    throw std::runtime_error("Stream has unsupported version");
+  }
+  if (header.flags != flags || header.element_size != element_size) {
+    throw std::runtime_error("Stream holds elements of different type");
+  }
+  return header;
+}
+
+// Reads framed payload of stream in chunks, the next chunk is read by a
+// background thread while the current one is being decoded. Each frame is
+// read together with the length of the next one, and nothing past the empty
+// frame which ends the payload is read, so a pipe is never waited on for data
+// of the sender's next message.
+class chunk_reader final {
+public:
+  chunk_reader(std::istream &in, const std::size_t chunk_size)
+      : in_{in}, chunk_size_{chunk_size} {
+    frame_length_type length{};
+    in_.read(reinterpret_cast<char *>(&length), sizeof(length));
+    if (in_.gcount() != static_cast<std::streamsize>(sizeof(length))) {
+      throw std::runtime_error("Stream is truncated");
+    }
+    start_frame(length);
+  }
+
+  chunk_reader(const chunk_reader &) = delete;
+
+  chunk_reader &operator=(const chunk_reader &) = delete;
+
+  ~chunk_reader() {
+    if (pending_.valid()) {
+      pending_.wait();
+    }
+  }
+
+  // returns pointer to at least size unconsumed contiguous bytes
+  [[nodiscard]] const char *ensure(const std::size_t size) {
+    while (current_.size() - position_ < size) {
+      if (!refill()) {
+        throw std::runtime_error("Stream is truncated");
+      }
+    }
+    return current_.data() + position_;
+  }
+
+  void consume(const std::size_t size) noexcept { position_ += size; }
+
+  // whether the whole payload was read and consumed
+  [[nodiscard]] bool at_end() const noexcept {
+    return remaining_ == 0 && !pending_.valid() && position_ == current_.size();
+  }
+
+private:
+  std::istream &in_;
+  std::size_t chunk_size_;
+  // bytes of the current frame and the length of the next one which were
+  // not requested from in_ yet
+  std::uint64_t remaining_{};
+  std::vector<char> current_;
+  std::size_t position_{};
+  std::vector<char> incoming_;
+  std::size_t requested_{};
+  std::future<std::size_t> pending_;
+
+  void start_frame(const frame_length_type length) {
+    if (length > std::numeric_limits<std::uint64_t>::max() -
+                     sizeof(frame_length_type)) {
+      throw std::runtime_error("Stream has malformed frame");
+    }
+    remaining_ = length == 0 ? 0 : length + sizeof(frame_length_type);
+    start_read();
+  }
+
+  void start_read() {
+    if (remaining_ == 0) {
+      return;
+    }
+    requested_ = static_cast<std::size_t>(
+        std::min<std::uint64_t>(chunk_size_, remaining_));
+    remaining_ -= requested_;
+    incoming_.resize(requested_);
+    pending_ = std::async(std::launch::async, [this] {
+      in_.read(incoming_.data(), static_cast<std::streamsize>(requested_));
+      return static_cast<std::size_t>(in_.gcount());
+    });
+  }
+
+  bool refill() {
+    if (!pending_.valid()) {
+      return false;
+    }
+    const auto read = pending_.get();
+    current_.erase(current_.begin(),
+                   current_.begin() + static_cast<std::ptrdiff_t>(position_));
+    position_ = 0;
+    current_.insert(current_.end(), incoming_.begin(),
+                    incoming_.begin() + static_cast<std::ptrdiff_t>(read));
+    if (read != requested_) {
+      return false;
+    }
+    if (remaining_ != 0) {
+      start_read();
+      return true;
+    }
+    // the frame is followed by the length of the next one
+    frame_length_type next{};
+    const auto next_offset = current_.size() - sizeof(next);
+    std::memcpy(&next, current_.data() + next_offset, sizeof(next));
+    current_.resize(next_offset);
+    start_frame(next);
+    return true;
+  }
+};
+
+template <typename Codec>
+inline constexpr bool is_codec_v = !std::is_arithmetic_v<std::decay_t<Codec>>;
+
+} // namespace detail
+
+// Writes elements of trivially copyable array to out, chunk_size bytes at a
+// time.
+template <typename VType, typename SType, typename Alloc, typename LType>
+void write_to(std::ostream &out,
+              const heap_array<VType, SType, Alloc, LType> &array,
+              const std::size_t chunk_size = default_chunk_size) {
+  static_assert(std::is_trivially_copyable_v<VType>,
+                "Use write_to with codec for non-trivially copyable types");
+  const auto size = sizeof(VType) * static_cast<std::size_t>(array.size());
+  detail::write_header(out, 0, sizeof(VType), array.size(), size);
+  const auto bytes = reinterpret_cast<const char *>(array.data());
+  for (std::size_t offset{}; offset < size && out; offset += chunk_size) {
+    const auto to_write = std::min(chunk_size, size - offset);
+    out.write(bytes + offset, static_cast<std::streamsize>(to_write));
+  }
+  if (!out) {
+    throw std::runtime_error("Failed to write heap_array to stream");
+  }
+}
+
+// Writes elements encoded by codec.encode(const VType &, std::string &out),
+// which appends encoded element to out. Elements are encoded into a frame of
+// about chunk_size bytes, which is written as soon as it is full.
+template <typename VType, typename SType, typename Alloc, typename LType,
+          typename Codec,
+          typename std::enable_if_t<detail::is_codec_v<Codec>, int> = 1>
+void write_to(std::ostream &out,
+              const heap_array<VType, SType, Alloc, LType> &array,
+              Codec &&codec,
+              const std::size_t chunk_size = default_chunk_size) {
+  detail::write_header(out, detail::stream_flag_codec, 0, array.size(), 0);
+  std::string buffer;
+  for (const auto &element : array) {
+    if (buffer.size() >= chunk_size) {
+      if (!out) {
+        break;
+      }
+      detail::write_frame(out, buffer);
+      buffer.clear();
+    }
+    const auto length_offset = buffer.size();
+    buffer.append(sizeof(detail::record_length_type), '\0');
+    codec.encode(element, buffer);
+    const auto length = buffer.size() - length_offset -
+                        sizeof(detail::record_length_type);
+    if (length > std::numeric_limits<detail::record_length_type>::max()) {
+      throw std::length_error("Encoded element is too big");
+    }
+    const auto record_length = static_cast<detail::record_length_type>(length);
+    std::memcpy(buffer.data() + length_offset, &record_length,
+                sizeof(record_length));
+  }
+  if (!buffer.empty()) {
+    detail::write_frame(out, buffer);
+  }
+  detail::write_frame(out, {});
+  if (!out) {
+    throw std::runtime_error("Failed to write heap_array to stream");
+  }
+}
+
+// Reads array of trivially copyable elements written by write_to directly
+// into its buffer, chunk_size bytes at a time.
+template <typename Array>
+[[nodiscard]] Array
+read_from(std::istream &in, const std::size_t chunk_size = default_chunk_size) {
+  using value_type = typename Array::value_type;
+  using size_type = typename Array::size_type;
+  static_assert(std::is_trivially_copyable_v<value_type>,
+                "Use read_from with codec for non-trivially copyable types");
+  const auto header = detail::read_header(in, 0, sizeof(value_type));
+  if (header.count > std::numeric_limits<size_type>::max()) {
+    throw std::length_error("Stream holds too many elements");
+  }
+  const auto size = sizeof(value_type) * static_cast<std::size_t>(header.count);
+  if (header.payload_bytes != size) {
+    throw std::runtime_error("Stream has inconsistent header");
+  }
+  Array array(static_cast<size_type>(header.count), for_overwrite);
+  const auto bytes = reinterpret_cast<char *>(array.data());
+  for (std::size_t offset{}; offset < size; offset += chunk_size) {
+    const auto to_read = std::min(chunk_size, size - offset);
+    in.read(bytes + offset, static_cast<std::streamsize>(to_read));
+    if (static_cast<std::size_t>(in.gcount()) != to_read) {
+      throw std::runtime_error("Stream is truncated");
+    }
+  }
+  return array;
+}
+
+// Reads array written by write_to with codec, i-th element is constructed in
+// place from codec.decode(const char *data, std::size_t size). The next chunk
+// is read by a background thread while elements of the current one are
+// constructed. Reading stops at the end of the array, so other data may
+// follow it in the stream. The count in the header is not trusted, so arrays
+// bigger than a chunk grow by doubling as their elements are decoded.
+template <typename Array, typename Codec,
+          typename std::enable_if_t<detail::is_codec_v<Codec>, int> = 1>
+[[nodiscard]] Array
+read_from(std::istream &in, Codec &&codec,
+          const std::size_t chunk_size = default_chunk_size) {
+  using size_type = typename Array::size_type;
+  const auto header = detail::read_header(in, detail::stream_flag_codec, 0);
+  if (header.count > std::numeric_limits<size_type>::max()) {
+    throw std::length_error("Stream holds too many elements");
+  }
+  if (header.payload_bytes != 0) {
+    throw std::runtime_error("Stream has inconsistent header");
+  }
+  detail::chunk_reader reader{in, chunk_size};
+  const auto decode = [&](size_type) {
+    detail::record_length_type length{};
+    std::memcpy(&length, reader.ensure(sizeof(length)), sizeof(length));
+    reader.consume(sizeof(length));
+    const auto data = reader.ensure(length);
+    reader.consume(length);
+    return codec.decode(data, length);
+  };
+  const auto first_size = std::max<std::uint64_t>(
+      1, chunk_size / sizeof(typename Array::value_type));
+  Array array(static_cast<size_type>(std::min(header.count, first_size)),
+              from_generator, decode);
+  while (array.size() < header.count) {
+    const auto size = array.size();
+    Array grown(static_cast<size_type>(std::min<std::uint64_t>(
+                    header.count, std::uint64_t{size} * 2)),
+                from_generator,
+                [&](const size_type idx) -> typename Array::value_type {
+                  if (idx < size) {
+                    return std::move(array[idx]);
+                  }
+                  return decode(idx);
+                });
+    array = std::move(grown);
+  }
+  if (!reader.at_end()) {
+    throw std::runtime_error("Stream has inconsistent header");
+  }
+  return array;
+}
+
+} // namespace vlrx
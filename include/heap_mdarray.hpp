@@ -0,0 +1,818 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace vlrx {
+
+inline constexpr std::size_t dynamic_extent =
+    std::numeric_limits<std::size_t>::max();
+
+// Extents of a multidimensional array, each of them is either fixed at
+// compile time or dynamic_extent, in which case it is stored. The interface
+// mirrors std::extents.
+template <typename IndexType, std::size_t... Extents> class extents {
+  static_assert(sizeof...(Extents) > 0, "Rank has to be at least one");
+  static_assert(std::is_integral_v<IndexType>,
+                "Index type has to be an integral type");
+
+public:
+  using index_type = IndexType;
+  using size_type = std::make_unsigned_t<index_type>;
+  using rank_type = std::size_t;
+
+  [[nodiscard]] static constexpr rank_type rank() noexcept {
+    return sizeof...(Extents);
+  }
+
+  [[nodiscard]] static constexpr rank_type rank_dynamic() noexcept {
+    return ((Extents == dynamic_extent ? 1 : 0) + ...);
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  static_extent(const rank_type r) noexcept {
+    return static_extents_[r];
+  }
+
+  constexpr extents() noexcept = default;
+
+  // takes either all extents or only the dynamic ones
+  template <typename... Sizes,
+            typename std::enable_if_t<
+                (sizeof...(Sizes) > 0) &&
+                    (sizeof...(Sizes) == rank_dynamic() ||
+                     sizeof...(Sizes) == rank()) &&
+                    (std::is_convertible_v<Sizes, index_type> && ...),
+                int> = 1>
+  constexpr explicit extents(const Sizes... sizes) noexcept
+      : extents(std::array<index_type, sizeof...(Sizes)>{
+            static_cast<index_type>(sizes)...}) {}
+
+  template <std::size_t N,
+            typename std::enable_if_t<N == rank_dynamic() || N == rank(),
+                                      int> = 1>
+  constexpr explicit extents(const std::array<index_type, N> &sizes) noexcept {
+    if constexpr (N == rank_dynamic()) {
+      for (rank_type r{}; r < N; ++r) {
+        dynamic_[r] = sizes[r];
+      }
+    } else {
+      for (rank_type r{}; r < rank(); ++r) {
+        if (static_extents_[r] == dynamic_extent) {
+          dynamic_[dynamic_index(r)] = sizes[r];
+        } else {
+          assert(static_cast<std::size_t>(sizes[r]) == static_extents_[r]);
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] constexpr index_type extent(const rank_type r) const noexcept {
+    return static_extents_[r] == dynamic_extent
+               ? dynamic_[dynamic_index(r)]
+               : static_cast<index_type>(static_extents_[r]);
+  }
+
+  // number of elements
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    std::size_t result{1};
+    for (rank_type r{}; r < rank(); ++r) {
+      result *= static_cast<std::size_t>(extent(r));
+    }
+    return result;
+  }
+
+  friend constexpr bool operator==(const extents &lhs,
+                                   const extents &rhs) noexcept {
+    for (rank_type r{}; r < rank(); ++r) {
+      if (lhs.extent(r) != rhs.extent(r)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend constexpr bool operator!=(const extents &lhs,
+                                   const extents &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+private:
+  static constexpr std::size_t static_extents_[] = {Extents...};
+
+  std::array<index_type, rank_dynamic()> dynamic_{};
+
+  [[nodiscard]] static constexpr rank_type
+  dynamic_index(const rank_type r) noexcept {
+    rank_type result{};
+    for (rank_type idx{}; idx < r; ++idx) {
+      result += static_extents_[idx] == dynamic_extent ? 1 : 0;
+    }
+    return result;
+  }
+};
+
+namespace detail {
+
+template <typename IndexType, typename Sequence> struct make_dextents;
+
+template <typename IndexType, std::size_t... Is>
+struct make_dextents<IndexType, std::index_sequence<Is...>> {
+  using type = extents<IndexType, ((void)Is, dynamic_extent)...>;
+};
+
+} // namespace detail
+
+// extents of Rank dimensions, all of them dynamic
+template <typename IndexType, std::size_t Rank>
+using dextents = typename detail::make_dextents<
+    IndexType, std::make_index_sequence<Rank>>::type;
+
+// Tag selecting all indices of a dimension in subview.
+struct full_extent_t {
+  explicit full_extent_t() = default;
+};
+
+inline constexpr full_extent_t full_extent{};
+
+namespace detail {
+
+// Visits all indices with fn(indices...), dimension inner varies fastest and
+// the remaining ones follow in order of steps.
+template <typename Extents, typename Fn>
+void for_each_index(const Extents &ext, const bool last_fastest, Fn &fn) {
+  constexpr auto rank = Extents::rank();
+  using index_type = typename Extents::index_type;
+  for (std::size_t r{}; r < rank; ++r) {
+    if (ext.extent(r) == 0) {
+      return;
+    }
+  }
+  const auto dimension = [&](const std::size_t step) {
+    return last_fastest ? rank - 1 - step : step;
+  };
+  const auto inner = dimension(0);
+  std::array<index_type, rank> indices{};
+  while (true) {
+    for (indices[inner] = 0; indices[inner] < ext.extent(inner);
+         ++indices[inner]) {
+      std::apply(fn, indices);
+    }
+    indices[inner] = 0;
+    std::size_t step{1};
+    for (; step < rank; ++step) {
+      const auto r = dimension(step);
+      if (++indices[r] < ext.extent(r)) {
+        break;
+      }
+      indices[r] = 0;
+    }
+    if (step == rank) {
+      return;
+    }
+  }
+}
+
+// Mapping where offset of indices is their dot product with strides.
+template <typename Extents> class strided_mapping {
+public:
+  using extents_type = Extents;
+  using index_type = typename extents_type::index_type;
+  using size_type = typename extents_type::size_type;
+  using rank_type = typename extents_type::rank_type;
+
+  strided_mapping() noexcept = default;
+
+  [[nodiscard]] constexpr const extents_type &extents() const noexcept {
+    return extents_;
+  }
+
+  template <typename... Indices>
+  [[nodiscard]] constexpr index_type
+  operator()(const Indices... indices) const noexcept {
+    static_assert(sizeof...(Indices) == extents_type::rank(),
+                  "Number of indices has to match the rank");
+    const std::array<index_type, sizeof...(Indices)> values{
+        static_cast<index_type>(indices)...};
+    index_type offset{};
+    for (rank_type r{}; r < extents_type::rank(); ++r) {
+      assert(values[r] < extents_.extent(r));
+      offset += values[r] * strides_[r];
+    }
+    return offset;
+  }
+
+  [[nodiscard]] constexpr index_type stride(const rank_type r) const noexcept {
+    return strides_[r];
+  }
+
+  [[nodiscard]] constexpr index_type required_span_size() const noexcept {
+    index_type size{1};
+    for (rank_type r{}; r < extents_type::rank(); ++r) {
+      if (extents_.extent(r) == 0) {
+        return 0;
+      }
+      size += (extents_.extent(r) - 1) * strides_[r];
+    }
+    return size;
+  }
+
+  [[nodiscard]] static constexpr bool is_always_unique() noexcept {
+    return true;
+  }
+
+  [[nodiscard]] static constexpr bool is_always_strided() noexcept {
+    return true;
+  }
+
+  [[nodiscard]] static constexpr bool is_unique() noexcept { return true; }
+
+  [[nodiscard]] static constexpr bool is_strided() noexcept { return true; }
+
+protected:
+  constexpr strided_mapping(
+      const extents_type &ext,
+      const std::array<index_type, extents_type::rank()> &strides) noexcept
+      : extents_{ext}, strides_{strides} {}
+
+  extents_type extents_{};
+  std::array<index_type, extents_type::rank()> strides_{};
+
+  // strides of the exhaustive layout, where dimension of the last step is
+  // the outermost one
+  [[nodiscard]] static constexpr std::array<index_type, extents_type::rank()>
+  packed_strides(const extents_type &ext, const bool last_fastest) noexcept {
+    std::array<index_type, extents_type::rank()> strides{};
+    index_type stride{1};
+    for (rank_type step{}; step < extents_type::rank(); ++step) {
+      const auto r = last_fastest ? extents_type::rank() - 1 - step : step;
+      strides[r] = stride;
+      stride *= ext.extent(r);
+    }
+    return strides;
+  }
+};
+
+} // namespace detail
+
+// Row-major layout, the last index varies fastest.
+struct layout_right {
+  template <typename Extents>
+  class mapping : public detail::strided_mapping<Extents> {
+  public:
+    using layout_type = layout_right;
+
+    // static extents get their strides, dynamic ones are zero
+    constexpr mapping() noexcept : mapping(Extents{}) {}
+
+    constexpr mapping(const Extents &ext) noexcept
+        : detail::strided_mapping<Extents>{
+              ext, detail::strided_mapping<Extents>::packed_strides(ext,
+                                                                    true)} {}
+
+    [[nodiscard]] static constexpr bool is_always_exhaustive() noexcept {
+      return true;
+    }
+
+    [[nodiscard]] static constexpr bool is_exhaustive() noexcept {
+      return true;
+    }
+
+    // visits indices in order of their offsets
+    template <typename Fn> void for_each_index(Fn &&fn) const {
+      detail::for_each_index(this->extents_, true, fn);
+    }
+
+    friend constexpr bool operator==(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return lhs.extents() == rhs.extents();
+    }
+
+    friend constexpr bool operator!=(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return !(lhs == rhs);
+    }
+  };
+};
+
+// Column-major layout, the first index varies fastest.
+struct layout_left {
+  template <typename Extents>
+  class mapping : public detail::strided_mapping<Extents> {
+  public:
+    using layout_type = layout_left;
+
+    constexpr mapping() noexcept : mapping(Extents{}) {}
+
+    constexpr mapping(const Extents &ext) noexcept
+        : detail::strided_mapping<Extents>{
+              ext, detail::strided_mapping<Extents>::packed_strides(ext,
+                                                                    false)} {}
+
+    [[nodiscard]] static constexpr bool is_always_exhaustive() noexcept {
+      return true;
+    }
+
+    [[nodiscard]] static constexpr bool is_exhaustive() noexcept {
+      return true;
+    }
+
+    template <typename Fn> void for_each_index(Fn &&fn) const {
+      detail::for_each_index(this->extents_, false, fn);
+    }
+
+    friend constexpr bool operator==(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return lhs.extents() == rhs.extents();
+    }
+
+    friend constexpr bool operator!=(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return !(lhs == rhs);
+    }
+  };
+};
+
+// Layout with arbitrary strides, used by sub-views.
+struct layout_stride {
+  template <typename Extents>
+  class mapping : public detail::strided_mapping<Extents> {
+  public:
+    using layout_type = layout_stride;
+    using index_type = typename Extents::index_type;
+
+    // row-major strides of the default extents
+    constexpr mapping() noexcept
+        : mapping(Extents{},
+                  detail::strided_mapping<Extents>::packed_strides(Extents{},
+                                                                   true)) {}
+
+    constexpr mapping(
+        const Extents &ext,
+        const std::array<index_type, Extents::rank()> &strides) noexcept
+        : detail::strided_mapping<Extents>{ext, strides} {}
+
+    [[nodiscard]] static constexpr bool is_always_exhaustive() noexcept {
+      return false;
+    }
+
+    [[nodiscard]] constexpr bool is_exhaustive() const noexcept {
+      return static_cast<std::size_t>(this->required_span_size()) ==
+             this->extents_.size();
+    }
+
+    // visits indices in row-major order
+    template <typename Fn> void for_each_index(Fn &&fn) const {
+      detail::for_each_index(this->extents_, true, fn);
+    }
+
+    friend constexpr bool operator==(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return lhs.extents() == rhs.extents() && lhs.strides_ == rhs.strides_;
+    }
+
+    friend constexpr bool operator!=(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return !(lhs == rhs);
+    }
+  };
+};
+
+// Two-dimensional blocked layout: the matrix is split into TileRows x
+// TileColumns tiles stored one after another in row-major order, elements of
+// a tile are contiguous and row-major as well. Neighbours in both dimensions
+// stay within one tile, which keeps stencils and transposes in cache. Edge
+// tiles are padded, so the buffer may hold more elements than the matrix.
+template <std::size_t TileRows, std::size_t TileColumns = TileRows>
+struct layout_tiled {
+  static_assert(TileRows > 0 && TileColumns > 0, "Tiles can not be empty");
+
+  template <typename Extents> class mapping {
+    static_assert(Extents::rank() == 2, "Tiled layout is two-dimensional");
+
+  public:
+    using extents_type = Extents;
+    using index_type = typename extents_type::index_type;
+    using size_type = typename extents_type::size_type;
+    using rank_type = typename extents_type::rank_type;
+    using layout_type = layout_tiled;
+
+    constexpr mapping() noexcept : mapping(extents_type{}) {}
+
+    constexpr mapping(const extents_type &ext) noexcept
+        : extents_{ext},
+          tiles_per_row_{(ext.extent(1) + tile_columns - 1) / tile_columns} {}
+
+    [[nodiscard]] constexpr const extents_type &extents() const noexcept {
+      return extents_;
+    }
+
+    [[nodiscard]] constexpr index_type
+    operator()(const index_type row, const index_type column) const noexcept {
+      assert(row < extents_.extent(0) && column < extents_.extent(1));
+      return ((row / tile_rows) * tiles_per_row_ + column / tile_columns) *
+                 tile_size +
+             (row % tile_rows) * tile_columns + column % tile_columns;
+    }
+
+    [[nodiscard]] constexpr index_type required_span_size() const noexcept {
+      return (extents_.extent(0) + tile_rows - 1) / tile_rows *
+             tiles_per_row_ * tile_size;
+    }
+
+    [[nodiscard]] static constexpr bool is_always_unique() noexcept {
+      return true;
+    }
+
+    [[nodiscard]] static constexpr bool is_always_exhaustive() noexcept {
+      return false;
+    }
+
+    [[nodiscard]] static constexpr bool is_always_strided() noexcept {
+      return false;
+    }
+
+    [[nodiscard]] static constexpr bool is_unique() noexcept { return true; }
+
+    [[nodiscard]] constexpr bool is_exhaustive() const noexcept {
+      return extents_.extent(0) % tile_rows == 0 &&
+             extents_.extent(1) % tile_columns == 0;
+    }
+
+    [[nodiscard]] static constexpr bool is_strided() noexcept { return false; }
+
+    // visits indices tile by tile, in order of their offsets
+    template <typename Fn> void for_each_index(Fn &&fn) const {
+      const auto rows = extents_.extent(0);
+      const auto columns = extents_.extent(1);
+      for (index_type tile_row{}; tile_row < rows; tile_row += tile_rows) {
+        const auto row_end = std::min<index_type>(rows, tile_row + tile_rows);
+        for (index_type tile_column{}; tile_column < columns;
+             tile_column += tile_columns) {
+          const auto column_end =
+              std::min<index_type>(columns, tile_column + tile_columns);
+          for (auto row = tile_row; row < row_end; ++row) {
+            for (auto column = tile_column; column < column_end; ++column) {
+              fn(row, column);
+            }
+          }
+        }
+      }
+    }
+
+    friend constexpr bool operator==(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return lhs.extents() == rhs.extents();
+    }
+
+    friend constexpr bool operator!=(const mapping &lhs,
+                                     const mapping &rhs) noexcept {
+      return !(lhs == rhs);
+    }
+
+  private:
+    static constexpr auto tile_rows = static_cast<index_type>(TileRows);
+    static constexpr auto tile_columns = static_cast<index_type>(TileColumns);
+    static constexpr auto tile_size = tile_rows * tile_columns;
+
+    extents_type extents_{};
+    index_type tiles_per_row_{};
+  };
+};
+
+namespace detail {
+
+template <typename IndexType>
+void slice_bounds(full_extent_t, const IndexType extent, IndexType &first,
+                  IndexType &count) noexcept {
+  first = 0;
+  count = extent;
+}
+
+// half-open range [first, last) of indices
+template <typename IndexType, typename First, typename Last>
+void slice_bounds(const std::pair<First, Last> &range,
+                  [[maybe_unused]] const IndexType extent, IndexType &first,
+                  IndexType &count) noexcept {
+  assert(range.first <= range.second &&
+         static_cast<IndexType>(range.second) <= extent);
+  first = static_cast<IndexType>(range.first);
+  count = static_cast<IndexType>(range.second - range.first);
+}
+
+} // namespace detail
+
+// Non-owning multidimensional view of elements, addressed through the
+// mapping of Layout. The interface mirrors std::mdspan.
+template <typename ElementType, typename Extents,
+          typename Layout = layout_right>
+class mdarray_view {
+public:
+  using extents_type = Extents;
+  using layout_type = Layout;
+  using mapping_type = typename layout_type::template mapping<extents_type>;
+  using element_type = ElementType;
+  using value_type = std::remove_cv_t<element_type>;
+  using index_type = typename extents_type::index_type;
+  using size_type = typename extents_type::size_type;
+  using rank_type = typename extents_type::rank_type;
+  using data_handle_type = element_type *;
+  using reference = element_type &;
+
+  mdarray_view() noexcept = default;
+
+  mdarray_view(const data_handle_type data, const mapping_type &mapping)
+      : data_{data}, mapping_{mapping} {}
+
+  template <typename... Indices>
+  [[nodiscard]] reference operator()(const Indices... indices) const noexcept {
+    return data_[mapping_(static_cast<index_type>(indices)...)];
+  }
+
+  [[nodiscard]] reference operator[](
+      const std::array<index_type, extents_type::rank()> &indices)
+      const noexcept {
+    return data_[std::apply(mapping_, indices)];
+  }
+
+  [[nodiscard]] static constexpr rank_type rank() noexcept {
+    return extents_type::rank();
+  }
+
+  [[nodiscard]] static constexpr rank_type rank_dynamic() noexcept {
+    return extents_type::rank_dynamic();
+  }
+
+  [[nodiscard]] const extents_type &extents() const noexcept {
+    return mapping_.extents();
+  }
+
+  [[nodiscard]] index_type extent(const rank_type r) const noexcept {
+    return extents().extent(r);
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return extents().size(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] data_handle_type data_handle() const noexcept { return data_; }
+
+  [[nodiscard]] const mapping_type &mapping() const noexcept {
+    return mapping_;
+  }
+
+  [[nodiscard]] index_type stride(const rank_type r) const noexcept {
+    return mapping_.stride(r);
+  }
+
+  // calls fn(indices...) for all indices, in order of their offsets for
+  // layouts provided by the library
+  template <typename Fn> void for_each_index(Fn &&fn) const {
+    mapping_.for_each_index(fn);
+  }
+
+  // Zero-copy view of a part of the array, each slice is full_extent or a
+  // half-open range std::pair{first, last}. Available for strided layouts.
+  template <typename... Slices>
+  [[nodiscard]] mdarray_view<element_type,
+                             dextents<index_type, extents_type::rank()>,
+                             layout_stride>
+  subview(const Slices &...slices) const {
+    static_assert(sizeof...(Slices) == extents_type::rank(),
+                  "Number of slices has to match the rank");
+    static_assert(mapping_type::is_always_strided(),
+                  "Sub-views are available for strided layouts");
+    using sub_extents_type = dextents<index_type, extents_type::rank()>;
+    std::array<index_type, extents_type::rank()> first{};
+    std::array<index_type, extents_type::rank()> count{};
+    std::array<index_type, extents_type::rank()> strides{};
+    rank_type r{};
+    ((detail::slice_bounds(slices, extent(r), first[r], count[r]), ++r), ...);
+    index_type offset{};
+    for (r = 0; r < extents_type::rank(); ++r) {
+      strides[r] = mapping_.stride(r);
+      offset += first[r] * strides[r];
+    }
+    return {data_ + offset, layout_stride::mapping<sub_extents_type>{
+                                sub_extents_type{count}, strides}};
+  }
+
+private:
+  data_handle_type data_{};
+  mapping_type mapping_{};
+};
+
+// Owning multidimensional array. Elements are stored in Container (heap_array
+// by default) at offsets given by the mapping of Layout. Its size is fixed at
+// construction, as of the underlying heap_array.
+template <typename T, typename Extents, typename Layout = layout_right,
+          typename Container = heap_array<T>>
+class basic_heap_mdarray {
+public:
+  using extents_type = Extents;
+  using layout_type = Layout;
+  using mapping_type = typename layout_type::template mapping<extents_type>;
+  using container_type = Container;
+  using value_type = T;
+  using element_type = T;
+  using index_type = typename extents_type::index_type;
+  using size_type = typename extents_type::size_type;
+  using rank_type = typename extents_type::rank_type;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+  using view_type = mdarray_view<value_type, extents_type, layout_type>;
+  using const_view_type =
+      mdarray_view<const value_type, extents_type, layout_type>;
+
+  static_assert(std::is_same_v<typename container_type::value_type, T>,
+                "Container::value_type must be the same as T");
+
+  // holds value-initialized elements when all extents are static, and none
+  // otherwise
+  basic_heap_mdarray() : container_(container_size(mapping_)) {}
+
+  // value-initializes elements
+  explicit basic_heap_mdarray(const mapping_type &mapping)
+      : mapping_{mapping}, container_(container_size(mapping)) {}
+
+  explicit basic_heap_mdarray(const extents_type &ext)
+      : basic_heap_mdarray(mapping_type{ext}) {}
+
+  // takes either all extents or only the dynamic ones
+  template <typename... Sizes,
+            typename std::enable_if_t<
+                (sizeof...(Sizes) > 0) &&
+                    (std::is_integral_v<Sizes> && ...) &&
+                    std::is_constructible_v<extents_type, Sizes...>,
+                int> = 1>
+  explicit basic_heap_mdarray(const Sizes... sizes)
+      : basic_heap_mdarray(extents_type{sizes...}) {}
+
+  basic_heap_mdarray(const extents_type &ext, const value_type &value)
+      : mapping_{ext}, container_(container_size(mapping_), value) {}
+
+  template <typename... Indices>
+  [[nodiscard]] reference operator()(const Indices... indices) noexcept {
+    return container_.data()[mapping_(static_cast<index_type>(indices)...)];
+  }
+
+  template <typename... Indices>
+  [[nodiscard]] const_reference
+  operator()(const Indices... indices) const noexcept {
+    return container_.data()[mapping_(static_cast<index_type>(indices)...)];
+  }
+
+  [[nodiscard]] reference operator[](
+      const std::array<index_type, extents_type::rank()> &indices) noexcept {
+    return container_.data()[std::apply(mapping_, indices)];
+  }
+
+  [[nodiscard]] const_reference operator[](
+      const std::array<index_type, extents_type::rank()> &indices)
+      const noexcept {
+    return container_.data()[std::apply(mapping_, indices)];
+  }
+
+  template <typename... Indices>
+  [[nodiscard]] reference at(const Indices... indices) {
+    check_indices(indices...);
+    return (*this)(indices...);
+  }
+
+  template <typename... Indices>
+  [[nodiscard]] const_reference at(const Indices... indices) const {
+    check_indices(indices...);
+    return (*this)(indices...);
+  }
+
+  [[nodiscard]] static constexpr rank_type rank() noexcept {
+    return extents_type::rank();
+  }
+
+  [[nodiscard]] static constexpr rank_type rank_dynamic() noexcept {
+    return extents_type::rank_dynamic();
+  }
+
+  [[nodiscard]] const extents_type &extents() const noexcept {
+    return mapping_.extents();
+  }
+
+  [[nodiscard]] index_type extent(const rank_type r) const noexcept {
+    return extents().extent(r);
+  }
+
+  [[nodiscard]] const mapping_type &mapping() const noexcept {
+    return mapping_;
+  }
+
+  // number of elements, the container may hold more for padded layouts
+  [[nodiscard]] std::size_t size() const noexcept { return extents().size(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] pointer data() noexcept { return container_.data(); }
+
+  [[nodiscard]] const_pointer data() const noexcept {
+    return container_.data();
+  }
+
+  [[nodiscard]] const container_type &container() const noexcept {
+    return container_;
+  }
+
+  [[nodiscard]] view_type view() noexcept {
+    return view_type{container_.data(), mapping_};
+  }
+
+  [[nodiscard]] const_view_type view() const noexcept {
+    return const_view_type{container_.data(), mapping_};
+  }
+
+  // calls fn(indices...) for all indices in order of their offsets
+  template <typename Fn> void for_each_index(Fn &&fn) const {
+    mapping_.for_each_index(fn);
+  }
+
+  void swap(basic_heap_mdarray &other) noexcept(
+      std::is_nothrow_swappable_v<mapping_type> &&
+      std::is_nothrow_swappable_v<container_type>) {
+    using std::swap;
+    swap(mapping_, other.mapping_);
+    swap(container_, other.container_);
+  }
+
+  friend void swap(basic_heap_mdarray &lhs,
+                   basic_heap_mdarray &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+  }
+
+  friend bool operator==(const basic_heap_mdarray &lhs,
+                         const basic_heap_mdarray &rhs) {
+    return lhs.mapping_ == rhs.mapping_ && lhs.container_ == rhs.container_;
+  }
+
+  friend bool operator!=(const basic_heap_mdarray &lhs,
+                         const basic_heap_mdarray &rhs) {
+    return !(lhs == rhs);
+  }
+
+private:
+  using container_size_type = typename container_type::size_type;
+
+  mapping_type mapping_{};
+  container_type container_{};
+
+  [[nodiscard]] static container_size_type
+  container_size(const mapping_type &mapping) {
+    return static_cast<container_size_type>(mapping.required_span_size());
+  }
+
+  template <typename... Indices>
+  void check_indices(const Indices... indices) const {
+    static_assert(sizeof...(Indices) == extents_type::rank(),
+                  "Number of indices has to match the rank");
+    const std::array<index_type, sizeof...(Indices)> values{
+        static_cast<index_type>(indices)...};
+    for (rank_type r{}; r < extents_type::rank(); ++r) {
+      if constexpr (std::is_signed_v<index_type>) {
+        if (values[r] < 0) {
+          throw std::out_of_range(
+              "Trying to access element which is out of range");
+        }
+      }
+      if (values[r] >= extent(r)) {
+        throw std::out_of_range(
+            "Trying to access element which is out of range");
+      }
+    }
+  }
+};
+
+// array of Rank dimensions with extents known at runtime
+template <typename T, std::size_t Rank, typename Layout = layout_right,
+          typename SizeType = std::uint64_t>
+using heap_mdarray =
+    basic_heap_mdarray<T, dextents<SizeType, Rank>, Layout,
+                       heap_array<T, SizeType>>;
+
+template <typename T, typename Extents, typename Layout, typename Container>
+struct is_trivially_relocatable<
+    basic_heap_mdarray<T, Extents, Layout, Container>>
+    : std::conjunction<
+          is_trivially_relocatable<typename basic_heap_mdarray<
+              T, Extents, Layout, Container>::mapping_type>,
+          is_trivially_relocatable<Container>> {};
+
+} // namespace vlrx
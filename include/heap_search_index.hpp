@@ -0,0 +1,239 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vlrx {
+
+namespace detail {
+
+// number of lowest bits of value which are set
+[[nodiscard]] inline unsigned
+trailing_ones(const std::uint64_t value) noexcept {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(
+      __builtin_ctzll(~static_cast<unsigned long long>(value)));
+#else
+  unsigned ones{};
+  while ((value >> ones & 1) != 0) {
+    ++ones;
+  }
+  return ones;
+#endif
+}
+
+// number of bits needed to represent value
+[[nodiscard]] inline unsigned bit_width(const std::uint64_t value) noexcept {
+#if defined(__GNUC__)
+  return value == 0 ? 0
+                    : static_cast<unsigned>(
+                          std::numeric_limits<unsigned long long>::digits -
+                          __builtin_clzll(
+                              static_cast<unsigned long long>(value)));
+#else
+  unsigned width{};
+  while ((value >> width) != 0) {
+    ++width;
+  }
+  return width;
+#endif
+}
+
+inline void prefetch([[maybe_unused]] const void *address) noexcept {
+#if defined(__GNUC__)
+  __builtin_prefetch(address);
+#endif
+}
+
+} // namespace detail
+
+// Read-only index over sorted keys which answers lower_bound queries several
+// times faster than std::lower_bound on tables much bigger than the cache.
+//
+// Keys are copied in Eytzinger order: the root at index 1 and the children
+// of node k at 2k and 2k + 1, so a search reads nodes which are close to
+// each other in memory, and the 2^d descendants of a node d levels below it
+// are adjacent. Each step prefetches the cache line of the descendants
+// log2(cache_line_size / sizeof(T)) levels deep and chooses the child
+// without a branch. Batched lookups interleave many queries, so their cache
+// misses overlap instead of being waited for one by one.
+//
+// Positions returned by lookups refer to the sorted keys the index was
+// built from. Searches walk one level past the leaves, so an index holds at
+// most half of the maximum of SizeType keys.
+template <typename T, typename SizeType = std::uint64_t,
+          typename Compare = std::less<T>,
+          typename Allocator = heap_allocator<T>>
+class heap_search_index final {
+public:
+  using value_type = T;
+  using size_type = SizeType;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+
+  // number of queries interleaved by batched lookups
+  static constexpr size_type batch_size{32};
+
+  heap_search_index() = default;
+
+  // Builds the index from keys sorted by compare, e.g. a heap_array, a
+  // std::vector or a std::span.
+  template <typename Range, typename = decltype(std::size(
+                                std::declval<const Range &>()))>
+  explicit heap_search_index(const Range &sorted,
+                             const key_compare &compare = key_compare(),
+                             const allocator_type &alloc = allocator_type())
+      : size_{checked_size(std::size(sorted))},
+        levels_{static_cast<size_type>(detail::bit_width(size_))},
+        compare_{compare},
+        nodes_(size_ == 0 ? 0 : size_ + 1, from_generator,
+               [&, first = std::begin(sorted)](const size_type node) {
+                 // the first slot is unused, it keeps the root aligned
+                 return first[static_cast<std::ptrdiff_t>(
+                     node == 0 ? 0 : position_of(node))];
+               },
+               alloc) {
+    assert(std::is_sorted(std::begin(sorted), std::end(sorted), compare_));
+  }
+
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  // position of the first key which is not less than key, or size() if
+  // there is none
+  [[nodiscard]] size_type lower_bound(const value_type &key) const {
+    return position_of(find_node(key));
+  }
+
+  [[nodiscard]] bool contains(const value_type &key) const {
+    const auto node = find_node(key);
+    return node != 0 && !compare_(key, nodes_[node]);
+  }
+
+  // positions[i] = lower_bound(keys[i]) for i < count
+  void lower_bound(const value_type *keys, const size_type count,
+                   size_type *positions) const {
+    find_nodes(keys, count, [&](const size_type idx, const size_type node) {
+      positions[idx] = position_of(node);
+    });
+  }
+
+  // found[i] = contains(keys[i]) for i < count
+  void contains(const value_type *keys, const size_type count,
+                bool *found) const {
+    find_nodes(keys, count, [&](const size_type idx, const size_type node) {
+      found[idx] = node != 0 && !compare_(keys[idx], nodes_[node]);
+    });
+  }
+
+private:
+  // number of descendants log2(prefetch_stride) levels below a node, which
+  // share a cache line
+  static constexpr size_type prefetch_stride{
+      sizeof(value_type) < cache_line_size
+          ? cache_line_size / sizeof(value_type)
+          : 1};
+
+  size_type size_{};
+  // depth of the deepest leaves plus one
+  size_type levels_{};
+  key_compare compare_{};
+  // nodes in Eytzinger order starting at index 1, aligned so that the
+  // descendants prefetched together are in the same cache line
+  heap_array<value_type, size_type, allocator_type, cache_line_layout> nodes_;
+
+  void prefetch_descendants(const size_type node) const noexcept {
+    // the address may be past the end of the buffer, which prefetch ignores
+    detail::prefetch(reinterpret_cast<const void *>(
+        reinterpret_cast<std::uintptr_t>(nodes_.data()) +
+        static_cast<std::uintptr_t>(node) * prefetch_stride *
+            sizeof(value_type)));
+  }
+
+  // node indices reach 2 * size + 1 during a search
+  [[nodiscard]] static size_type checked_size(const std::size_t size) {
+    if (size > std::numeric_limits<size_type>::max() / 2) {
+      throw std::length_error("Too many keys for size_type of the index");
+    }
+    return static_cast<size_type>(size);
+  }
+
+  // The search goes right while nodes are less than key, so the answer is
+  // the last node where it went left: the path with its trailing right turns
+  // and the final left turn dropped. Zero if it never went left.
+  [[nodiscard]] static size_type answer_of(const size_type path) noexcept {
+    return path >> (detail::trailing_ones(path) + 1);
+  }
+
+  [[nodiscard]] size_type find_node(const value_type &key) const {
+    const auto *nodes = nodes_.data();
+    size_type node{1};
+    while (node <= size_) {
+      prefetch_descendants(node);
+      node = 2 * node + static_cast<size_type>(compare_(nodes[node], key));
+    }
+    return answer_of(node);
+  }
+
+  // Walks batch_size queries down the tree one level at a time. Searches
+  // which end a level early take one more right turn past the leaves, which
+  // does not change the answer.
+  template <typename Fn>
+  void find_nodes(const value_type *keys, const size_type count,
+                  Fn &&fn) const {
+    const auto *nodes = nodes_.data();
+    size_type paths[batch_size];
+    for (size_type first{}; first < count; first += batch_size) {
+      const auto batch = std::min(batch_size, count - first);
+      std::fill_n(paths, batch, size_type{1});
+      for (size_type level{}; level < levels_; ++level) {
+        for (size_type idx{}; idx < batch; ++idx) {
+          const auto node = paths[idx];
+          const bool past_leaves = node > size_;
+          const bool right = compare_(nodes[past_leaves ? 0 : node],
+                                      keys[first + idx]);
+          paths[idx] = 2 * node + static_cast<size_type>(past_leaves | right);
+          detail::prefetch(nodes + std::min(paths[idx], size_));
+        }
+      }
+      for (size_type idx{}; idx < batch; ++idx) {
+        fn(first + idx, answer_of(paths[idx]));
+      }
+    }
+  }
+
+  // Position of node in sorted order, or size_ for node 0. Nodes are first
+  // placed into a perfect tree with levels_ levels, then the missing leaves
+  // on the left of the node are subtracted.
+  [[nodiscard]] size_type position_of(const size_type node) const noexcept {
+    if (node == 0) {
+      return size_;
+    }
+    const auto depth = detail::bit_width(node) - 1;
+    const auto perfect_position = static_cast<size_type>(
+        ((2 * (node - (size_type{1} << depth)) + 1) << (levels_ - 1 - depth)) -
+        1);
+    // leaves of the perfect tree are at even positions, the deepest level
+    // holds only the leftmost of them
+    const auto deepest_leaves =
+        static_cast<size_type>(size_ + 1 - (size_type{1} << (levels_ - 1)));
+    const auto leaves_before =
+        static_cast<size_type>((perfect_position + 1) / 2);
+    return static_cast<size_type>(
+        perfect_position -
+        (leaves_before - std::min(deepest_leaves, leaves_before)));
+  }
+};
+
+} // namespace vlrx
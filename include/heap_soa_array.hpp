@@ -0,0 +1,515 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace vlrx {
+
+// Non-owning view of contiguous elements, returned by column accessors of
+// heap_soa_array.
+template <typename T, typename SizeType = std::uint64_t> class column_span {
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using size_type = SizeType;
+  using pointer = T *;
+  using reference = T &;
+  using iterator =
+      detail::random_access_iterator<value_type, std::is_const_v<T>>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  column_span() noexcept = default;
+
+  column_span(const pointer data, const size_type size) noexcept
+      : data_{data}, size_{size} {}
+
+  [[nodiscard]] reference operator[](const size_type pos) const noexcept {
+    assert(pos < size_);
+    return data_[pos];
+  }
+
+  [[nodiscard]] reference front() const noexcept { return data_[0]; }
+
+  [[nodiscard]] reference back() const noexcept { return data_[size_ - 1]; }
+
+  [[nodiscard]] pointer data() const noexcept { return data_; }
+
+  iterator begin() const noexcept { return iterator{data_}; }
+
+  iterator end() const noexcept { return iterator{data_ + size_}; }
+
+  reverse_iterator rbegin() const noexcept { return reverse_iterator{end()}; }
+
+  reverse_iterator rend() const noexcept { return reverse_iterator{begin()}; }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+private:
+  pointer data_{};
+  size_type size_{};
+};
+
+namespace detail {
+
+// Random access iterator over rows of heap_soa_array, dereferencing yields a
+// tuple of references to the fields of the row.
+template <bool is_const, typename... Ts>
+class [[nodiscard]] zip_iterator final {
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::tuple<Ts...>;
+  using reference = std::conditional_t<is_const, std::tuple<const Ts &...>,
+                                       std::tuple<Ts &...>>;
+  using pointer = void;
+  using iterator_category = std::random_access_iterator_tag;
+  using columns_type = std::conditional_t<is_const, std::tuple<const Ts *...>,
+                                          std::tuple<Ts *...>>;
+
+  zip_iterator() noexcept = default;
+
+  zip_iterator(const columns_type &columns,
+               const difference_type index) noexcept
+      : columns_{columns}, index_{index} {}
+
+  template <bool is_const_ = is_const,
+            typename std::enable_if_t<is_const_, int> = 1>
+  zip_iterator(const zip_iterator<false, Ts...> &other) noexcept
+      : columns_{other.columns_}, index_{other.index_} {}
+
+  reference operator*() const noexcept {
+    return std::apply(
+        [this](const auto... columns) { return reference{columns[index_]...}; },
+        columns_);
+  }
+
+  reference operator[](const difference_type shift) const noexcept {
+    return *(*this + shift);
+  }
+
+  zip_iterator &operator++() noexcept {
+    ++index_;
+    return *this;
+  }
+
+  zip_iterator operator++(int) noexcept {
+    auto retval = *this;
+    ++index_;
+    return retval;
+  }
+
+  zip_iterator &operator--() noexcept {
+    --index_;
+    return *this;
+  }
+
+  zip_iterator operator--(int) noexcept {
+    auto retval = *this;
+    --index_;
+    return retval;
+  }
+
+  zip_iterator &operator+=(const difference_type shift) noexcept {
+    index_ += shift;
+    return *this;
+  }
+
+  zip_iterator &operator-=(const difference_type shift) noexcept {
+    index_ -= shift;
+    return *this;
+  }
+
+  friend zip_iterator operator+(const zip_iterator &iter,
+                                const difference_type shift) noexcept {
+    return zip_iterator{iter.columns_, iter.index_ + shift};
+  }
+
+  friend zip_iterator operator+(const difference_type shift,
+                                const zip_iterator &iter) noexcept {
+    return zip_iterator{iter.columns_, iter.index_ + shift};
+  }
+
+  friend zip_iterator operator-(const zip_iterator &iter,
+                                const difference_type shift) noexcept {
+    return zip_iterator{iter.columns_, iter.index_ - shift};
+  }
+
+  friend difference_type operator-(const zip_iterator &lhs,
+                                   const zip_iterator &rhs) noexcept {
+    return lhs.index_ - rhs.index_;
+  }
+
+  friend bool operator==(const zip_iterator &lhs,
+                         const zip_iterator &rhs) noexcept {
+    return lhs.index_ == rhs.index_;
+  }
+
+  friend bool operator!=(const zip_iterator &lhs,
+                         const zip_iterator &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator<(const zip_iterator &lhs,
+                        const zip_iterator &rhs) noexcept {
+    return lhs.index_ < rhs.index_;
+  }
+
+  friend bool operator>(const zip_iterator &lhs,
+                        const zip_iterator &rhs) noexcept {
+    return rhs < lhs;
+  }
+
+  friend bool operator<=(const zip_iterator &lhs,
+                         const zip_iterator &rhs) noexcept {
+    return !(lhs > rhs);
+  }
+
+  friend bool operator>=(const zip_iterator &lhs,
+                         const zip_iterator &rhs) noexcept {
+    return !(lhs < rhs);
+  }
+
+private:
+  template <bool, typename...> friend class zip_iterator;
+
+  columns_type columns_{};
+  difference_type index_{};
+};
+
+// row source constructing each field with value-initialization
+struct value_initialized_row {};
+
+} // namespace detail
+
+// Fixed-size structure-of-arrays container: i-th row consists of i-th
+// elements of columns of types Ts..., each column is contiguous and aligned
+// to a cache line. All columns share one heap buffer.
+template <typename SizeType, typename... Ts>
+class basic_heap_soa_array final {
+  static_assert(sizeof...(Ts) > 0, "There has to be at least one column");
+
+public:
+  using size_type = SizeType;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::tuple<Ts...>;
+  using reference = std::tuple<Ts &...>;
+  using const_reference = std::tuple<const Ts &...>;
+  using iterator = detail::zip_iterator<false, Ts...>;
+  using const_iterator = detail::zip_iterator<true, Ts...>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  template <std::size_t I>
+  using column_type = std::tuple_element_t<I, value_type>;
+
+  static constexpr std::size_t column_count = sizeof...(Ts);
+  // guaranteed alignment of every column
+  static constexpr std::size_t alignment =
+      std::max({cache_line_size, alignof(Ts)...});
+
+  basic_heap_soa_array() noexcept = default;
+
+  // value-initializes all fields of size rows
+  explicit basic_heap_soa_array(const size_type size) {
+    allocate(size);
+    if constexpr ((detail::is_zero_initializable_v<Ts> && ...)) {
+      if (size > 0) {
+        std::memset(std::get<0>(columns_), 0,
+                    block_count(size) * sizeof(block_type));
+      }
+    } else {
+      construct_rows([](size_type) { return detail::value_initialized_row{}; });
+    }
+  }
+
+  // every row is a copy of values
+  basic_heap_soa_array(const size_type size, const Ts &...values) {
+    allocate(size);
+    construct_rows([&](size_type) { return std::forward_as_tuple(values...); });
+  }
+
+  // builds fields of i-th row in place from std::get<I>(generator(i))
+  template <typename Generator>
+  basic_heap_soa_array(const size_type size, from_generator_t,
+                       Generator &&generator) {
+    allocate(size);
+    construct_rows([&](const size_type row) { return generator(row); });
+  }
+
+  basic_heap_soa_array(const basic_heap_soa_array &other) {
+    allocate(other.size_);
+    if constexpr ((std::is_trivially_copy_constructible_v<Ts> && ...)) {
+      copy_columns(other, std::index_sequence_for<Ts...>{});
+    } else {
+      construct_rows([&](const size_type row) { return other[row]; });
+    }
+  }
+
+  basic_heap_soa_array &operator=(const basic_heap_soa_array &other) {
+    if (this != &other) {
+      basic_heap_soa_array copy{other};
+      swap(copy);
+    }
+    return *this;
+  }
+
+  basic_heap_soa_array(basic_heap_soa_array &&other) noexcept
+      : columns_{std::exchange(other.columns_, columns_type{})},
+        size_{std::exchange(other.size_, 0)} {}
+
+  basic_heap_soa_array &operator=(basic_heap_soa_array &&other) noexcept {
+    if (this != &other) {
+      basic_heap_soa_array moved{std::move(other)};
+      swap(moved);
+    }
+    return *this;
+  }
+
+  ~basic_heap_soa_array() {
+    destroy_rows(size_, 0, std::index_sequence_for<Ts...>{});
+    deallocate();
+  }
+
+  template <std::size_t I>
+  [[nodiscard]] column_span<column_type<I>, size_type> column() noexcept {
+    return {std::get<I>(columns_), size_};
+  }
+
+  template <std::size_t I>
+  [[nodiscard]] column_span<const column_type<I>, size_type>
+  column() const noexcept {
+    return {std::get<I>(columns_), size_};
+  }
+
+  [[nodiscard]] reference operator[](const size_type pos) noexcept {
+    assert(pos < size_);
+    return begin()[static_cast<difference_type>(pos)];
+  }
+
+  [[nodiscard]] const_reference operator[](const size_type pos) const noexcept {
+    assert(pos < size_);
+    return begin()[static_cast<difference_type>(pos)];
+  }
+
+  [[nodiscard]] reference at(const size_type pos) {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return (*this)[pos];
+  }
+
+  [[nodiscard]] const_reference at(const size_type pos) const {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return (*this)[pos];
+  }
+
+  iterator begin() noexcept { return iterator{columns_, 0}; }
+
+  const_iterator begin() const noexcept {
+    return const_iterator{columns_, 0};
+  }
+
+  const_iterator cbegin() const noexcept { return begin(); }
+
+  iterator end() noexcept {
+    return iterator{columns_, static_cast<difference_type>(size_)};
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator{columns_, static_cast<difference_type>(size_)};
+  }
+
+  const_iterator cend() const noexcept { return end(); }
+
+  reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] size_type max_size() const noexcept { return size_; }
+
+  void swap(basic_heap_soa_array &other) noexcept {
+    std::swap(columns_, other.columns_);
+    std::swap(size_, other.size_);
+  }
+
+  friend void swap(basic_heap_soa_array &lhs,
+                   basic_heap_soa_array &rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  friend bool operator==(const basic_heap_soa_array &lhs,
+                         const basic_heap_soa_array &rhs) {
+    return lhs.equal_columns(rhs, std::index_sequence_for<Ts...>{});
+  }
+
+  friend bool operator!=(const basic_heap_soa_array &lhs,
+                         const basic_heap_soa_array &rhs) {
+    return !(lhs == rhs);
+  }
+
+private:
+  using columns_type = std::tuple<Ts *...>;
+  using block_type = typename std::aligned_storage<alignment, alignment>::type;
+
+  columns_type columns_{};
+  size_type size_{};
+
+  // offset of I-th column in the buffer, offset of the end of the last
+  // column for I == column_count
+  template <std::size_t I>
+  [[nodiscard]] static constexpr std::size_t
+  column_offset(const std::size_t size) noexcept {
+    if constexpr (I == 0) {
+      return 0;
+    } else {
+      return (column_offset<I - 1>(size) + size * sizeof(column_type<I - 1>) +
+              alignment - 1) /
+             alignment * alignment;
+    }
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  block_count(const size_type size) noexcept {
+    return column_offset<column_count>(static_cast<std::size_t>(size)) /
+           alignment;
+  }
+
+  template <std::size_t... Is>
+  [[nodiscard]] static columns_type
+  set_up_columns(unsigned char *buffer, const std::size_t size,
+                 std::index_sequence<Is...>) noexcept {
+    return columns_type{
+        reinterpret_cast<Ts *>(buffer + column_offset<Is>(size))...};
+  }
+
+  void allocate(const size_type size) {
+    if (size == 0) {
+      return;
+    }
+    constexpr auto row_bytes = (sizeof(Ts) + ...);
+    if (static_cast<std::size_t>(size) >
+        (std::numeric_limits<std::size_t>::max() -
+         column_count * alignment) /
+            row_bytes) {
+      throw std::bad_array_new_length();
+    }
+    const auto blocks =
+        heap_allocator<block_type>{}.allocate(block_count(size));
+    columns_ = set_up_columns(reinterpret_cast<unsigned char *>(blocks),
+                              static_cast<std::size_t>(size),
+                              std::index_sequence_for<Ts...>{});
+    size_ = size;
+  }
+
+  void deallocate() noexcept {
+    if (size_ > 0) {
+      heap_allocator<block_type>{}.deallocate(
+          reinterpret_cast<block_type *>(std::get<0>(columns_)),
+          block_count(size_));
+      columns_ = columns_type{};
+      size_ = 0;
+    }
+  }
+
+  // fields of i-th row are constructed from make_row(i), already
+  // constructed fields are destroyed and the buffer is released if any of
+  // constructors throws
+  template <typename MakeRow> void construct_rows(MakeRow &&make_row) {
+    construct_rows(make_row, std::index_sequence_for<Ts...>{});
+  }
+
+  template <typename MakeRow, std::size_t... Is>
+  void construct_rows(MakeRow &make_row, std::index_sequence<Is...>) {
+    size_type row{};
+    std::size_t column{};
+    try {
+      for (; row < size_; ++row) {
+        column = 0;
+        auto source = make_row(row);
+        ((construct_field<Is>(row, source), ++column), ...);
+      }
+    } catch (...) {
+      destroy_rows(row, column, std::index_sequence<Is...>{});
+      deallocate();
+      throw;
+    }
+  }
+
+  template <std::size_t I, typename Source>
+  void construct_field(const size_type row, Source &source) {
+    const auto field = static_cast<void *>(std::get<I>(columns_) + row);
+    if constexpr (std::is_same_v<Source, detail::value_initialized_row>) {
+      ::new (field) column_type<I>();
+    } else {
+      ::new (field) column_type<I>(std::get<I>(std::move(source)));
+    }
+  }
+
+  // destroys fields of rows [0, rows) and the first columns fields of the
+  // next row
+  template <std::size_t... Is>
+  void destroy_rows(const size_type rows, const std::size_t columns,
+                    std::index_sequence<Is...>) noexcept {
+    (destroy_column<Is>(rows + (Is < columns ? 1 : 0)), ...);
+  }
+
+  template <std::size_t I>
+  void destroy_column(const size_type count) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<column_type<I>>) {
+      std::destroy_n(std::get<I>(columns_), count);
+    }
+  }
+
+  template <std::size_t... Is>
+  void copy_columns(const basic_heap_soa_array &other,
+                    std::index_sequence<Is...>) noexcept {
+    if (size_ > 0) {
+      (std::memcpy(static_cast<void *>(std::get<Is>(columns_)),
+                   static_cast<const void *>(std::get<Is>(other.columns_)),
+                   sizeof(Ts) * size_),
+       ...);
+    }
+  }
+
+  template <std::size_t... Is>
+  [[nodiscard]] bool equal_columns(const basic_heap_soa_array &other,
+                                   std::index_sequence<Is...>) const {
+    return size_ == other.size_ &&
+           (std::equal(std::get<Is>(columns_), std::get<Is>(columns_) + size_,
+                       std::get<Is>(other.columns_)) &&
+            ...);
+  }
+};
+
+template <typename... Ts>
+using heap_soa_array = basic_heap_soa_array<std::uint64_t, Ts...>;
+
+} // namespace vlrx
@@ -0,0 +1,346 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vlrx {
+
+namespace detail {
+
+inline constexpr char file_magic[8] = {'V', 'L', 'R', 'X', 'H', 'A', 'R', 'R'};
+inline constexpr std::uint32_t file_version{1};
+inline constexpr std::uint32_t file_byte_order_mark{0x01020304};
+inline constexpr std::size_t file_header_size{64};
+
+// Header of the file written by save_to_file, elements follow it starting at
+// data_offset.
+struct file_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order_mark;
+  std::uint64_t data_offset;
+  std::uint64_t element_size;
+  std::uint64_t element_alignment;
+  std::uint64_t count;
+  std::uint64_t checksum;
+  std::uint64_t reserved;
+};
+
+static_assert(sizeof(file_header) == file_header_size);
+
+[[nodiscard]] inline std::uint64_t mix(std::uint64_t value) noexcept {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// 64-bit checksum processing 8 bytes at a time
+[[nodiscard]] inline std::uint64_t checksum(const void *data,
+                                            const std::size_t size) noexcept {
+  const auto bytes = static_cast<const unsigned char *>(data);
+  std::uint64_t hash{0x9e3779b97f4a7c15ULL ^ size};
+  std::size_t offset{};
+  for (; offset + sizeof(std::uint64_t) <= size;
+       offset += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes + offset, sizeof(word));
+    hash = (hash ^ mix(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  std::uint64_t tail{};
+  if (size > offset) {
+    std::memcpy(&tail, bytes + offset, size - offset);
+  }
+  return mix(hash ^ mix(tail));
+}
+
+[[nodiscard]] constexpr std::uint64_t data_offset(
+    const std::size_t alignment) noexcept {
+  return alignment > file_header_size ? alignment : file_header_size;
+}
+
+// writes size bytes to fd, retrying short and interrupted writes
+[[nodiscard]] inline bool write_all(const int fd, const void *data,
+                                    std::size_t size) noexcept {
+  auto bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    const auto written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+} // namespace detail
+
+// Writes elements of array to path in a versioned binary layout, which may be
+// mapped with mapped_array_view. The file is written to path + ".tmp", synced
+// and renamed over path, so readers never see a partially written file and
+// views of the previous file keep their contents.
+template <typename VType, typename SType, typename Alloc, typename LType>
+void save_to_file(const heap_array<VType, SType, Alloc, LType> &array,
+                  const std::string &path) {
+  static_assert(std::is_trivially_copyable_v<VType>,
+                "Only trivially copyable types may be saved to file");
+  const auto bytes = sizeof(VType) * static_cast<std::size_t>(array.size());
+  detail::file_header header{};
+  std::memcpy(header.magic, detail::file_magic, sizeof(header.magic));
+  header.version = detail::file_version;
+  header.byte_order_mark = detail::file_byte_order_mark;
+  header.data_offset = detail::data_offset(alignof(VType));
+  header.element_size = sizeof(VType);
+  header.element_alignment = alignof(VType);
+  header.count = static_cast<std::uint64_t>(array.size());
+  header.checksum = detail::checksum(array.data(), bytes);
+
+  std::string prefix(static_cast<std::size_t>(header.data_offset), '\0');
+  std::memcpy(prefix.data(), &header, sizeof(header));
+
+  const auto temporary = path + ".tmp";
+  const int fd = ::open(temporary.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "Failed to create " + temporary);
+  }
+  auto written = detail::write_all(fd, prefix.data(), prefix.size()) &&
+                 (bytes == 0 || detail::write_all(fd, array.data(), bytes)) &&
+                 ::fsync(fd) == 0;
+  auto error = errno;
+  if (::close(fd) != 0 && written) {
+    written = false;
+    error = errno;
+  }
+  if (!written) {
+    ::unlink(temporary.c_str());
+    throw std::system_error(error, std::generic_category(),
+                            "Failed to write heap_array to " + path);
+  }
+  std::error_code rename_error;
+  std::filesystem::rename(temporary, path, rename_error);
+  if (rename_error) {
+    ::unlink(temporary.c_str());
+    throw std::system_error(rename_error,
+                            "Failed to write heap_array to " + path);
+  }
+}
+
+// Read-only view of array saved with save_to_file. The file is mapped into
+// memory, so elements are paged in on access instead of being copied.
+template <typename T, typename SizeType = std::uint64_t>
+class mapped_array_view final {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Only trivially copyable types may be mapped from file");
+
+public:
+  using value_type = T;
+  using size_type = SizeType;
+  using const_reference = const value_type &;
+  using reference = const_reference;
+  using const_pointer = const value_type *;
+  using pointer = const_pointer;
+  using const_iterator = detail::random_access_iterator<value_type, true>;
+  using iterator = const_iterator;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using reverse_iterator = const_reverse_iterator;
+
+  mapped_array_view() noexcept = default;
+
+  explicit mapped_array_view(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "Failed to open " + path);
+    }
+    try {
+      map_file(fd, path);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+  mapped_array_view(const mapped_array_view &) = delete;
+
+  mapped_array_view &operator=(const mapped_array_view &) = delete;
+
+  mapped_array_view(mapped_array_view &&other) noexcept
+      : mapping_{std::exchange(other.mapping_, nullptr)},
+        mapping_length_{std::exchange(other.mapping_length_, 0)},
+        data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)},
+        checksum_{std::exchange(other.checksum_, 0)} {}
+
+  mapped_array_view &operator=(mapped_array_view &&other) noexcept {
+    if (this != &other) {
+      unmap();
+      mapping_ = std::exchange(other.mapping_, nullptr);
+      mapping_length_ = std::exchange(other.mapping_length_, 0);
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      checksum_ = std::exchange(other.checksum_, 0);
+    }
+    return *this;
+  }
+
+  ~mapped_array_view() { unmap(); }
+
+  // reads all elements, hence pages in the whole file
+  [[nodiscard]] bool verify_checksum() const noexcept {
+    return detail::checksum(data_, sizeof(value_type) *
+                                       static_cast<std::size_t>(size_)) ==
+           checksum_;
+  }
+
+  [[nodiscard]] const_reference at(const size_type pos) const {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return data_[pos];
+  }
+
+  [[nodiscard]] const_reference operator[](const size_type pos) const noexcept {
+    assert(pos < size_);
+    return data_[pos];
+  }
+
+  [[nodiscard]] const_reference front() const noexcept { return data_[0]; }
+
+  [[nodiscard]] const_reference back() const noexcept {
+    return data_[size_ - 1];
+  }
+
+  [[nodiscard]] const_pointer data() const noexcept { return data_; }
+
+  const_iterator begin() const noexcept { return const_iterator{data_}; }
+
+  const_iterator cbegin() const noexcept { return const_iterator{data_}; }
+
+  const_iterator end() const noexcept { return const_iterator{data_ + size_}; }
+
+  const_iterator cend() const noexcept {
+    return const_iterator{data_ + size_};
+  }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  const_reverse_iterator crbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  const_reverse_iterator crend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] size_type max_size() const noexcept { return size_; }
+
+private:
+  void *mapping_{};
+  std::size_t mapping_length_{};
+  const_pointer data_{};
+  size_type size_{};
+  std::uint64_t checksum_{};
+
+  void map_file(const int fd, const std::string &path) {
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) != 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "Failed to stat " + path);
+    }
+    const auto file_size = static_cast<std::uint64_t>(file_stat.st_size);
+    detail::file_header header{};
+    if (file_size < sizeof(header) ||
+        ::pread(fd, &header, sizeof(header), 0) !=
+            static_cast<ssize_t>(sizeof(header))) {
+      throw std::runtime_error(path + " is not a heap_array file");
+    }
+    validate(header, file_size, path);
+    checksum_ = header.checksum;
+    if (header.count == 0) {
+      return;
+    }
+    const auto length =
+        static_cast<std::size_t>(header.data_offset +
+                                 header.count * header.element_size);
+    void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+      throw std::system_error(errno, std::generic_category(),
+                              "Failed to map " + path);
+    }
+    mapping_ = mapping;
+    mapping_length_ = length;
+    data_ = reinterpret_cast<const_pointer>(static_cast<const char *>(mapping) +
+                                            header.data_offset);
+    size_ = static_cast<size_type>(header.count);
+  }
+
+  static void validate(const detail::file_header &header,
+                       const std::uint64_t file_size,
+                       const std::string &path) {
+    if (std::memcmp(header.magic, detail::file_magic, sizeof(header.magic)) !=
+        0) {
+      throw std::runtime_error(path + " is not a heap_array file");
+    }
+    if (header.version != detail::file_version) {
+      throw std::runtime_error(path + " has unsupported version");
+    }
+    if (header.byte_order_mark != detail::file_byte_order_mark) {
+      throw std::runtime_error(path + " has different byte order");
+    }
+    if (header.element_size != sizeof(value_type) ||
+        header.element_alignment != alignof(value_type) ||
+        header.data_offset != detail::data_offset(alignof(value_type))) {
+      throw std::runtime_error(path + " holds elements of different type");
+    }
+    if (file_size < header.data_offset ||
+        header.count > std::numeric_limits<size_type>::max() ||
+        header.count > (file_size - header.data_offset) / header.element_size) {
+      throw std::runtime_error(path + " is truncated");
+    }
+  }
+
+  void unmap() noexcept {
+    if (mapping_ != nullptr) {
+      ::munmap(mapping_, mapping_length_);
+    }
+  }
+};
+
+} // namespace vlrx
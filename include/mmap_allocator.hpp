@@ -0,0 +1,204 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+
+namespace vlrx {
+
+enum class huge_pages {
+  // regular pages only
+  none,
+  // transparent huge pages requested with madvise(MADV_HUGEPAGE)
+  transparent,
+  // pages from the hugetlbfs pool (MAP_HUGETLB), falls back to transparent
+  // huge pages when the pool is empty or not configured
+  explicit_pool,
+};
+
+inline constexpr std::size_t huge_page_size{std::size_t{2} << 20};
+
+// Stateless allocator which maps anonymous memory directly for buffers of at
+// least MinMappedBytes, and uses heap_allocator for smaller ones. Mapped
+// buffers are aligned to huge page size and released with munmap.
+template <typename T, huge_pages HugePages = huge_pages::transparent,
+          std::size_t MinMappedBytes = huge_page_size>
+class mmap_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+
+  template <typename U> struct rebind {
+    using other = mmap_allocator<U, HugePages, MinMappedBytes>;
+  };
+
+  mmap_allocator() noexcept = default;
+
+  template <typename U>
+  mmap_allocator(
+      const mmap_allocator<U, HugePages, MinMappedBytes> &) noexcept {}
+
+  [[nodiscard]] T *allocate(const std::size_t size) {
+    if (!is_mapped(size)) {
+      return heap_allocator<T>{}.allocate(size);
+    }
+    return static_cast<T *>(map(mapping_length(size)));
+  }
+
+  // mapped memory is always zeroed by the kernel
+  [[nodiscard]] T *allocate_zeroed(const std::size_t size) {
+    if (!is_mapped(size)) {
+      return heap_allocator<T>{}.allocate_zeroed(size);
+    }
+    return static_cast<T *>(map(mapping_length(size)));
+  }
+
+  // Mapped blocks are resized with mremap, which moves page table entries
+  // instead of copying the contents, smaller ones with realloc. A mapped
+  // block which can not grow in place is moved onto a huge page aligned
+  // reservation. Returns nullptr when the block would cross the mapping
+  // threshold, or when the kernel refuses to remap it.
+  [[nodiscard]] T *reallocate(T *ptr, const std::size_t old_size,
+                              const std::size_t new_size) noexcept {
+    if (is_mapped(old_size) != is_mapped(new_size)) {
+      return nullptr;
+    }
+    if (!is_mapped(new_size)) {
+      return heap_allocator<T>{}.reallocate(ptr, old_size, new_size);
+    }
+#if defined(MREMAP_MAYMOVE)
+    if (new_size > (std::numeric_limits<std::size_t>::max() - huge_page_size) /
+                       sizeof(T)) {
+      return nullptr;
+    }
+    const auto old_length = mapping_length(old_size);
+    const auto length = mapping_length(new_size);
+    void *remapped = ::mremap(static_cast<void *>(ptr), old_length, length, 0);
+    if (remapped == MAP_FAILED) {
+#if defined(MREMAP_FIXED)
+      // address picked by the kernel would not be huge page aligned
+      void *target = map_aligned(length, PROT_NONE, MAP_NORESERVE);
+      if (target == nullptr) {
+        return nullptr;
+      }
+      remapped = ::mremap(static_cast<void *>(ptr), old_length, length,
+                          MREMAP_MAYMOVE | MREMAP_FIXED, target);
+      if (remapped == MAP_FAILED) {
+        ::munmap(target, length);
+        return nullptr;
+      }
+#else
+      return nullptr;
+#endif
+    }
+    if constexpr (HugePages != huge_pages::none) {
+#if defined(MADV_HUGEPAGE)
+      ::madvise(remapped, length, MADV_HUGEPAGE);
+#endif
+    }
+    return static_cast<T *>(remapped);
+#else
+    return nullptr;
+#endif
+  }
+
+  void deallocate(T *ptr, const std::size_t size) noexcept {
+    if (!is_mapped(size)) {
+      heap_allocator<T>{}.deallocate(ptr, size);
+      return;
+    }
+    ::munmap(static_cast<void *>(ptr), mapping_length(size));
+  }
+
+  template <typename U>
+  friend bool operator==(
+      const mmap_allocator &,
+      const mmap_allocator<U, HugePages, MinMappedBytes> &) noexcept {
+    return true;
+  }
+
+  template <typename U>
+  friend bool operator!=(
+      const mmap_allocator &,
+      const mmap_allocator<U, HugePages, MinMappedBytes> &) noexcept {
+    return false;
+  }
+
+private:
+  static_assert(alignof(T) <= huge_page_size,
+                "Alignment of T can not exceed huge page size");
+
+  [[nodiscard]] static bool is_mapped(const std::size_t size) noexcept {
+    return size >= (MinMappedBytes + sizeof(T) - 1) / sizeof(T);
+  }
+
+  [[nodiscard]] static std::size_t mapping_length(const std::size_t size) {
+    if (size > (std::numeric_limits<std::size_t>::max() - huge_page_size) /
+                   sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return (size * sizeof(T) + huge_page_size - 1) / huge_page_size *
+           huge_page_size;
+  }
+
+  [[nodiscard]] static void *map(const std::size_t length) {
+    if constexpr (HugePages == huge_pages::explicit_pool) {
+#if defined(MAP_HUGETLB)
+      void *ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (ptr != MAP_FAILED) {
+        return ptr;
+      }
+#endif
+    }
+    void *ptr = map_aligned(length, PROT_READ | PROT_WRITE, 0);
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+    if constexpr (HugePages != huge_pages::none) {
+#if defined(MADV_HUGEPAGE)
+      // failure only means huge pages are not available, regular pages work
+      ::madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+    }
+    return ptr;
+  }
+
+  // maps one more huge page and trims the mapping, so it starts at huge page
+  // boundary and may be backed by transparent huge pages
+  [[nodiscard]] static void *map_aligned(const std::size_t length,
+                                         const int protection,
+                                         const int flags) noexcept {
+    const auto mapped_length = length + huge_page_size;
+    void *mapped = ::mmap(nullptr, mapped_length, protection,
+                          MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (mapped == MAP_FAILED) {
+      return nullptr;
+    }
+    const auto mapped_address = reinterpret_cast<std::uintptr_t>(mapped);
+    const auto address = (mapped_address + huge_page_size - 1) /
+                         huge_page_size * huge_page_size;
+    const auto head = address - mapped_address;
+    if (head > 0) {
+      ::munmap(mapped, head);
+    }
+    const auto tail = mapped_length - head - length;
+    if (tail > 0) {
+      ::munmap(reinterpret_cast<void *>(address + length), tail);
+    }
+    return reinterpret_cast<void *>(address);
+  }
+};
+
+template <typename T, typename SizeType = std::uint64_t,
+          huge_pages HugePages = huge_pages::transparent>
+using mmap_heap_array = heap_array<T, SizeType, mmap_allocator<T, HugePages>>;
+
+} // namespace vlrx
@@ -0,0 +1,668 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vlrx {
+
+namespace detail {
+
+// the narrowest unsigned type which holds Bits bits
+template <unsigned Bits>
+using packed_value_t = std::conditional_t<
+    Bits <= 8, std::uint8_t,
+    std::conditional_t<
+        Bits <= 16, std::uint16_t,
+        std::conditional_t<Bits <= 32, std::uint32_t, std::uint64_t>>>;
+
+template <typename T, bool = std::is_enum_v<T>> struct packed_integer {
+  using type = T;
+};
+
+template <typename T> struct packed_integer<T, true> {
+  using type = std::underlying_type_t<T>;
+};
+
+[[nodiscard]] inline unsigned popcount(std::uint64_t value) noexcept {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(
+      __builtin_popcountll(static_cast<unsigned long long>(value)));
+#else
+  unsigned count{};
+  for (; value != 0; value &= value - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+// index of the lowest set bit of value, which is not zero
+[[nodiscard]] inline unsigned
+trailing_zeros(const std::uint64_t value) noexcept {
+  assert(value != 0);
+#if defined(__GNUC__)
+  return static_cast<unsigned>(
+      __builtin_ctzll(static_cast<unsigned long long>(value)));
+#else
+  unsigned zeros{};
+  while ((value >> zeros & 1) == 0) {
+    ++zeros;
+  }
+  return zeros;
+#endif
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+inline constexpr bool is_little_endian{true};
+#else
+inline constexpr bool is_little_endian{false};
+#endif
+
+// Random access iterator over elements of a packed array. Like iterators of
+// std::vector<bool> it yields proxies (or values, if constant) instead of
+// references to elements.
+template <typename Array, bool is_const> class packed_iterator final {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = typename Array::value_type;
+  using difference_type = std::ptrdiff_t;
+  using reference = std::conditional_t<is_const, value_type,
+                                       typename Array::reference>;
+  using pointer = void;
+  using array_pointer = std::conditional_t<is_const, const Array *, Array *>;
+  using size_type = typename Array::size_type;
+
+  constexpr packed_iterator() noexcept : array_{}, idx_{} {}
+
+  constexpr packed_iterator(array_pointer array, const size_type idx) noexcept
+      : array_{array}, idx_{idx} {}
+
+  template <bool is_const_ = is_const,
+            typename std::enable_if<is_const_, int>::type = 1>
+  constexpr packed_iterator(const packed_iterator<Array, false> &other) noexcept
+      : array_{other.array_}, idx_{other.idx_} {}
+
+  reference operator*() const noexcept { return (*array_)[idx_]; }
+
+  reference operator[](const difference_type shift) const noexcept {
+    return (*array_)[static_cast<size_type>(
+        static_cast<difference_type>(idx_) + shift)];
+  }
+
+  constexpr packed_iterator &operator++() noexcept {
+    ++idx_;
+    return *this;
+  }
+
+  constexpr packed_iterator operator++(int) noexcept {
+    auto retval = *this;
+    ++idx_;
+    return retval;
+  }
+
+  constexpr packed_iterator &operator--() noexcept {
+    --idx_;
+    return *this;
+  }
+
+  constexpr packed_iterator operator--(int) noexcept {
+    auto retval = *this;
+    --idx_;
+    return retval;
+  }
+
+  constexpr packed_iterator &operator+=(const difference_type shift) noexcept {
+    idx_ = static_cast<size_type>(static_cast<difference_type>(idx_) + shift);
+    return *this;
+  }
+
+  constexpr packed_iterator &operator-=(const difference_type shift) noexcept {
+    return *this += -shift;
+  }
+
+  friend constexpr packed_iterator operator+(packed_iterator iter,
+                                             const difference_type shift) {
+    return iter += shift;
+  }
+
+  friend constexpr packed_iterator operator+(const difference_type shift,
+                                             packed_iterator iter) {
+    return iter += shift;
+  }
+
+  friend constexpr packed_iterator operator-(packed_iterator iter,
+                                             const difference_type shift) {
+    return iter -= shift;
+  }
+
+  friend constexpr difference_type operator-(const packed_iterator &lhs,
+                                             const packed_iterator &rhs) {
+    return static_cast<difference_type>(lhs.idx_) -
+           static_cast<difference_type>(rhs.idx_);
+  }
+
+  friend constexpr bool operator==(const packed_iterator &lhs,
+                                   const packed_iterator &rhs) {
+    return lhs.idx_ == rhs.idx_;
+  }
+
+  friend constexpr bool operator!=(const packed_iterator &lhs,
+                                   const packed_iterator &rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend constexpr bool operator<(const packed_iterator &lhs,
+                                  const packed_iterator &rhs) {
+    return lhs.idx_ < rhs.idx_;
+  }
+
+  friend constexpr bool operator>(const packed_iterator &lhs,
+                                  const packed_iterator &rhs) {
+    return rhs < lhs;
+  }
+
+  friend constexpr bool operator<=(const packed_iterator &lhs,
+                                   const packed_iterator &rhs) {
+    return !(rhs < lhs);
+  }
+
+  friend constexpr bool operator>=(const packed_iterator &lhs,
+                                   const packed_iterator &rhs) {
+    return !(lhs < rhs);
+  }
+
+private:
+  template <typename, bool> friend class packed_iterator;
+
+  array_pointer array_;
+  size_type idx_;
+};
+
+} // namespace detail
+
+// Fixed-size array of integers, bools or enums which keeps only the lowest
+// Bits bits of each element. Elements are packed into 64-bit words, each
+// holding 64 / Bits of them, so no element spans two words. The container
+// holds a heap_array of the words and the number of elements.
+//
+// Elements are accessed through proxy references, bulk operations (count,
+// find, fill, get and set of ranges, unpacking into a heap_array) process
+// whole words at once. Values which do not fit into Bits bits are truncated,
+// signed values are sign-extended when read.
+template <unsigned Bits, typename T = detail::packed_value_t<Bits>,
+          typename SizeType = std::uint64_t,
+          typename Allocator = heap_allocator<std::uint64_t>>
+class packed_heap_array final {
+  static_assert(Bits >= 1 && Bits <= 64, "Bits must be in [1, 64]");
+  static_assert(std::is_integral_v<T> || std::is_enum_v<T>,
+                "Elements must be integers, bools or enums");
+  static_assert(Bits <= sizeof(T) * CHAR_BIT, "T must have at least Bits bits");
+
+public:
+  using value_type = T;
+  using size_type = SizeType;
+  using word_type = std::uint64_t;
+  using allocator_type = Allocator;
+  using word_array =
+      heap_array<word_type, size_type, allocator_type, natural_layout>;
+
+  static constexpr unsigned bits{Bits};
+  static constexpr unsigned elements_per_word{64 / Bits};
+
+  // proxy of an element, assigning to it changes the element
+  class reference final {
+  public:
+    reference(const reference &) noexcept = default;
+
+    reference &operator=(const value_type value) noexcept {
+      array_->set_field(idx_, to_field(value));
+      return *this;
+    }
+
+    reference &operator=(const reference &other) noexcept {
+      return *this = static_cast<value_type>(other);
+    }
+
+    operator value_type() const noexcept {
+      return from_field(array_->field_at(idx_));
+    }
+
+    friend void swap(reference lhs, reference rhs) noexcept {
+      const value_type value{lhs};
+      lhs = rhs;
+      rhs = value;
+    }
+
+  private:
+    friend class packed_heap_array;
+
+    reference(packed_heap_array *array, const size_type idx) noexcept
+        : array_{array}, idx_{idx} {}
+
+    packed_heap_array *array_;
+    size_type idx_;
+  };
+
+  using const_reference = value_type;
+  using iterator = detail::packed_iterator<packed_heap_array, false>;
+  using const_iterator = detail::packed_iterator<packed_heap_array, true>;
+
+  packed_heap_array() = default;
+
+  explicit packed_heap_array(const allocator_type &alloc) noexcept
+      : words_{alloc} {}
+
+  // size elements equal to zero
+  explicit packed_heap_array(const size_type size,
+                             const allocator_type &alloc = allocator_type())
+      : words_(word_count(size), alloc), size_{size} {}
+
+  packed_heap_array(const size_type size, const value_type value,
+                    const allocator_type &alloc = allocator_type())
+      : words_(word_count(size), repeat(to_field(value)), alloc), size_{size} {
+    clear_padding();
+  }
+
+  // builds i-th element from generator(i), in order of indices
+  template <typename Generator>
+  packed_heap_array(const size_type size, from_generator_t,
+                    Generator &&generator,
+                    const allocator_type &alloc = allocator_type())
+      : words_(word_count(size), from_generator,
+               [&](const size_type word) {
+                 const auto first = word * elements_per_word;
+                 const auto slots = static_cast<unsigned>(
+                     std::min<size_type>(elements_per_word, size - first));
+                 word_type packed{};
+                 for (unsigned slot{}; slot < slots; ++slot) {
+                   packed |= to_field(generator(first + slot)) << slot * Bits;
+                 }
+                 return packed;
+               },
+               alloc),
+        size_{size} {}
+
+  packed_heap_array(std::initializer_list<value_type> values,
+                    const allocator_type &alloc = allocator_type())
+      : packed_heap_array(
+            static_cast<size_type>(values.size()), from_generator,
+            [&](const size_type idx) { return values.begin()[idx]; }, alloc) {
+  }
+
+  // packs the elements of a sized random access range, e.g. a heap_array
+  template <typename Range, typename = decltype(std::size(
+                                std::declval<const Range &>()))>
+  explicit packed_heap_array(const Range &values,
+                             const allocator_type &alloc = allocator_type())
+      : packed_heap_array(
+            static_cast<size_type>(std::size(values)), from_generator,
+            [first = std::begin(values)](const size_type idx) {
+              return static_cast<value_type>(
+                  first[static_cast<std::ptrdiff_t>(idx)]);
+            },
+            alloc) {}
+
+  packed_heap_array(const packed_heap_array &) = default;
+
+  packed_heap_array(packed_heap_array &&other) noexcept(
+      std::is_nothrow_move_constructible_v<word_array>)
+      : words_{std::move(other.words_)},
+        size_{std::exchange(other.size_, size_type{})} {}
+
+  packed_heap_array &operator=(const packed_heap_array &) = default;
+
+  packed_heap_array &operator=(packed_heap_array &&other) noexcept(
+      std::is_nothrow_move_assignable_v<word_array>) {
+    words_ = std::move(other.words_);
+    size_ = std::exchange(other.size_, size_type{});
+    return *this;
+  }
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept {
+    return words_.get_allocator();
+  }
+
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  // words holding the elements, element i is stored in bits
+  // [i % elements_per_word * Bits, ...) of word i / elements_per_word and
+  // the unused bits are zero
+  [[nodiscard]] const word_array &words() const noexcept { return words_; }
+
+  [[nodiscard]] value_type at(const size_type pos) const {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return (*this)[pos];
+  }
+
+  [[nodiscard]] reference at(const size_type pos) {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return (*this)[pos];
+  }
+
+  [[nodiscard]] value_type operator[](const size_type pos) const noexcept {
+    assert(pos < size_);
+    return from_field(field_at(pos));
+  }
+
+  [[nodiscard]] reference operator[](const size_type pos) noexcept {
+    assert(pos < size_);
+    return reference{this, pos};
+  }
+
+  [[nodiscard]] reference front() noexcept { return (*this)[0]; }
+
+  [[nodiscard]] value_type front() const noexcept { return (*this)[0]; }
+
+  [[nodiscard]] reference back() noexcept { return (*this)[size_ - 1]; }
+
+  [[nodiscard]] value_type back() const noexcept { return (*this)[size_ - 1]; }
+
+  iterator begin() noexcept { return iterator{this, 0}; }
+
+  const_iterator begin() const noexcept { return const_iterator{this, 0}; }
+
+  const_iterator cbegin() const noexcept { return begin(); }
+
+  iterator end() noexcept { return iterator{this, size_}; }
+
+  const_iterator end() const noexcept { return const_iterator{this, size_}; }
+
+  const_iterator cend() const noexcept { return end(); }
+
+  // number of elements equal to value
+  [[nodiscard]] size_type count(const value_type value) const noexcept {
+    const auto pattern = repeat(to_field(value));
+    const auto *words = words_.data();
+    const auto full_words = size_ / elements_per_word;
+    size_type result{};
+    for (size_type word{}; word < full_words; ++word) {
+      result += elements_per_word -
+                detail::popcount(nonzero_fields(words[word] ^ pattern));
+    }
+    if (const auto rest = static_cast<unsigned>(size_ % elements_per_word)) {
+      result += rest - detail::popcount(
+                           nonzero_fields(words[full_words] ^ pattern) &
+                           fields_mask(rest));
+    }
+    return result;
+  }
+
+  // index of the first element equal to value at or after from, or size()
+  // if there is none
+  [[nodiscard]] size_type find(const value_type value,
+                               const size_type from = 0) const noexcept {
+    if (from >= size_) {
+      return size_;
+    }
+    const auto pattern = repeat(to_field(value));
+    const auto *words = words_.data();
+    const auto word_total = word_count(size_);
+    auto word = from / elements_per_word;
+    // highest bits of the matching fields
+    const auto skipped = static_cast<unsigned>(from % elements_per_word);
+    auto matches = equal_fields(words[word] ^ pattern) & ~fields_mask(skipped);
+    while (matches == 0) {
+      if (++word == word_total) {
+        return size_;
+      }
+      matches = equal_fields(words[word] ^ pattern);
+    }
+    // unused fields of the last word may match zero
+    return std::min<size_type>(
+        size_, word * elements_per_word +
+                   detail::trailing_zeros(matches) / Bits);
+  }
+
+  void fill(const value_type value) noexcept {
+    std::fill(words_.begin(), words_.end(), repeat(to_field(value)));
+    clear_padding();
+  }
+
+  // out[i] = (*this)[first + i] for i < count
+  void get(const size_type first, const size_type count,
+           value_type *out) const noexcept {
+    assert(first <= size_ && count <= size_ - first);
+    const auto *words = words_.data();
+    for_each_word(first, count,
+                  [&](const size_type word, const unsigned slot,
+                      const unsigned slots) {
+                    if (slots == elements_per_word) {
+                      unpack_word(words[word], out);
+                    } else {
+                      const auto packed = words[word];
+                      for (unsigned next{}; next < slots; ++next) {
+                        out[next] = from_field(packed >> (slot + next) * Bits &
+                                               field_mask);
+                      }
+                    }
+                    out += slots;
+                  });
+  }
+
+  // (*this)[first + i] = values[i] for i < count
+  void set(const size_type first, const value_type *values,
+           const size_type count) noexcept {
+    assert(first <= size_ && count <= size_ - first);
+    auto *words = words_.data();
+    for_each_word(first, count,
+                  [&](const size_type word, const unsigned slot,
+                      const unsigned slots) {
+                    word_type packed{};
+                    for (unsigned next{}; next < slots; ++next) {
+                      packed |= to_field(values[next]) << (slot + next) * Bits;
+                    }
+                    words[word] = (words[word] &
+                                   ~(fields_mask(slots) << slot * Bits)) |
+                                  packed;
+                    values += slots;
+                  });
+  }
+
+  // copy of the elements in a plain array
+  template <typename ArrayAllocator = heap_allocator<value_type>>
+  [[nodiscard]] heap_array<value_type, size_type, ArrayAllocator>
+  to_heap_array(const ArrayAllocator &alloc = ArrayAllocator()) const {
+    heap_array<value_type, size_type, ArrayAllocator> result(
+        size_, for_overwrite, alloc);
+    get(0, size_, result.data());
+    return result;
+  }
+
+  void swap(packed_heap_array &other) noexcept {
+    words_.swap(other.words_);
+    std::swap(size_, other.size_);
+  }
+
+  friend void swap(packed_heap_array &lhs, packed_heap_array &rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // unused bits are zero, so equal arrays have equal words
+  friend bool operator==(const packed_heap_array &lhs,
+                         const packed_heap_array &rhs) {
+    return lhs.size_ == rhs.size_ && lhs.words_ == rhs.words_;
+  }
+
+  friend bool operator!=(const packed_heap_array &lhs,
+                         const packed_heap_array &rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator<(const packed_heap_array &lhs,
+                        const packed_heap_array &rhs) {
+    return detail::less_elements(lhs, rhs);
+  }
+
+  friend bool operator>(const packed_heap_array &lhs,
+                        const packed_heap_array &rhs) {
+    return rhs < lhs;
+  }
+
+  friend bool operator<=(const packed_heap_array &lhs,
+                         const packed_heap_array &rhs) {
+    return !(rhs < lhs);
+  }
+
+  friend bool operator>=(const packed_heap_array &lhs,
+                         const packed_heap_array &rhs) {
+    return !(lhs < rhs);
+  }
+
+private:
+  using integer_type = typename detail::packed_integer<value_type>::type;
+
+  static constexpr word_type field_mask{
+      Bits == 64 ? ~word_type{} : (word_type{1} << Bits % 64) - 1};
+
+  // mask of the lowest count fields of a word
+  [[nodiscard]] static constexpr word_type
+  fields_mask(const unsigned count) noexcept {
+    return count * Bits >= 64 ? ~word_type{}
+                              : (word_type{1} << count * Bits) - 1;
+  }
+
+  // word with field in each of its elements_per_word fields
+  [[nodiscard]] static constexpr word_type repeat(const word_type field) {
+    word_type word{};
+    for (unsigned slot{}; slot < elements_per_word; ++slot) {
+      word |= field << slot * Bits;
+    }
+    return word;
+  }
+
+  static constexpr word_type low_bits{repeat(field_mask >> 1)};
+  static constexpr word_type high_bits{repeat(word_type{1} << (Bits - 1))};
+
+  // Highest bit of each field of word which is not zero. Adding the lower
+  // bits of a field to all ones sets its highest bit unless they are zero,
+  // and no carry leaves the field.
+  [[nodiscard]] static word_type nonzero_fields(const word_type word) noexcept {
+    return (((word & low_bits) + low_bits) | word) & high_bits;
+  }
+
+  [[nodiscard]] static word_type equal_fields(const word_type diff) noexcept {
+    return ~nonzero_fields(diff) & high_bits;
+  }
+
+  [[nodiscard]] static word_type to_field(const value_type value) noexcept {
+    return static_cast<word_type>(static_cast<integer_type>(value)) &
+           field_mask;
+  }
+
+  [[nodiscard]] static value_type from_field(const word_type field) noexcept {
+    if constexpr (std::is_signed_v<integer_type> && Bits < 64) {
+      // moves the sign bit of the field to the top and shifts it back
+      constexpr unsigned unused{64 - Bits};
+      return static_cast<value_type>(static_cast<integer_type>(
+          static_cast<std::int64_t>(field << unused) >> unused));
+    } else {
+      return static_cast<value_type>(static_cast<integer_type>(field));
+    }
+  }
+
+  [[nodiscard]] static size_type word_count(const size_type size) noexcept {
+    return static_cast<size_type>(size / elements_per_word +
+                                  (size % elements_per_word != 0 ? 1 : 0));
+  }
+
+  word_array words_;
+  size_type size_{};
+
+  [[nodiscard]] word_type field_at(const size_type idx) const noexcept {
+    return words_.data()[idx / elements_per_word] >>
+               idx % elements_per_word * Bits &
+           field_mask;
+  }
+
+  void set_field(const size_type idx, const word_type field) noexcept {
+    auto &word = words_.data()[idx / elements_per_word];
+    const auto shift = static_cast<unsigned>(idx % elements_per_word * Bits);
+    word = (word & ~(field_mask << shift)) | field << shift;
+  }
+
+  // all elements of word, with constant shifts
+  static void unpack_word(const word_type word, value_type *out) noexcept {
+    if constexpr (Bits == 1 && sizeof(value_type) == 1 &&
+                  !std::is_signed_v<integer_type> &&
+                  detail::is_little_endian) {
+      // every byte of word is copied eight times, the i-th copy keeps only
+      // bit i, which is then moved to the lowest bit of the copy
+      for (unsigned byte{}; byte < 8; ++byte) {
+        auto bytes = (word >> byte * 8 & 0xFF) * 0x0101010101010101;
+        bytes &= 0x8040201008040201;
+        bytes = (bytes + 0x7F7F7F7F7F7F7F7F) >> 7 & 0x0101010101010101;
+        std::memcpy(out + byte * 8, &bytes, sizeof(bytes));
+      }
+    } else {
+      unpack_fields(word, out, std::make_index_sequence<elements_per_word>{});
+    }
+  }
+
+  template <std::size_t... slots>
+  static void unpack_fields(const word_type word, value_type *out,
+                            std::index_sequence<slots...>) noexcept {
+    ((out[slots] = from_field(word >> slots * Bits & field_mask)), ...);
+  }
+
+  // Calls fn(word, slot, slots) for the parts of words holding elements
+  // [first, first + count), slots elements from slot on. Whole words are
+  // passed with constant slots, so loops over them are unrolled and
+  // vectorized.
+  template <typename Fn>
+  static void for_each_word(const size_type first, const size_type count,
+                            Fn &&fn) {
+    const auto last = first + count;
+    auto idx = first;
+    if (const auto slot = static_cast<unsigned>(idx % elements_per_word);
+        slot != 0 && idx < last) {
+      const auto slots = static_cast<unsigned>(
+          std::min<size_type>(elements_per_word - slot, last - idx));
+      fn(idx / elements_per_word, slot, slots);
+      idx += slots;
+    }
+    for (; last - idx >= elements_per_word; idx += elements_per_word) {
+      fn(idx / elements_per_word, 0u, elements_per_word);
+    }
+    if (idx < last) {
+      fn(idx / elements_per_word, 0u, static_cast<unsigned>(last - idx));
+    }
+  }
+
+  // zeroes fields past the last element, which constructors and fill may
+  // have set
+  void clear_padding() noexcept {
+    if (const auto rest = static_cast<unsigned>(size_ % elements_per_word)) {
+      words_.back() &= fields_mask(rest);
+    }
+  }
+};
+
+// one bit per flag, an opt-in replacement of heap_array<bool>
+template <typename SizeType = std::uint64_t,
+          typename Allocator = heap_allocator<std::uint64_t>>
+using bit_heap_array = packed_heap_array<1, bool, SizeType, Allocator>;
+
+// words are held by a heap_array
+template <unsigned Bits, typename T, typename SizeType, typename Allocator>
+struct is_trivially_relocatable<
+    packed_heap_array<Bits, T, SizeType, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+
+} // namespace vlrx
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/mempolicy.h>)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace vlrx {
+
+// Executor running bulk tasks on up to concurrency threads, the calling
+// thread included. If a thread can not be started, its share of tasks is run
+// by the remaining ones.
+class thread_executor {
+public:
+  explicit thread_executor(
+      const unsigned concurrency = std::thread::hardware_concurrency())
+      : concurrency_{std::max(concurrency, 1u)} {}
+
+  [[nodiscard]] std::size_t concurrency() const noexcept {
+    return concurrency_;
+  }
+
+  // runs task(i) for each i in [0, count) and waits for all of them, the
+  // first exception thrown by a task is rethrown afterwards
+  template <typename Task>
+  void bulk(const std::size_t count, Task &&task) const {
+    std::atomic<std::size_t> next{};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto worker = [&] {
+      for (auto idx = next++; idx < count; idx = next++) {
+        try {
+          task(idx);
+        } catch (...) {
+          const std::lock_guard<std::mutex> lock{error_mutex};
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    const auto thread_count = std::min(count, concurrency_);
+    if (thread_count > 1) {
+      threads.reserve(thread_count - 1);
+      try {
+        while (threads.size() < thread_count - 1) {
+          threads.emplace_back(worker);
+        }
+      } catch (const std::system_error &) {
+      }
+    }
+    worker();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  std::size_t concurrency_;
+};
+
+// Where pages of the buffer are placed on NUMA systems.
+enum class numa_placement {
+  // on the node of the worker which touches the page first
+  first_touch,
+  // round-robin across all online nodes
+  interleaved,
+  // on the node passed to parallel_policy
+  bound,
+};
+
+namespace detail {
+
+inline constexpr std::size_t page_size{4096};
+
+// mask of online NUMA nodes, zero if it is not known
+[[nodiscard]] inline unsigned long online_numa_nodes() {
+  static const unsigned long nodes = [] {
+    unsigned long mask{};
+    std::ifstream file{"/sys/devices/system/node/online"};
+    std::string range;
+    while (std::getline(file, range, ',')) {
+      const auto dash = range.find('-');
+      try {
+        const auto first = std::stoul(range.substr(0, dash));
+        const auto last = dash == std::string::npos
+                              ? first
+                              : std::stoul(range.substr(dash + 1));
+        for (auto node = first; node <= last && node < 64; ++node) {
+          mask |= 1UL << node;
+        }
+      } catch (const std::exception &) {
+        return 0UL;
+      }
+    }
+    return mask;
+  }();
+  return nodes;
+}
+
+// Applies placement to whole pages of [data, data + bytes). Without kernel
+// support or with a single node pages are left to first touch.
+inline void place_pages([[maybe_unused]] void *data,
+                        [[maybe_unused]] const std::size_t bytes,
+                        const numa_placement placement,
+                        [[maybe_unused]] const int node) {
+  if (placement == numa_placement::first_touch) {
+    return;
+  }
+#if defined(SYS_mbind) && defined(MPOL_INTERLEAVE)
+  const auto nodes = online_numa_nodes();
+  if ((nodes & (nodes - 1)) == 0) {
+    return;
+  }
+  const auto address = reinterpret_cast<std::uintptr_t>(data);
+  const auto first = (address + page_size - 1) / page_size * page_size;
+  const auto last = (address + bytes) / page_size * page_size;
+  if (first >= last) {
+    return;
+  }
+  unsigned long mask = nodes;
+  int mode = MPOL_INTERLEAVE;
+  if (placement == numa_placement::bound) {
+    if (node < 0 || node >= 64 || (nodes & (1UL << node)) == 0) {
+      return;
+    }
+    mask = 1UL << node;
+    mode = MPOL_BIND;
+  }
+  // failure only means the default placement is used
+  ::syscall(SYS_mbind, first, last - first, mode, &mask, 64, 0);
+#endif
+}
+
+} // namespace detail
+
+// Policy of parallel construction, copy and destruction of heap_array. The
+// buffer is split into chunks of whole pages, each chunk is processed by one
+// task of Executor, so its pages are first touched by the worker which
+// constructs elements in it.
+//
+// Executor provides concurrency() and bulk(count, task), which runs task(i)
+// for each i in [0, count), waits for all of them and rethrows an exception
+// thrown by any.
+template <typename Executor> class parallel_policy {
+public:
+  // chunks are not made smaller than this, tiny arrays are processed by the
+  // calling thread
+  static constexpr std::size_t min_chunk_bytes{std::size_t{64} << 10};
+
+  explicit parallel_policy(
+      const unsigned thread_count = std::thread::hardware_concurrency(),
+      const numa_placement placement = numa_placement::first_touch,
+      const int node = 0)
+      : parallel_policy(Executor(thread_count), placement, node) {}
+
+  parallel_policy(Executor executor, const numa_placement placement,
+                  const int node = 0)
+      : executor_(std::move(executor)), placement_{placement}, node_{node} {}
+
+  [[nodiscard]] const Executor &executor() const noexcept {
+    return executor_;
+  }
+
+  [[nodiscard]] numa_placement placement() const noexcept {
+    return placement_;
+  }
+
+  [[nodiscard]] int node() const noexcept { return node_; }
+
+  // places pages of a freshly allocated buffer before they are touched
+  void place(void *data, const std::size_t bytes) const {
+    detail::place_pages(data, bytes, placement_, node_);
+  }
+
+  // Runs fn(first, last) for chunks of elements [0, size) starting at data,
+  // chunk boundaries are page boundaries. fn has to undo its own work if it
+  // throws, undo(first, last) is then called for each completed chunk before
+  // the exception is rethrown.
+  template <typename Fn, typename Undo>
+  void for_each_chunk(void *data, const std::size_t size,
+                      const std::size_t element_size, Fn &&fn,
+                      Undo &&undo) const {
+    if (size == 0) {
+      return;
+    }
+    const auto base = reinterpret_cast<std::uintptr_t>(data);
+    const auto first_page = base / detail::page_size * detail::page_size;
+    const auto page_count =
+        (base + size * element_size - first_page + detail::page_size - 1) /
+        detail::page_size;
+    const auto max_chunks = std::max<std::size_t>(
+        size * element_size / min_chunk_bytes, std::size_t{1});
+    const auto pages_per_chunk =
+        (page_count + std::min(executor_.concurrency(), max_chunks) - 1) /
+        std::min(executor_.concurrency(), max_chunks);
+    const auto chunk_count =
+        (page_count + pages_per_chunk - 1) / pages_per_chunk;
+    if (chunk_count <= 1) {
+      fn(std::size_t{0}, size);
+      return;
+    }
+    // first element starting in the chunk
+    const auto boundary = [&](const std::size_t chunk) -> std::size_t {
+      if (chunk == 0) {
+        return 0;
+      }
+      const auto address =
+          first_page + chunk * pages_per_chunk * detail::page_size;
+      return std::min(size,
+                      (address - base + element_size - 1) / element_size);
+    };
+    const std::unique_ptr<bool[]> completed{new bool[chunk_count]()};
+    try {
+      executor_.bulk(chunk_count, [&](const std::size_t chunk) {
+        fn(boundary(chunk), boundary(chunk + 1));
+        completed[chunk] = true;
+      });
+    } catch (...) {
+      for (std::size_t chunk{}; chunk < chunk_count; ++chunk) {
+        if (completed[chunk]) {
+          undo(boundary(chunk), boundary(chunk + 1));
+        }
+      }
+      throw;
+    }
+  }
+
+private:
+  Executor executor_;
+  numa_placement placement_;
+  int node_;
+};
+
+} // namespace vlrx
@@ -0,0 +1,434 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace vlrx {
+
+// Counters of the recycling pool used by pool_allocator.
+struct pool_statistics {
+  // allocations served from a free list
+  std::uint64_t hits;
+  // allocations which had to go to malloc
+  std::uint64_t misses;
+  // blocks freed by other threads and handed back to their owner
+  std::uint64_t remote_frees;
+  // blocks returned to free because free lists were full or their owner
+  // exited
+  std::uint64_t releases;
+  // bytes currently kept in free lists, including blocks freed by other
+  // threads which the owner has not taken back yet
+  std::uint64_t cached_bytes;
+};
+
+namespace detail {
+
+// Blocks are bucketed into two size classes per power of two, from 32 bytes
+// up to max_pooled_bytes: 32, 48, 64, 96, 128, ...
+inline constexpr std::size_t pool_min_class_bytes{32};
+inline constexpr std::size_t max_pooled_bytes{std::size_t{256} << 10};
+inline constexpr std::size_t pool_class_count{27};
+// each free list keeps at most this many bytes, but at least two blocks
+inline constexpr std::size_t max_cached_bytes_per_class{std::size_t{512}
+                                                        << 10};
+
+[[nodiscard]] constexpr std::size_t
+pool_class_bytes(const std::size_t size_class) noexcept {
+  return (size_class % 2 == 0 ? pool_min_class_bytes
+                              : pool_min_class_bytes / 2 * 3)
+         << (size_class / 2);
+}
+
+[[nodiscard]] constexpr std::size_t
+pool_class_of(const std::size_t bytes) noexcept {
+  if (bytes <= pool_min_class_bytes) {
+    return 0;
+  }
+  // 2^power < bytes <= 2^(power + 1)
+#if defined(__GNUC__)
+  const auto power = static_cast<std::size_t>(
+      std::numeric_limits<unsigned long long>::digits - 1 -
+      __builtin_clzll(static_cast<unsigned long long>(bytes - 1)));
+#else
+  std::size_t power{};
+  while ((std::size_t{2} << power) < bytes) {
+    ++power;
+  }
+#endif
+  return (std::size_t{3} << (power - 1)) >= bytes ? 2 * (power - 5) + 1
+                                                  : 2 * (power - 4);
+}
+
+static_assert(pool_class_bytes(pool_class_count - 1) == max_pooled_bytes);
+static_assert(pool_class_of(33) == 1 && pool_class_of(64) == 2 &&
+              pool_class_of(65) == 3 && pool_class_of(max_pooled_bytes) ==
+                                            pool_class_count - 1);
+
+[[nodiscard]] constexpr std::size_t
+pool_class_capacity(const std::size_t size_class) noexcept {
+  const auto blocks = max_cached_bytes_per_class / pool_class_bytes(size_class);
+  return blocks > 2 ? blocks : 2;
+}
+
+class pool_thread_cache;
+
+// Precedes every pooled block, the free list link is kept in the block.
+struct alignas(alignof(std::max_align_t)) pool_block_header {
+  pool_thread_cache *owner;
+  std::size_t size_class;
+};
+
+struct pool_free_block {
+  pool_free_block *next;
+};
+
+// Free lists of one thread. Caches are never destroyed: when their thread
+// exits they are emptied and adopted by the next thread which starts using
+// the pool, so the owner of a block is always a valid object. Blocks freed by
+// other threads wait in a remote list, bounded per size class like the local
+// ones, until the owner takes them back; while the cache has no thread they
+// are released to free right away.
+class pool_thread_cache final {
+public:
+  [[nodiscard]] void *allocate(const std::size_t size_class) {
+    auto block = heads_[size_class];
+    if (block == nullptr && remote_head_.load(std::memory_order_relaxed)) {
+      drain_remote();
+      block = heads_[size_class];
+    }
+    if (block != nullptr) {
+      heads_[size_class] = block->next;
+      --counts_[size_class];
+      add(hits_, 1);
+      add(cached_bytes_, 0 - pool_class_bytes(size_class));
+      return block;
+    }
+    auto header = static_cast<pool_block_header *>(
+        std::malloc(pool_class_bytes(size_class)));
+    if (header == nullptr) {
+      throw std::bad_alloc();
+    }
+    header->owner = this;
+    header->size_class = size_class;
+    add(misses_, 1);
+    return header + 1;
+  }
+
+  // returns block allocated by this cache to its free list
+  void deallocate_local(pool_block_header *header) noexcept {
+    const auto size_class = header->size_class;
+    if (counts_[size_class] >= pool_class_capacity(size_class)) {
+      release(header);
+      return;
+    }
+    const auto block = ::new (static_cast<void *>(header + 1)) pool_free_block;
+    block->next = heads_[size_class];
+    heads_[size_class] = block;
+    ++counts_[size_class];
+    add(cached_bytes_, pool_class_bytes(size_class));
+  }
+
+  // hands block back from another thread, lock-free
+  void deallocate_remote(pool_block_header *header) noexcept {
+    if (orphaned_.load(std::memory_order_acquire)) {
+      release(header);
+      return;
+    }
+    // counted before the block is pushed, so the count is never below the
+    // number of blocks of the class in the list
+    auto &count = remote_counts_[header->size_class];
+    if (count.fetch_add(1, std::memory_order_relaxed) >=
+        pool_class_capacity(header->size_class)) {
+      count.fetch_sub(1, std::memory_order_relaxed);
+      release(header);
+      return;
+    }
+    const auto block = ::new (static_cast<void *>(header + 1)) pool_free_block;
+    block->next = remote_head_.load(std::memory_order_relaxed);
+    while (!remote_head_.compare_exchange_weak(block->next, block,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+    }
+    remote_frees_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // releases all cached blocks to malloc
+  void trim() noexcept {
+    drain_remote();
+    for (std::size_t size_class{}; size_class < pool_class_count;
+         ++size_class) {
+      while (const auto block = heads_[size_class]) {
+        heads_[size_class] = block->next;
+        std::free(header_of(block));
+      }
+      counts_[size_class] = 0;
+    }
+    cached_bytes_.store(0, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] pool_statistics statistics() const noexcept {
+    constexpr auto order = std::memory_order_relaxed;
+    auto cached_bytes = cached_bytes_.load(order);
+    for (std::size_t size_class{}; size_class < pool_class_count;
+         ++size_class) {
+      cached_bytes +=
+          remote_counts_[size_class].load(order) * pool_class_bytes(size_class);
+    }
+    return {hits_.load(order), misses_.load(order), remote_frees_.load(order),
+            releases_.load(order), cached_bytes};
+  }
+
+  // cache of the calling thread, created or adopted on first use
+  [[nodiscard]] static pool_thread_cache &current() {
+    if (current_cache != nullptr) {
+      return *current_cache;
+    }
+    thread_local const owner_handle handle;
+    return *handle.cache;
+  }
+
+  // cache of the calling thread, nullptr if the thread did not use the pool
+  [[nodiscard]] static pool_thread_cache *current_if_exists() noexcept {
+    return current_cache;
+  }
+
+  // statistics of all caches, including those of exited threads
+  [[nodiscard]] static pool_statistics total_statistics() {
+    const std::lock_guard<std::mutex> lock{registry_mutex};
+    auto total = exited_statistics;
+    for (auto cache = registry; cache != nullptr; cache = cache->next_) {
+      accumulate(total, cache->statistics());
+    }
+    return total;
+  }
+
+private:
+  // empties the cache of a thread and leaves it for adoption when the thread
+  // exits
+  struct owner_handle {
+    pool_thread_cache *cache;
+
+    owner_handle() : cache{adopt()} { current_cache = cache; }
+
+    owner_handle(const owner_handle &) = delete;
+
+    owner_handle &operator=(const owner_handle &) = delete;
+
+    ~owner_handle() {
+      current_cache = nullptr;
+      cache->trim();
+      {
+        const std::lock_guard<std::mutex> lock{registry_mutex};
+        cache->orphaned_.store(true, std::memory_order_release);
+      }
+      // blocks freed by other threads before they saw the cache orphaned,
+      // the adopting thread may be taking them at the same time
+      cache->release_remote();
+    }
+  };
+
+  // both are constant-initialized and trivially destructible, so they are
+  // usable by thread exit handlers during static destruction
+  static inline std::mutex registry_mutex;
+  static inline pool_thread_cache *registry{};
+  // statistics of exited threads whose caches were adopted since
+  static inline pool_statistics exited_statistics{};
+  static inline thread_local pool_thread_cache *current_cache{};
+
+  pool_free_block *heads_[pool_class_count]{};
+  std::size_t counts_[pool_class_count]{};
+  std::atomic<pool_free_block *> remote_head_{};
+  // upper bounds of the number of blocks of each class in the remote list
+  std::atomic<std::size_t> remote_counts_[pool_class_count]{};
+  std::atomic<std::uint64_t> remote_frees_{};
+  std::atomic<std::uint64_t> releases_{};
+  // written only by the owner, so they are not updated atomically
+  std::atomic<std::uint64_t> hits_{};
+  std::atomic<std::uint64_t> misses_{};
+  std::atomic<std::uint64_t> cached_bytes_{};
+  pool_thread_cache *next_{};
+  // set while no thread owns the cache, under registry_mutex
+  std::atomic<bool> orphaned_{};
+
+  static void add(std::atomic<std::uint64_t> &counter,
+                  const std::uint64_t value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  static void accumulate(pool_statistics &total,
+                         const pool_statistics &statistics) noexcept {
+    total.hits += statistics.hits;
+    total.misses += statistics.misses;
+    total.remote_frees += statistics.remote_frees;
+    total.releases += statistics.releases;
+    total.cached_bytes += statistics.cached_bytes;
+  }
+
+  [[nodiscard]] static pool_block_header *
+  header_of(pool_free_block *block) noexcept {
+    return reinterpret_cast<pool_block_header *>(block) - 1;
+  }
+
+  void release(pool_block_header *header) noexcept {
+    releases_.fetch_add(1, std::memory_order_relaxed);
+    std::free(header);
+  }
+
+  // takes the remote list, calls fn(header) for each of its blocks
+  template <typename Fn> void take_remote(Fn &&fn) noexcept {
+    auto block = remote_head_.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+      const auto next = block->next;
+      const auto header = header_of(block);
+      remote_counts_[header->size_class].fetch_sub(1,
+                                                   std::memory_order_relaxed);
+      fn(header);
+      block = next;
+    }
+  }
+
+  void drain_remote() noexcept {
+    take_remote([this](pool_block_header *header) {
+      deallocate_local(header);
+    });
+  }
+
+  void release_remote() noexcept {
+    take_remote([this](pool_block_header *header) { release(header); });
+  }
+
+  [[nodiscard]] static pool_thread_cache *adopt() {
+    const std::lock_guard<std::mutex> lock{registry_mutex};
+    for (auto cache = registry; cache != nullptr; cache = cache->next_) {
+      if (cache->orphaned_.load(std::memory_order_relaxed)) {
+        cache->orphaned_.store(false, std::memory_order_relaxed);
+        // the adopting thread starts with its own statistics
+        accumulate(exited_statistics, cache->statistics());
+        cache->hits_.store(0, std::memory_order_relaxed);
+        cache->misses_.store(0, std::memory_order_relaxed);
+        cache->releases_.store(0, std::memory_order_relaxed);
+        cache->remote_frees_.store(0, std::memory_order_relaxed);
+        return cache;
+      }
+    }
+    const auto cache = new pool_thread_cache;
+    cache->next_ = registry;
+    registry = cache;
+    return cache;
+  }
+};
+
+} // namespace detail
+
+// Stateless allocator which recycles buffers through per-thread free lists
+// bucketed by size class, for code which keeps creating and destroying
+// arrays of a few recurring sizes. Each free list retains a bounded number
+// of bytes. A buffer freed by a thread other than the one which allocated it
+// is handed back to the owning thread lock-free. Buffers bigger than
+// detail::max_pooled_bytes and over-aligned types go directly to
+// heap_allocator.
+template <typename T> class pool_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+
+  template <typename U> struct rebind {
+    using other = pool_allocator<U>;
+  };
+
+  pool_allocator() noexcept = default;
+
+  template <typename U> pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  [[nodiscard]] T *allocate(const std::size_t size) {
+    if (!is_pooled(size)) {
+      return heap_allocator<T>{}.allocate(size);
+    }
+    return static_cast<T *>(detail::pool_thread_cache::current().allocate(
+        detail::pool_class_of(block_bytes(size))));
+  }
+
+  // same as allocate, but the memory is filled with zero bytes
+  [[nodiscard]] T *allocate_zeroed(const std::size_t size) {
+    if (!is_pooled(size)) {
+      return heap_allocator<T>{}.allocate_zeroed(size);
+    }
+    const auto ptr = allocate(size);
+    std::memset(static_cast<void *>(ptr), 0, sizeof(T) * size);
+    return ptr;
+  }
+
+  void deallocate(T *ptr, const std::size_t size) noexcept {
+    if (!is_pooled(size)) {
+      heap_allocator<T>{}.deallocate(ptr, size);
+      return;
+    }
+    const auto header = reinterpret_cast<detail::pool_block_header *>(ptr) - 1;
+    if (header->owner == detail::pool_thread_cache::current_if_exists()) {
+      header->owner->deallocate_local(header);
+    } else {
+      header->owner->deallocate_remote(header);
+    }
+  }
+
+  template <typename U>
+  friend bool operator==(const pool_allocator &,
+                         const pool_allocator<U> &) noexcept {
+    return true;
+  }
+
+  template <typename U>
+  friend bool operator!=(const pool_allocator &,
+                         const pool_allocator<U> &) noexcept {
+    return false;
+  }
+
+private:
+  [[nodiscard]] static constexpr std::size_t
+  block_bytes(const std::size_t size) noexcept {
+    return sizeof(detail::pool_block_header) + sizeof(T) * size;
+  }
+
+  [[nodiscard]] static constexpr bool
+  is_pooled(const std::size_t size) noexcept {
+    return alignof(T) <= alignof(detail::pool_block_header) &&
+           size <= (detail::max_pooled_bytes -
+                    sizeof(detail::pool_block_header)) /
+                       sizeof(T);
+  }
+};
+
+template <typename T, typename SizeType = std::uint64_t>
+using pooled_heap_array = heap_array<T, SizeType, pool_allocator<T>>;
+
+// statistics of the pool of the calling thread
+[[nodiscard]] inline pool_statistics thread_pool_statistics() noexcept {
+  const auto cache = detail::pool_thread_cache::current_if_exists();
+  return cache != nullptr ? cache->statistics() : pool_statistics{};
+}
+
+// statistics summed over the pools of all threads which used pool_allocator,
+// including the exited ones
+[[nodiscard]] inline pool_statistics total_pool_statistics() {
+  return detail::pool_thread_cache::total_statistics();
+}
+
+// releases buffers cached by the calling thread to malloc
+inline void trim_thread_pool() noexcept {
+  if (const auto cache = detail::pool_thread_cache::current_if_exists()) {
+    cache->trim();
+  }
+}
+
+} // namespace vlrx
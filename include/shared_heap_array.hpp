@@ -0,0 +1,684 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vlrx {
+
+// Non-resizeable array whose buffer is shared by copies, so copying is O(1)
+// and never touches the allocator. The reference count and the size are
+// stored in a header in front of the elements, in the same allocation, and
+// the container itself is a single pointer.
+//
+// Const access never copies. The first mutable access (non-const data,
+// operator[], at, front, back, begin, end or detach) to a buffer shared with
+// other arrays clones it first, which invalidates pointers and iterators
+// obtained earlier from this array. Mutable access other than detach also
+// marks the buffer unshareable, because the references it returns may be
+// used to write later: copies of such an array copy its elements, so that
+// snapshots never change. share() makes the buffer shareable again once
+// those references are no longer used, e.g. after a table was filled
+// through operator[]. Arrays which are copied often should be read through
+// const access. As with std::shared_ptr, different arrays sharing a
+// buffer may be used by different threads concurrently, while a single array
+// may not.
+template <typename T, typename SizeType = std::uint64_t,
+          typename Allocator = heap_allocator<T>>
+class shared_heap_array final : private detail::allocator_holder<Allocator> {
+  static_assert(std::is_same_v<typename Allocator::value_type, T>,
+                "Allocator::value_type must be the same as T");
+
+public:
+  using value_type = T;
+  using size_type = SizeType;
+  using allocator_type = Allocator;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const T *;
+  using iterator = detail::random_access_iterator<value_type, false>;
+  using const_iterator = detail::random_access_iterator<value_type, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  shared_heap_array() noexcept(noexcept(allocator_type()))
+      : shared_heap_array(allocator_type()) {}
+
+  explicit shared_heap_array(const allocator_type &alloc) noexcept
+      : allocator_base{alloc}, header_{} {}
+
+  // value-initializes size elements
+  explicit shared_heap_array(const size_type size,
+                             const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, header_{} {
+    if constexpr (detail::is_zero_initializable_v<value_type> &&
+                  detail::uses_default_construct_v<allocator_type,
+                                                   value_type>) {
+      build(size, true, [](value_type *) {});
+    } else {
+      build(size, false, [&](value_type *elements) {
+        fill_buffer(elements, size, [](size_type) { return value_type(); });
+      });
+    }
+  }
+
+  shared_heap_array(const size_type size, const value_type &value,
+                    const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, header_{} {
+    build(size, false, [&](value_type *elements) {
+      fill_buffer(elements, size,
+                  [&](size_type) -> const value_type & { return value; });
+    });
+  }
+
+  // default-initializes size elements, trivially default constructible
+  // elements are left uninitialized
+  shared_heap_array(const size_type size, for_overwrite_t,
+                    const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, header_{} {
+    build(size, false, [&](value_type *elements) {
+      if constexpr (!std::is_trivially_default_constructible_v<value_type>) {
+        size_type idx{};
+        try {
+          for (; idx < size; ++idx) {
+            ::new (static_cast<void *>(elements + idx)) value_type;
+          }
+        } catch (...) {
+          destroy_range(elements, idx);
+          throw;
+        }
+      }
+    });
+  }
+
+  // builds i-th element in place from generator(i)
+  template <typename Generator>
+  shared_heap_array(const size_type size, from_generator_t,
+                    Generator &&generator,
+                    const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, header_{} {
+    build(size, false, [&](value_type *elements) {
+      fill_buffer(elements, size, generator);
+    });
+  }
+
+  template <typename ForwardIt,
+            typename std::enable_if_t<detail::is_forward_iterator_v<ForwardIt>,
+                                      int> = 1>
+  shared_heap_array(ForwardIt first, ForwardIt last,
+                    const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, header_{} {
+    const auto distance = std::distance(first, last);
+    assert(distance >= 0 &&
+           static_cast<std::make_unsigned_t<decltype(distance)>>(distance) <=
+               std::numeric_limits<size_type>::max());
+    const auto size = static_cast<size_type>(distance);
+    build(size, false, [&](value_type *elements) {
+      fill_buffer(elements, size,
+                  [&](size_type) -> decltype(auto) { return *first++; });
+    });
+  }
+
+  template <typename ForwardRange>
+  shared_heap_array(from_range_t, ForwardRange &&range,
+                    const allocator_type &alloc = allocator_type())
+      : shared_heap_array(std::begin(range), std::end(range), alloc) {}
+
+  shared_heap_array(std::initializer_list<value_type> init,
+                    const allocator_type &alloc = allocator_type())
+      : shared_heap_array(init.begin(), init.end(), alloc) {}
+
+  // copies elements of array into a new buffer
+  template <typename Layout>
+  explicit shared_heap_array(
+      const heap_array<value_type, size_type, allocator_type, Layout> &array)
+      : allocator_base{array.get_allocator()}, header_{} {
+    build(array.size(), false, [&](value_type *elements) {
+      copy_construct_buffer(array.data(), elements, array.size());
+    });
+  }
+
+  // moves elements of array into a new buffer, trivially copyable elements
+  // are copied in bulk
+  template <typename Layout>
+  explicit shared_heap_array(
+      heap_array<value_type, size_type, allocator_type, Layout> &&array)
+      : allocator_base{array.get_allocator()}, header_{} {
+    build(array.size(), false, [&](value_type *elements) {
+      if constexpr (is_bitwise_copy_constructible) {
+        copy_construct_buffer(array.data(), elements, array.size());
+      } else {
+        fill_buffer(elements, array.size(),
+                    [&](const size_type idx) -> value_type && {
+                      return std::move(array[idx]);
+                    });
+      }
+    });
+    // moved-from elements are released right away
+    array = heap_array<value_type, size_type, allocator_type, Layout>(
+        array.get_allocator());
+  }
+
+  shared_heap_array(const shared_heap_array &other)
+      : shared_heap_array(other,
+                          alloc_traits::select_on_container_copy_construction(
+                              other.get_allocator_ref())) {}
+
+  // shares the buffer of other, or copies its elements if the buffer is
+  // unshareable or alloc can not release it
+  shared_heap_array(const shared_heap_array &other,
+                    const allocator_type &alloc)
+      : allocator_base{alloc}, header_{} {
+    if (other.is_shareable() &&
+        get_allocator_ref() == other.get_allocator_ref()) {
+      header_ = other.header_;
+      acquire();
+      return;
+    }
+    build(other.size(), false, [&](value_type *elements) {
+      copy_construct_buffer(other.data(), elements, other.size());
+    });
+    detail::record(instrumentation::event::copy_construction,
+                   sizeof(value_type) * static_cast<std::size_t>(size()));
+  }
+
+  shared_heap_array &operator=(const shared_heap_array &other) {
+    if (header_ != other.header_) {
+      // the old buffer is released by the old allocator
+      shared_heap_array copy(
+          other, alloc_traits::propagate_on_container_copy_assignment::value
+                     ? other.get_allocator_ref()
+                     : get_allocator_ref());
+      release();
+      header_ = std::exchange(copy.header_, nullptr);
+    }
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value) {
+      get_allocator_ref() = other.get_allocator_ref();
+    }
+    return *this;
+  }
+
+  shared_heap_array(shared_heap_array &&other) noexcept
+      : allocator_base{std::move(other.get_allocator_ref())},
+        header_{std::exchange(other.header_, nullptr)} {}
+
+  shared_heap_array &operator=(shared_heap_array &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
+    if constexpr (!alloc_traits::propagate_on_container_move_assignment::
+                      value &&
+                  !alloc_traits::is_always_equal::value) {
+      if (get_allocator_ref() != other.get_allocator_ref()) {
+        // buffer of other can not be released by our allocator, hence
+        // elements are moved one by one, or copied if other shares them
+        if (other.use_count() != 1) {
+          shared_heap_array copy(other, get_allocator_ref());
+          release();
+          header_ = std::exchange(copy.header_, nullptr);
+          return *this;
+        }
+        shared_heap_array moved(get_allocator_ref());
+        const auto elements = other.mutable_data();
+        moved.build(other.size(), false, [&](value_type *buffer) {
+          moved.fill_buffer(buffer, other.size(),
+                            [&](const size_type idx) -> value_type && {
+                              return std::move(elements[idx]);
+                            });
+        });
+        release();
+        header_ = std::exchange(moved.header_, nullptr);
+        return *this;
+      }
+    }
+    release();
+    header_ = std::exchange(other.header_, nullptr);
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                      value) {
+      get_allocator_ref() = std::move(other.get_allocator_ref());
+    }
+    return *this;
+  }
+
+  ~shared_heap_array() { release(); }
+
+  // Copy of elements as heap_array. If the buffer is not shared, the rvalue
+  // overload moves elements out and leaves the array empty.
+  [[nodiscard]] heap_array<value_type, size_type, allocator_type>
+  to_heap_array() const & {
+    const auto elements = data();
+    if constexpr (is_bitwise_copy_constructible &&
+                  std::is_trivially_default_constructible_v<value_type>) {
+      return bitwise_to_heap_array();
+    } else {
+      return heap_array<value_type, size_type, allocator_type>(
+          size(), from_generator,
+          [&](const size_type idx) -> const value_type & {
+            return elements[idx];
+          },
+          get_allocator_ref());
+    }
+  }
+
+  [[nodiscard]] heap_array<value_type, size_type, allocator_type>
+  to_heap_array() && {
+    if (use_count() != 1) {
+      auto array = std::as_const(*this).to_heap_array();
+      release();
+      return array;
+    }
+    if constexpr (is_bitwise_move_constructible &&
+                  std::is_trivially_default_constructible_v<value_type>) {
+      auto array = bitwise_to_heap_array();
+      release();
+      return array;
+    } else {
+      const auto elements = mutable_data();
+      heap_array<value_type, size_type, allocator_type> array(
+          size(), from_generator,
+          [&](const size_type idx) -> value_type && {
+            return std::move(elements[idx]);
+          },
+          get_allocator_ref());
+      release();
+      return array;
+    }
+  }
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept {
+    return get_allocator_ref();
+  }
+
+  // number of arrays sharing the buffer, zero for an empty array
+  [[nodiscard]] std::size_t use_count() const noexcept {
+    if (header_ == nullptr) {
+      return 0;
+    }
+    const auto references = header_->references.load(std::memory_order_acquire);
+    return references == unshareable ? 1 : references;
+  }
+
+  // clones the buffer if it is shared, so the array owns it exclusively
+  void detach() {
+    if (use_count() <= 1) {
+      return;
+    }
+    const auto source = elements_of(header_);
+    const auto size = this->size();
+    auto copy = allocate_block(size, false);
+    try {
+      copy_construct_buffer(source, elements_of(copy), size);
+    } catch (...) {
+      deallocate_block(copy);
+      throw;
+    }
+    release();
+    header_ = copy;
+    detail::record(instrumentation::event::copy_construction,
+                   sizeof(value_type) * static_cast<std::size_t>(size));
+  }
+
+  // Lets copies share the buffer again after mutable access. References,
+  // pointers and iterators obtained by mutable access before the call must
+  // not be used to write any more.
+  void share() noexcept {
+    // an unshareable buffer has no other owner to race with
+    if (!is_shareable()) {
+      header_->references.store(1, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] const_reference at(const size_type pos) const {
+    if (pos >= size()) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return data()[pos];
+  }
+
+  [[nodiscard]] reference at(const size_type pos) {
+    if (pos >= size()) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return data()[pos];
+  }
+
+  [[nodiscard]] const_reference operator[](const size_type pos) const noexcept {
+    assert(pos < size());
+    return data()[pos];
+  }
+
+  [[nodiscard]] reference operator[](const size_type pos) {
+    assert(pos < size());
+    return data()[pos];
+  }
+
+  [[nodiscard]] reference front() { return data()[0]; }
+
+  [[nodiscard]] const_reference front() const noexcept { return data()[0]; }
+
+  [[nodiscard]] reference back() { return data()[size() - 1]; }
+
+  [[nodiscard]] const_reference back() const noexcept {
+    return data()[size() - 1];
+  }
+
+  // the buffer becomes unshareable
+  [[nodiscard]] pointer data() {
+    detach();
+    if (header_ != nullptr) {
+      header_->references.store(unshareable, std::memory_order_relaxed);
+    }
+    return mutable_data();
+  }
+
+  [[nodiscard]] const_pointer data() const noexcept {
+    return header_ != nullptr ? elements_of(header_) : nullptr;
+  }
+
+  iterator begin() { return iterator{data()}; }
+
+  const_iterator begin() const noexcept { return const_iterator{data()}; }
+
+  const_iterator cbegin() const noexcept { return const_iterator{data()}; }
+
+  reverse_iterator rbegin() { return reverse_iterator{end()}; }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  const_reverse_iterator crbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  iterator end() {
+    const auto elements = data();
+    return iterator{elements + size()};
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator{data() + size()};
+  }
+
+  const_iterator cend() const noexcept {
+    return const_iterator{data() + size()};
+  }
+
+  reverse_iterator rend() { return reverse_iterator{begin()}; }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  const_reverse_iterator crend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] size_type size() const noexcept {
+    return header_ != nullptr ? header_->size : 0;
+  }
+
+  [[nodiscard]] size_type max_size() const noexcept { return size(); }
+
+  void swap(shared_heap_array &other) noexcept {
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      using std::swap;
+      swap(get_allocator_ref(), other.get_allocator_ref());
+    } else {
+      assert(get_allocator_ref() == other.get_allocator_ref());
+    }
+    std::swap(header_, other.header_);
+  }
+
+private:
+  using allocator_base = detail::allocator_holder<allocator_type>;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+
+  struct header_type {
+    std::atomic<std::size_t> references;
+    size_type size;
+  };
+
+  static constexpr std::size_t block_alignment =
+      std::max(alignof(header_type), alignof(value_type));
+  // elements start at the first suitably aligned offset after the header
+  static constexpr std::size_t header_bytes =
+      (sizeof(header_type) + block_alignment - 1) / block_alignment *
+      block_alignment;
+
+  using block_type = std::aligned_storage_t<block_alignment, block_alignment>;
+  using block_allocator_type =
+      typename alloc_traits::template rebind_alloc<block_type>;
+  using block_traits = std::allocator_traits<block_allocator_type>;
+
+  static_assert(std::is_same_v<typename block_traits::pointer, block_type *>,
+                "Allocators with fancy pointers are not supported");
+
+  using allocator_base::get_allocator_ref;
+
+  static constexpr bool is_bitwise_copy_constructible =
+      std::is_trivially_copy_constructible_v<value_type> &&
+      detail::uses_default_construct_v<allocator_type, value_type,
+                                       const value_type &>;
+
+  static constexpr bool is_bitwise_move_constructible =
+      std::is_trivially_move_constructible_v<value_type> &&
+      detail::uses_default_construct_v<allocator_type, value_type,
+                                       value_type &&>;
+
+  // Reference count of a buffer whose elements may be written through
+  // references handed out by mutable access. Its only owner is the array.
+  static constexpr std::size_t unshareable{0};
+
+  header_type *header_;
+
+  [[nodiscard]] static pointer elements_of(header_type *header) noexcept {
+    return std::launder(reinterpret_cast<value_type *>(
+        reinterpret_cast<unsigned char *>(header) + header_bytes));
+  }
+
+  [[nodiscard]] pointer mutable_data() noexcept {
+    return header_ != nullptr ? elements_of(header_) : nullptr;
+  }
+
+  [[nodiscard]] bool is_shareable() const noexcept {
+    return header_ == nullptr || header_->references.load(
+                                     std::memory_order_relaxed) != unshareable;
+  }
+
+  // copies elements with memcpy into a heap_array
+  [[nodiscard]] heap_array<value_type, size_type, allocator_type>
+  bitwise_to_heap_array() const {
+    heap_array<value_type, size_type, allocator_type> array(
+        size(), for_overwrite, get_allocator_ref());
+    if (!array.empty()) {
+      std::memcpy(static_cast<void *>(array.data()),
+                  static_cast<const void *>(data()),
+                  sizeof(value_type) * size());
+    }
+    return array;
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  block_count(const size_type size) noexcept {
+    return (header_bytes + static_cast<std::size_t>(size) * sizeof(value_type) +
+            block_alignment - 1) /
+           block_alignment;
+  }
+
+  // block with a header holding one reference, nullptr for zero size
+  [[nodiscard]] header_type *allocate_block(const size_type size,
+                                            const bool zeroed) {
+    if (size == 0) {
+      return nullptr;
+    }
+    block_allocator_type block_allocator{get_allocator_ref()};
+    block_type *blocks{};
+    if constexpr (detail::has_allocate_zeroed<block_allocator_type>::value) {
+      blocks = zeroed ? block_allocator.allocate_zeroed(block_count(size))
+                      : block_traits::allocate(block_allocator,
+                                               block_count(size));
+    } else {
+      blocks = block_traits::allocate(block_allocator, block_count(size));
+      if (zeroed) {
+        std::memset(static_cast<void *>(blocks), 0,
+                    sizeof(block_type) * block_count(size));
+      }
+    }
+    detail::record(instrumentation::event::allocation,
+                   sizeof(block_type) * block_count(size));
+    return ::new (static_cast<void *>(blocks)) header_type{{1}, size};
+  }
+
+  void deallocate_block(header_type *header) noexcept {
+    const auto size = header->size;
+    header->~header_type();
+    block_allocator_type block_allocator{get_allocator_ref()};
+    block_traits::deallocate(block_allocator,
+                             reinterpret_cast<block_type *>(header),
+                             block_count(size));
+    detail::record(instrumentation::event::deallocation,
+                   sizeof(block_type) * block_count(size));
+  }
+
+  // allocates block for size elements and constructs them with fill(elements)
+  template <typename Fill>
+  void build(const size_type size, const bool zeroed, Fill &&fill) {
+    auto header = allocate_block(size, zeroed);
+    if (header == nullptr) {
+      return;
+    }
+    try {
+      fill(elements_of(header));
+    } catch (...) {
+      deallocate_block(header);
+      throw;
+    }
+    header_ = header;
+  }
+
+  void acquire() const noexcept {
+    if (header_ != nullptr) {
+      header_->references.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // drops the reference to the buffer, the last one destroys elements
+  void release() noexcept {
+    if (header_ != nullptr &&
+        (header_->references.load(std::memory_order_relaxed) == unshareable ||
+         header_->references.fetch_sub(1, std::memory_order_acq_rel) == 1)) {
+      destroy_range(elements_of(header_), header_->size);
+      deallocate_block(header_);
+    }
+    header_ = nullptr;
+  }
+
+  void destroy_range(pointer elements, const size_type size) noexcept {
+    if constexpr (std::is_trivially_destructible_v<value_type> == false) {
+      for (size_type i{}; i < size; ++i) {
+        alloc_traits::destroy(get_allocator_ref(), elements + i);
+      }
+    }
+  }
+
+  void copy_construct_buffer(const_pointer source, pointer elements,
+                             const size_type size) {
+    if constexpr (is_bitwise_copy_constructible) {
+      if (size > 0) {
+        std::memcpy(static_cast<void *>(elements),
+                    static_cast<const void *>(source),
+                    sizeof(value_type) * size);
+      }
+    } else {
+      fill_buffer(elements, size,
+                  [&](const size_type idx) -> const value_type & {
+                    return source[idx];
+                  });
+    }
+  }
+
+  // constructs i-th element from argument(i), already constructed elements
+  // are destroyed if any of constructors throws
+  template <typename Argument>
+  void fill_buffer(pointer elements, const size_type size,
+                   Argument &&argument) {
+    size_type idx{};
+    try {
+      for (; idx < size; ++idx) {
+        alloc_traits::construct(get_allocator_ref(), elements + idx,
+                                argument(idx));
+      }
+    } catch (...) {
+      destroy_range(elements, idx);
+      throw;
+    }
+  }
+};
+
+template <typename VType, typename SType, typename Alloc>
+inline void swap(shared_heap_array<VType, SType, Alloc> &lhs,
+                 shared_heap_array<VType, SType, Alloc> &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+template <typename VType, typename SType, typename Alloc>
+inline bool operator==(const shared_heap_array<VType, SType, Alloc> &lhs,
+                       const shared_heap_array<VType, SType, Alloc> &rhs) {
+  return lhs.data() == rhs.data() || detail::equal_elements(lhs, rhs);
+}
+
+template <typename VType, typename SType, typename Alloc>
+inline bool operator!=(const shared_heap_array<VType, SType, Alloc> &lhs,
+                       const shared_heap_array<VType, SType, Alloc> &rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename VType, typename SType, typename Alloc>
+inline bool operator<(const shared_heap_array<VType, SType, Alloc> &lhs,
+                      const shared_heap_array<VType, SType, Alloc> &rhs) {
+  return detail::less_elements(lhs, rhs);
+}
+
+template <typename VType, typename SType, typename Alloc>
+inline bool operator>(const shared_heap_array<VType, SType, Alloc> &lhs,
+                      const shared_heap_array<VType, SType, Alloc> &rhs) {
+  return rhs < lhs;
+}
+
+template <typename VType, typename SType, typename Alloc>
+inline bool operator<=(const shared_heap_array<VType, SType, Alloc> &lhs,
+                       const shared_heap_array<VType, SType, Alloc> &rhs) {
+  return !(lhs > rhs);
+}
+
+template <typename VType, typename SType, typename Alloc>
+inline bool operator>=(const shared_heap_array<VType, SType, Alloc> &lhs,
+                       const shared_heap_array<VType, SType, Alloc> &rhs) {
+  return !(lhs < rhs);
+}
+
+// the header is on heap, hence only the allocator may prevent relocation
+template <typename VType, typename SType, typename Alloc>
+struct is_trivially_relocatable<shared_heap_array<VType, SType, Alloc>>
+    : is_trivially_relocatable<Alloc> {};
+
+} // namespace vlrx
@@ -0,0 +1,582 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Bulk kernels over contiguous arithmetic elements. Loops are written with
+// GCC/Clang vector extensions and compiled once per x86 instruction set
+// (SSE2, AVX2, AVX-512), the widest one supported by the CPU is chosen at
+// run time. Other compilers and architectures use portable scalar loops.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VLRX_SIMD_X86 1
+#define VLRX_SIMD_INLINE __attribute__((always_inline)) inline
+#else
+#define VLRX_SIMD_X86 0
+#define VLRX_SIMD_INLINE inline
+#endif
+
+namespace vlrx {
+
+namespace simd {
+
+// Instruction sets of the kernels, from scalar loops to 512-bit vectors.
+enum class level {
+  scalar,
+  sse2,
+  avx2,
+  // AVX-512F and AVX-512BW
+  avx512,
+};
+
+namespace detail {
+
+[[nodiscard]] inline level detect_level() noexcept {
+#if VLRX_SIMD_X86
+  // the checks include support of the vector registers by the OS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return level::avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return level::avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return level::sse2;
+  }
+#endif
+  return level::scalar;
+}
+
+inline std::atomic<level> &level_limit() noexcept {
+  static std::atomic<level> limit{level::avx512};
+  return limit;
+}
+
+} // namespace detail
+
+// the widest instruction set supported by the CPU and the OS
+[[nodiscard]] inline level supported_level() noexcept {
+  static const level supported{detail::detect_level()};
+  return supported;
+}
+
+// instruction set used by the kernels
+[[nodiscard]] inline level active_level() noexcept {
+  return std::min(supported_level(),
+                  detail::level_limit().load(std::memory_order_relaxed));
+}
+
+// Limits the kernels to instruction sets up to limit, e.g. to compare them
+// in benchmarks. Limits above the supported level have no effect.
+inline void set_level_limit(const level limit) noexcept {
+  detail::level_limit().store(limit, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+template <typename T> struct identity {
+  using type = T;
+};
+
+// keeps T deduced from the pointer, so that simd::fill(floats, n, 0) works
+template <typename T> using identity_t = typename identity<T>::type;
+
+// types which fit into vector registers, others always use scalar loops
+template <typename T>
+inline constexpr bool is_vectorizable_v =
+    (std::is_integral_v<T> && !std::is_same_v<T, bool>) ||
+    std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+template <std::size_t Size> struct unsigned_of_size;
+
+template <> struct unsigned_of_size<1> {
+  using type = std::uint8_t;
+};
+
+template <> struct unsigned_of_size<2> {
+  using type = std::uint16_t;
+};
+
+template <> struct unsigned_of_size<4> {
+  using type = std::uint32_t;
+};
+
+template <> struct unsigned_of_size<8> {
+  using type = std::uint64_t;
+};
+
+// Bytes / sizeof(T) lanes of T, arithmetic and comparisons are element-wise
+// (comparisons give lanes of all ones or zeros)
+template <typename T, std::size_t Bytes> struct vector_of {
+  typedef T type __attribute__((vector_size(Bytes)));
+  // the same vector at the alignment of T, for loads and stores of elements
+  typedef T unaligned
+      __attribute__((vector_size(Bytes), aligned(alignof(T)), may_alias));
+};
+
+// Vector of the Bytes bytes at data, its loads and stores are single
+// unaligned moves. Copying vectors with memcpy may be split into narrower
+// moves through the stack instead, which stalls store forwarding.
+template <std::size_t Bytes, typename T>
+VLRX_SIMD_INLINE auto &vector_at(T *data) noexcept {
+  using unaligned =
+      typename vector_of<std::remove_const_t<T>, Bytes>::unaligned;
+  if constexpr (std::is_const_v<T>) {
+    return *reinterpret_cast<const unaligned *>(data);
+  } else {
+    return *reinterpret_cast<unaligned *>(data);
+  }
+}
+
+// Kernels are instantiated for vectors of Bytes bytes, or for scalar loops
+// when Bytes is zero. They are always inlined into the dispatched functions
+// below, so they are compiled for the instruction set of each of them.
+
+struct sum_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static T run(const T *data,
+                                const std::size_t size) noexcept {
+    T result{};
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      // independent accumulators hide latency of additions
+      vector acc0{};
+      vector acc1{};
+      vector acc2{};
+      vector acc3{};
+      for (; idx + 4 * lanes <= size; idx += 4 * lanes) {
+        acc0 += vector_at<Bytes>(data + idx);
+        acc1 += vector_at<Bytes>(data + idx + lanes);
+        acc2 += vector_at<Bytes>(data + idx + 2 * lanes);
+        acc3 += vector_at<Bytes>(data + idx + 3 * lanes);
+      }
+      for (; idx + lanes <= size; idx += lanes) {
+        acc0 += vector_at<Bytes>(data + idx);
+      }
+      acc0 = (acc0 + acc1) + (acc2 + acc3);
+      for (std::size_t lane{}; lane < lanes; ++lane) {
+        result += acc0[lane];
+      }
+    }
+    for (; idx < size; ++idx) {
+      result += data[idx];
+    }
+    return result;
+  }
+};
+
+template <bool maximum> struct extremum_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static T run(const T *data,
+                                const std::size_t size) noexcept {
+    assert(size > 0);
+    T result{data[0]};
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      vector acc0{};
+      acc0 += result;
+      vector acc1{acc0};
+      for (; idx + 2 * lanes <= size; idx += 2 * lanes) {
+        const vector first{vector_at<Bytes>(data + idx)};
+        const vector second{vector_at<Bytes>(data + idx + lanes)};
+        if constexpr (maximum) {
+          acc0 = acc0 < first ? first : acc0;
+          acc1 = acc1 < second ? second : acc1;
+        } else {
+          acc0 = first < acc0 ? first : acc0;
+          acc1 = second < acc1 ? second : acc1;
+        }
+      }
+      if constexpr (maximum) {
+        acc0 = acc0 < acc1 ? acc1 : acc0;
+      } else {
+        acc0 = acc1 < acc0 ? acc1 : acc0;
+      }
+      for (std::size_t lane{}; lane < lanes; ++lane) {
+        result = pick(result, acc0[lane]);
+      }
+    }
+    for (; idx < size; ++idx) {
+      result = pick(result, data[idx]);
+    }
+    return result;
+  }
+
+  template <typename T>
+  VLRX_SIMD_INLINE static T pick(const T current, const T value) noexcept {
+    if constexpr (maximum) {
+      return current < value ? value : current;
+    } else {
+      return value < current ? value : current;
+    }
+  }
+};
+
+struct find_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static std::size_t
+  run(const T *data, const std::size_t size, const T value) noexcept {
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      using words = typename vector_of<std::uint64_t, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      vector needle{};
+      needle += value;
+      // the block with a match is searched by the scalar loop below
+      for (; idx + 2 * lanes <= size; idx += 2 * lanes) {
+        // GCC scalarizes an OR of the comparisons themselves with AVX-512
+        const auto matches =
+            reinterpret_cast<words>(vector_at<Bytes>(data + idx) == needle) |
+            reinterpret_cast<words>(vector_at<Bytes>(data + idx + lanes) ==
+                                    needle);
+        std::uint64_t any{};
+        for (std::size_t word{}; word < Bytes / 8; ++word) {
+          any |= matches[word];
+        }
+        if (any != 0) {
+          break;
+        }
+      }
+    }
+    for (; idx < size; ++idx) {
+      if (data[idx] == value) {
+        return idx;
+      }
+    }
+    return size;
+  }
+};
+
+struct count_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static std::size_t
+  run(const T *data, const std::size_t size, const T value) noexcept {
+    std::size_t result{};
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      using lane_type = typename unsigned_of_size<sizeof(T)>::type;
+      using counters = typename vector_of<lane_type, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      // lanes are summed up before their counters overflow
+      constexpr std::size_t max_blocks{static_cast<std::size_t>(
+          std::min<std::uint64_t>(std::numeric_limits<lane_type>::max(),
+                                  std::uint64_t{1} << 32))};
+      vector needle{};
+      needle += value;
+      while (idx + lanes <= size) {
+        const auto end =
+            idx + std::min(max_blocks, (size - idx) / lanes) * lanes;
+        counters counts{};
+        for (; idx < end; idx += lanes) {
+          // matching lanes are all ones, that is minus one
+          counts -= reinterpret_cast<counters>(vector_at<Bytes>(data + idx) ==
+                                               needle);
+        }
+        for (std::size_t lane{}; lane < lanes; ++lane) {
+          result += counts[lane];
+        }
+      }
+    }
+    for (; idx < size; ++idx) {
+      result += data[idx] == value ? 1 : 0;
+    }
+    return result;
+  }
+};
+
+struct fill_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static void run(T *data, const std::size_t size,
+                                   const T value) noexcept {
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      vector values{};
+      values += value;
+      for (; idx + lanes <= size; idx += lanes) {
+        vector_at<Bytes>(data + idx) = values;
+      }
+    }
+    for (; idx < size; ++idx) {
+      data[idx] = value;
+    }
+  }
+};
+
+struct scale_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static void run(T *data, const std::size_t size,
+                                   const T factor) noexcept {
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      vector factors{};
+      factors += factor;
+      for (; idx + lanes <= size; idx += lanes) {
+        vector_at<Bytes>(data + idx) *= factors;
+      }
+    }
+    for (; idx < size; ++idx) {
+      data[idx] = static_cast<T>(data[idx] * factor);
+    }
+  }
+};
+
+struct axpy_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static void run(const T factor, const T *x, T *y,
+                                   const std::size_t size) noexcept {
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      vector factors{};
+      factors += factor;
+      for (; idx + lanes <= size; idx += lanes) {
+        vector_at<Bytes>(y + idx) += factors * vector_at<Bytes>(x + idx);
+      }
+    }
+    for (; idx < size; ++idx) {
+      y[idx] = static_cast<T>(y[idx] + factor * x[idx]);
+    }
+  }
+};
+
+struct clamp_kernel {
+  template <std::size_t Bytes, typename T>
+  VLRX_SIMD_INLINE static void run(T *data, const std::size_t size,
+                                   const T low, const T high) noexcept {
+    std::size_t idx{};
+    if constexpr (Bytes > 0) {
+      using vector = typename vector_of<T, Bytes>::type;
+      constexpr std::size_t lanes{Bytes / sizeof(T)};
+      vector lows{};
+      lows += low;
+      vector highs{};
+      highs += high;
+      for (; idx + lanes <= size; idx += lanes) {
+        vector values{vector_at<Bytes>(data + idx)};
+        values = values < lows ? lows : values;
+        values = highs < values ? highs : values;
+        vector_at<Bytes>(data + idx) = values;
+      }
+    }
+    for (; idx < size; ++idx) {
+      data[idx] = data[idx] < low ? low : (high < data[idx] ? high : data[idx]);
+    }
+  }
+};
+
+#if VLRX_SIMD_X86
+template <typename Kernel, typename... Args>
+__attribute__((target("sse2"))) auto run_sse2(const Args... args) noexcept {
+  return Kernel::template run<16>(args...);
+}
+
+template <typename Kernel, typename... Args>
+__attribute__((target("avx2"))) auto run_avx2(const Args... args) noexcept {
+  return Kernel::template run<32>(args...);
+}
+
+template <typename Kernel, typename... Args>
+__attribute__((target("avx512f,avx512bw"))) auto
+run_avx512(const Args... args) noexcept {
+  return Kernel::template run<64>(args...);
+}
+#endif
+
+template <typename T, typename Kernel, typename... Args>
+inline auto dispatch(const Args... args) noexcept {
+  if constexpr (is_vectorizable_v<T>) {
+#if VLRX_SIMD_X86
+    switch (active_level()) {
+    case level::avx512:
+      return run_avx512<Kernel>(args...);
+    case level::avx2:
+      return run_avx2<Kernel>(args...);
+    case level::sse2:
+      return run_sse2<Kernel>(args...);
+    case level::scalar:
+      break;
+    }
+#endif
+  }
+  return Kernel::template run<0>(args...);
+}
+
+// containers with contiguous elements of arithmetic type, e.g. heap_array
+// and std::span
+template <typename Container>
+using element_of = std::remove_pointer_t<decltype(std::data(
+    std::declval<Container &>()))>;
+
+template <typename Container>
+using enable_if_contiguous = std::enable_if_t<
+    std::is_arithmetic_v<std::remove_const_t<element_of<Container>>>, int>;
+
+} // namespace detail
+
+// Sum of the elements. Floating-point elements are added in several lanes,
+// so the result may be rounded differently than by std::accumulate.
+template <typename T>
+[[nodiscard]] inline T sum(const T *data, const std::size_t size) noexcept {
+  return detail::dispatch<T, detail::sum_kernel>(data, size);
+}
+
+// The smallest and the biggest of size > 0 elements, the result is
+// unspecified if floating-point elements include NaN.
+template <typename T>
+[[nodiscard]] inline T min(const T *data, const std::size_t size) noexcept {
+  return detail::dispatch<T, detail::extremum_kernel<false>>(data, size);
+}
+
+template <typename T>
+[[nodiscard]] inline T max(const T *data, const std::size_t size) noexcept {
+  return detail::dispatch<T, detail::extremum_kernel<true>>(data, size);
+}
+
+// index of the first element equal to value, or size if there is none
+template <typename T>
+[[nodiscard]] inline std::size_t
+find(const T *data, const std::size_t size,
+     const detail::identity_t<T> value) noexcept {
+  return detail::dispatch<T, detail::find_kernel>(data, size, value);
+}
+
+template <typename T>
+[[nodiscard]] inline std::size_t
+count(const T *data, const std::size_t size,
+      const detail::identity_t<T> value) noexcept {
+  return detail::dispatch<T, detail::count_kernel>(data, size, value);
+}
+
+// indices of the first smallest and the first biggest element, or size if
+// there are no elements
+template <typename T>
+[[nodiscard]] inline std::size_t argmin(const T *data,
+                                        const std::size_t size) noexcept {
+  return size == 0 ? 0 : simd::find(data, size, simd::min(data, size));
+}
+
+template <typename T>
+[[nodiscard]] inline std::size_t argmax(const T *data,
+                                        const std::size_t size) noexcept {
+  return size == 0 ? 0 : simd::find(data, size, simd::max(data, size));
+}
+
+template <typename T>
+inline void fill(T *data, const std::size_t size,
+                 const detail::identity_t<T> value) noexcept {
+  detail::dispatch<T, detail::fill_kernel>(data, size, value);
+}
+
+// multiplies elements by factor
+template <typename T>
+inline void scale(T *data, const std::size_t size,
+                  const detail::identity_t<T> factor) noexcept {
+  detail::dispatch<T, detail::scale_kernel>(data, size, factor);
+}
+
+// y[i] += factor * x[i] for i < size
+template <typename T>
+inline void axpy(const detail::identity_t<T> factor, const T *x, T *y,
+                 const std::size_t size) noexcept {
+  detail::dispatch<T, detail::axpy_kernel>(factor, x, y, size);
+}
+
+// limits elements to [low, high]
+template <typename T>
+inline void clamp(T *data, const std::size_t size,
+                  const detail::identity_t<T> low,
+                  const detail::identity_t<T> high) noexcept {
+  assert(!(high < low));
+  detail::dispatch<T, detail::clamp_kernel>(data, size, low, high);
+}
+
+// overloads for containers
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline auto sum(const Container &values) noexcept {
+  return simd::sum(std::data(values), std::size(values));
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline auto min(const Container &values) noexcept {
+  return simd::min(std::data(values), std::size(values));
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline auto max(const Container &values) noexcept {
+  return simd::max(std::data(values), std::size(values));
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline std::size_t argmin(const Container &values) noexcept {
+  return simd::argmin(std::data(values), std::size(values));
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline std::size_t argmax(const Container &values) noexcept {
+  return simd::argmax(std::data(values), std::size(values));
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline std::size_t
+find(const Container &values,
+     const detail::element_of<const Container> value) noexcept {
+  return simd::find(std::data(values), std::size(values), value);
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+[[nodiscard]] inline std::size_t
+count(const Container &values,
+      const detail::element_of<const Container> value) noexcept {
+  return simd::count(std::data(values), std::size(values), value);
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+inline void fill(Container &&values,
+                 const detail::element_of<Container> value) noexcept {
+  simd::fill(std::data(values), std::size(values), value);
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+inline void scale(Container &&values,
+                  const detail::element_of<Container> factor) noexcept {
+  simd::scale(std::data(values), std::size(values), factor);
+}
+
+// x and y have the same size
+template <typename Input, typename Output,
+          detail::enable_if_contiguous<Output> = 1>
+inline void axpy(const detail::element_of<Output> factor, const Input &x,
+                 Output &&y) noexcept {
+  assert(std::size(x) == std::size(y));
+  simd::axpy(factor, std::data(x), std::data(y), std::size(y));
+}
+
+template <typename Container, detail::enable_if_contiguous<Container> = 1>
+inline void clamp(Container &&values,
+                  const detail::element_of<Container> low,
+                  const detail::element_of<Container> high) noexcept {
+  simd::clamp(std::data(values), std::size(values), low, high);
+}
+
+} // namespace simd
+
+} // namespace vlrx
@@ -0,0 +1,542 @@
+#pragma once
+
+#include "heap_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vlrx {
+
+// Non-resizeable array which keeps up to N elements inline and allocates
+// larger ones on heap. Unlike heap_array, iterators of inline elements are
+// invalidated by move and swap.
+template <typename T, std::size_t N, typename SizeType = std::uint64_t,
+          typename Allocator = heap_allocator<T>>
+class small_heap_array final : private detail::allocator_holder<Allocator> {
+  static_assert(N > 0, "Inline capacity must not be zero");
+  static_assert(N <= std::numeric_limits<SizeType>::max(),
+                "Inline capacity must be representable by SizeType");
+  static_assert(std::is_same_v<typename Allocator::value_type, T>,
+                "Allocator::value_type must be the same as T");
+
+public:
+  using value_type = T;
+  using size_type = SizeType;
+  using allocator_type = Allocator;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const T *;
+  using iterator = detail::random_access_iterator<value_type, false>;
+  using const_iterator = detail::random_access_iterator<value_type, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_type inline_capacity = static_cast<size_type>(N);
+
+  small_heap_array() noexcept(noexcept(allocator_type()))
+      : small_heap_array(allocator_type()) {}
+
+  explicit small_heap_array(const allocator_type &alloc) noexcept
+      : allocator_base{alloc}, size_{} {}
+
+  // value-initializes size elements
+  explicit small_heap_array(const size_type size,
+                            const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, size_{} {
+    build(size, [&](storage_type *buffer) { construct_each(buffer, size); });
+  }
+
+  small_heap_array(const size_type size, const value_type &value,
+                   const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, size_{} {
+    build(size,
+          [&](storage_type *buffer) { construct_each(buffer, size, value); });
+  }
+
+  // default-initializes size elements, trivially default constructible
+  // elements are left uninitialized
+  small_heap_array(const size_type size, for_overwrite_t,
+                   const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, size_{} {
+    build(size, [&](storage_type *buffer) {
+      if constexpr (!std::is_trivially_default_constructible_v<value_type>) {
+        size_type idx{};
+        try {
+          for (; idx < size; ++idx) {
+            ::new (static_cast<void *>(buffer + idx)) value_type;
+          }
+        } catch (...) {
+          destroy_range(buffer, idx);
+          throw;
+        }
+      }
+    });
+  }
+
+  // builds i-th element in place from generator(i)
+  template <typename Generator>
+  small_heap_array(const size_type size, from_generator_t,
+                   Generator &&generator,
+                   const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, size_{} {
+    using result_type = std::invoke_result_t<Generator &, size_type>;
+    build(size, [&](storage_type *buffer) {
+      size_type idx{};
+      try {
+        for (; idx < size; ++idx) {
+          const auto element = reinterpret_cast<value_type *>(buffer + idx);
+          if constexpr (detail::uses_default_construct_v<
+                            allocator_type, value_type, result_type>) {
+            ::new (static_cast<void *>(element)) value_type(generator(idx));
+          } else {
+            alloc_traits::construct(get_allocator_ref(), element,
+                                    generator(idx));
+          }
+        }
+      } catch (...) {
+        destroy_range(buffer, idx);
+        throw;
+      }
+    });
+  }
+
+  template <typename ForwardIt,
+            typename std::enable_if_t<detail::is_forward_iterator_v<ForwardIt>,
+                                      int> = 1>
+  small_heap_array(ForwardIt first, ForwardIt last,
+                   const allocator_type &alloc = allocator_type())
+      : allocator_base{alloc}, size_{} {
+    const auto distance = std::distance(first, last);
+    assert(distance >= 0 &&
+           static_cast<std::make_unsigned_t<decltype(distance)>>(distance) <=
+               std::numeric_limits<size_type>::max());
+    const auto size = static_cast<size_type>(distance);
+    build(size,
+          [&](storage_type *buffer) { fill_buffer(first, buffer, size); });
+  }
+
+  template <typename ForwardRange>
+  small_heap_array(from_range_t, ForwardRange &&range,
+                   const allocator_type &alloc = allocator_type())
+      : small_heap_array(std::begin(range), std::end(range), alloc) {}
+
+  small_heap_array(std::initializer_list<value_type> init,
+                   const allocator_type &alloc = allocator_type())
+      : small_heap_array(init.begin(), init.end(), alloc) {}
+
+  small_heap_array(const small_heap_array &other)
+      : small_heap_array(other,
+                         alloc_traits::select_on_container_copy_construction(
+                             other.get_allocator_ref())) {}
+
+  small_heap_array(const small_heap_array &other, const allocator_type &alloc)
+      : allocator_base{alloc}, size_{} {
+    build(other.size_, [&](storage_type *buffer) {
+      copy_construct_buffer(other.data(), buffer, other.size_);
+    });
+  }
+
+  small_heap_array &operator=(const small_heap_array &other) {
+    if (this == &other) {
+      return *this;
+    }
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value) {
+      if (get_allocator_ref() != other.get_allocator_ref()) {
+        clear();
+      }
+      get_allocator_ref() = other.get_allocator_ref();
+    }
+    if (other.size_ != size_) {
+      rebuild(other.size_, [&](storage_type *buffer) {
+        copy_construct_buffer(other.data(), buffer, other.size_);
+      });
+    } else {
+      [[maybe_unused]] auto res =
+          std::copy(other.data(), other.data() + other.size_, data());
+    }
+    return *this;
+  }
+
+  // inline elements are moved one by one
+  small_heap_array(small_heap_array &&other) noexcept(
+      std::is_nothrow_move_constructible_v<value_type>)
+      : allocator_base{std::move(other.get_allocator_ref())}, size_{} {
+    take_from(other);
+  }
+
+  small_heap_array &operator=(small_heap_array &&other) noexcept(
+      std::is_nothrow_move_constructible_v<value_type> &&
+      (alloc_traits::propagate_on_container_move_assignment::value ||
+       alloc_traits::is_always_equal::value)) {
+    if (this == &other) {
+      return *this;
+    }
+    if constexpr (!alloc_traits::propagate_on_container_move_assignment::
+                      value &&
+                  !alloc_traits::is_always_equal::value) {
+      if (get_allocator_ref() != other.get_allocator_ref()) {
+        if (other.size_ != size_) {
+          rebuild(other.size_, [&](storage_type *buffer) {
+            fill_buffer(std::make_move_iterator(other.data()), buffer,
+                        other.size_);
+          });
+        } else {
+          [[maybe_unused]] auto res =
+              std::move(other.data(), other.data() + other.size_, data());
+        }
+        return *this;
+      }
+    }
+    clear();
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                      value) {
+      get_allocator_ref() = std::move(other.get_allocator_ref());
+    }
+    take_from(other);
+    return *this;
+  }
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept {
+    return get_allocator_ref();
+  }
+
+  [[nodiscard]] const_reference at(const size_type pos) const {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return data()[pos];
+  }
+
+  [[nodiscard]] reference at(const size_type pos) {
+    if (pos >= size_) {
+      throw std::out_of_range("Trying to access element which is out of range");
+    }
+    return data()[pos];
+  }
+
+  [[nodiscard]] const_reference operator[](const size_type pos) const noexcept {
+    assert(pos < size_);
+    return data()[pos];
+  }
+
+  [[nodiscard]] reference operator[](const size_type pos) noexcept {
+    assert(pos < size_);
+    return data()[pos];
+  }
+
+  [[nodiscard]] reference front() noexcept { return data()[0]; }
+
+  [[nodiscard]] const_reference front() const noexcept { return data()[0]; }
+
+  [[nodiscard]] reference back() noexcept { return data()[size_ - 1]; }
+
+  [[nodiscard]] const_reference back() const noexcept {
+    return data()[size_ - 1];
+  }
+
+  [[nodiscard]] pointer data() noexcept {
+    return to_value_type_pointer(storage());
+  }
+
+  [[nodiscard]] const_pointer data() const noexcept {
+    return to_value_type_pointer(storage());
+  }
+
+  iterator begin() noexcept { return iterator{data()}; }
+
+  const_iterator begin() const noexcept { return const_iterator{data()}; }
+
+  const_iterator cbegin() const noexcept { return const_iterator{data()}; }
+
+  reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  const_reverse_iterator crbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  iterator end() noexcept { return iterator{data() + size_}; }
+
+  const_iterator end() const noexcept {
+    return const_iterator{data() + size_};
+  }
+
+  const_iterator cend() const noexcept {
+    return const_iterator{data() + size_};
+  }
+
+  reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  const_reverse_iterator crend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] size_type max_size() const noexcept { return size_; }
+
+  // whether elements are stored inside of the object
+  [[nodiscard]] bool is_inline() const noexcept { return size_ <= N; }
+
+  void swap(small_heap_array &other) noexcept(
+      std::is_nothrow_move_constructible_v<value_type>) {
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      using std::swap;
+      swap(get_allocator_ref(), other.get_allocator_ref());
+    } else {
+      assert(get_allocator_ref() == other.get_allocator_ref());
+    }
+    if (!is_inline() && !other.is_inline()) {
+      std::swap(heap_storage_, other.heap_storage_);
+      std::swap(size_, other.size_);
+      return;
+    }
+    small_heap_array temp{std::move(other)};
+    other.clear();
+    other.take_from(*this);
+    clear();
+    take_from(temp);
+  }
+
+  ~small_heap_array() { clear(); }
+
+private:
+  using allocator_base = detail::allocator_holder<allocator_type>;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+  using storage_type = typename std::aligned_storage<sizeof(value_type),
+                                                     alignof(value_type)>::type;
+  using storage_allocator_type =
+      typename alloc_traits::template rebind_alloc<storage_type>;
+  using storage_traits = std::allocator_traits<storage_allocator_type>;
+
+  static_assert(
+      std::is_same_v<typename storage_traits::pointer, storage_type *>,
+      "Allocators with fancy pointers are not supported");
+
+  using allocator_base::get_allocator_ref;
+
+  static constexpr bool is_bitwise_copy_constructible =
+      std::is_trivially_copy_constructible_v<value_type> &&
+      detail::uses_default_construct_v<allocator_type, value_type,
+                                       const value_type &>;
+
+  size_type size_;
+  union {
+    storage_type inline_storage_[N];
+    storage_type *heap_storage_;
+  };
+
+  [[nodiscard]] storage_type *storage() noexcept {
+    return is_inline() ? inline_storage_ : heap_storage_;
+  }
+
+  [[nodiscard]] const storage_type *storage() const noexcept {
+    return is_inline() ? inline_storage_ : heap_storage_;
+  }
+
+  pointer to_value_type_pointer(storage_type *storage_pointer) noexcept {
+    return std::launder(reinterpret_cast<value_type *>(storage_pointer));
+  }
+
+  const_pointer to_value_type_pointer(
+      const storage_type *storage_pointer) const noexcept {
+    return std::launder(reinterpret_cast<const value_type *>(storage_pointer));
+  }
+
+  // constructs size elements with fill(buffer) into inline or heap storage,
+  // the container must not hold any elements
+  template <typename Fill> void build(const size_type size, Fill &&fill) {
+    assert(size_ == 0);
+    if (size <= N) {
+      fill(inline_storage_);
+    } else {
+      auto buffer = allocate_buffer(size);
+      try {
+        fill(buffer);
+      } catch (...) {
+        deallocate_buffer(buffer, size);
+        throw;
+      }
+      heap_storage_ = buffer;
+    }
+    size_ = size;
+  }
+
+  // replaces elements with size elements constructed with fill(buffer),
+  // elements already held are kept if heap allocation or fill throws
+  template <typename Fill> void rebuild(const size_type size, Fill &&fill) {
+    if (size <= N) {
+      clear();
+      build(size, std::forward<Fill>(fill));
+      return;
+    }
+    auto buffer = allocate_buffer(size);
+    try {
+      fill(buffer);
+    } catch (...) {
+      deallocate_buffer(buffer, size);
+      throw;
+    }
+    clear();
+    heap_storage_ = buffer;
+    size_ = size;
+  }
+
+  // destroys elements and releases heap storage
+  void clear() noexcept {
+    destroy_range(storage(), size_);
+    if (!is_inline()) {
+      deallocate_buffer(heap_storage_, size_);
+    }
+    size_ = 0;
+  }
+
+  // takes elements of other, which is left empty, the container must not
+  // hold any elements
+  void take_from(small_heap_array &other) {
+    assert(size_ == 0);
+    if (other.is_inline()) {
+      fill_buffer(std::make_move_iterator(other.data()), inline_storage_,
+                  other.size_);
+      size_ = other.size_;
+      other.clear();
+    } else {
+      heap_storage_ = other.heap_storage_;
+      size_ = other.size_;
+      other.size_ = 0;
+    }
+  }
+
+  void destroy_range(storage_type *storage, const size_type size) noexcept {
+    if constexpr (std::is_trivially_destructible_v<value_type> == false) {
+      for (size_type i{}; i < size; ++i) {
+        alloc_traits::destroy(get_allocator_ref(),
+                              to_value_type_pointer(storage + i));
+      }
+    }
+  }
+
+  [[nodiscard]] storage_type *allocate_buffer(const size_type size) {
+    storage_allocator_type storage_allocator{get_allocator_ref()};
+    return storage_traits::allocate(storage_allocator, size);
+  }
+
+  void deallocate_buffer(storage_type *buffer, const size_type size) noexcept {
+    storage_allocator_type storage_allocator{get_allocator_ref()};
+    storage_traits::deallocate(storage_allocator, buffer, size);
+  }
+
+  void copy_construct_buffer(const_pointer source, storage_type *storage,
+                             const size_type size) {
+    if constexpr (is_bitwise_copy_constructible) {
+      if (size > 0) {
+        std::memcpy(static_cast<void *>(storage),
+                    static_cast<const void *>(source),
+                    sizeof(storage_type) * size);
+      }
+    } else {
+      fill_buffer(source, storage, size);
+    }
+  }
+
+  // constructs size elements from the same args, already constructed
+  // elements are destroyed if any of constructors throws
+  template <typename... Args>
+  void construct_each(storage_type *storage, const size_type size,
+                      const Args &...args) {
+    size_type idx{};
+    try {
+      for (; idx < size; ++idx) {
+        alloc_traits::construct(get_allocator_ref(),
+                                reinterpret_cast<value_type *>(storage + idx),
+                                args...);
+      }
+    } catch (...) {
+      destroy_range(storage, idx);
+      throw;
+    }
+  }
+
+  // constructs size elements from [iter, iter + size), already constructed
+  // elements are destroyed if any of constructors throws
+  template <typename Input>
+  void fill_buffer(Input iter, storage_type *storage, const size_type size) {
+    size_type idx{};
+    try {
+      for (; idx < size; ++idx, ++iter) {
+        alloc_traits::construct(get_allocator_ref(),
+                                reinterpret_cast<value_type *>(storage + idx),
+                                *iter);
+      }
+    } catch (...) {
+      destroy_range(storage, idx);
+      throw;
+    }
+  }
+};
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline void swap(small_heap_array<VType, N, SType, Alloc> &lhs,
+                 small_heap_array<VType, N, SType, Alloc> &rhs) noexcept(
+    noexcept(lhs.swap(rhs))) {
+  lhs.swap(rhs);
+}
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline bool operator==(const small_heap_array<VType, N, SType, Alloc> &lhs,
+                       const small_heap_array<VType, N, SType, Alloc> &rhs) {
+  return detail::equal_elements(lhs, rhs);
+}
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline bool operator!=(const small_heap_array<VType, N, SType, Alloc> &lhs,
+                       const small_heap_array<VType, N, SType, Alloc> &rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline bool operator<(const small_heap_array<VType, N, SType, Alloc> &lhs,
+                      const small_heap_array<VType, N, SType, Alloc> &rhs) {
+  return detail::less_elements(lhs, rhs);
+}
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline bool operator>(const small_heap_array<VType, N, SType, Alloc> &lhs,
+                      const small_heap_array<VType, N, SType, Alloc> &rhs) {
+  return rhs < lhs;
+}
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline bool operator<=(const small_heap_array<VType, N, SType, Alloc> &lhs,
+                       const small_heap_array<VType, N, SType, Alloc> &rhs) {
+  return !(lhs > rhs);
+}
+
+template <typename VType, std::size_t N, typename SType, typename Alloc>
+inline bool operator>=(const small_heap_array<VType, N, SType, Alloc> &lhs,
+                       const small_heap_array<VType, N, SType, Alloc> &rhs) {
+  return !(lhs < rhs);
+}
+
+} // namespace vlrx
@@ -2,8 +2,42 @@
 #include "catch.hpp"
 
 #include "heap_array.hpp"
+#include "heap_array_publisher.hpp"
+#include "heap_array_stream.hpp"
+#include "heap_mdarray.hpp"
+#include "heap_search_index.hpp"
+#include "heap_soa_array.hpp"
+#include "mapped_array_view.hpp"
+#include "mmap_allocator.hpp"
+#include "packed_heap_array.hpp"
+#include "parallel_policy.hpp"
+#include "pool_allocator.hpp"
+#include "shared_heap_array.hpp"
+#include "simd_algorithms.hpp"
+#include "small_heap_array.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <forward_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if VLRX_CPP20
+#include <ranges>
+#include <span>
+#endif
 
 struct mock_struct {
   explicit mock_struct(std::uint16_t *counter) : counter_{counter} {}
@@ -25,6 +59,68 @@ struct mock_struct {
   std::uint16_t *counter_;
 };
 
+struct move_only_struct {
+  explicit move_only_struct(int value) : value_{value} {}
+  move_only_struct(const move_only_struct &) = delete;
+  move_only_struct(move_only_struct &&other) noexcept : value_{other.value_} {
+    other.value_ = -1;
+    ++moves;
+  }
+  move_only_struct &operator=(const move_only_struct &) = delete;
+  move_only_struct &operator=(move_only_struct &&other) noexcept {
+    value_ = other.value_;
+    other.value_ = -1;
+    ++moves;
+    return *this;
+  }
+  int value_;
+  static inline int moves{};
+};
+
+struct pod_struct {
+  int int_field;
+  double double_field;
+  char chars[12];
+};
+
+template <typename T> struct counting_allocator {
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit counting_allocator(std::int64_t *live_allocations) noexcept
+      : live_allocations_{live_allocations} {}
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &other) noexcept
+      : live_allocations_{other.live_allocations_} {}
+
+  T *allocate(const std::size_t size) {
+    ++(*live_allocations_);
+    return std::allocator<T>{}.allocate(size);
+  }
+
+  void deallocate(T *ptr, const std::size_t size) noexcept {
+    --(*live_allocations_);
+    std::allocator<T>{}.deallocate(ptr, size);
+  }
+
+  template <typename U>
+  friend bool operator==(const counting_allocator &lhs,
+                         const counting_allocator<U> &rhs) {
+    return lhs.live_allocations_ == rhs.live_allocations_;
+  }
+
+  template <typename U>
+  friend bool operator!=(const counting_allocator &lhs,
+                         const counting_allocator<U> &rhs) {
+    return !(lhs == rhs);
+  }
+
+  std::int64_t *live_allocations_;
+};
+
 TEST_CASE("It is possible to create heap_array from initializer list",
           "[construction][initializer list][pod]") {
   {
@@ -267,4 +363,1909 @@ TEST_CASE("Non-const iterator is convertible to const iterator",
   vlrx::heap_array<int> array{1, 2, 3};
   vlrx::heap_array<int>::const_iterator iter = array.begin();
   REQUIRE(*iter == *array.begin());
-}
\ No newline at end of file
+}
+
+TEST_CASE("Iterators are trivially copyable and keep position when moved",
+          "[iterator][move]") {
+  static_assert(
+      std::is_trivially_copyable_v<vlrx::heap_array<int>::iterator>);
+  static_assert(
+      std::is_trivially_copyable_v<vlrx::heap_array<int>::const_iterator>);
+  vlrx::heap_array<int> array{1, 2, 3};
+  auto iter = array.begin() + 1;
+  const auto moved = std::move(iter);
+  REQUIRE(*moved == 2);
+  REQUIRE(iter == moved);
+}
+
+#if VLRX_CPP20
+namespace {
+
+int sum_of(const std::span<const int> values) {
+  return std::accumulate(values.begin(), values.end(), 0);
+}
+
+void increment(const std::span<int> values) {
+  for (auto &value : values) {
+    ++value;
+  }
+}
+
+} // namespace
+
+TEST_CASE("Containers are contiguous ranges convertible to std::span",
+          "[iterator][span]") {
+  static_assert(
+      std::contiguous_iterator<vlrx::heap_array<int>::iterator>);
+  static_assert(
+      std::contiguous_iterator<vlrx::heap_array<int>::const_iterator>);
+  static_assert(std::ranges::contiguous_range<vlrx::compact_heap_array<int>>);
+  static_assert(std::ranges::contiguous_range<vlrx::small_heap_array<int, 4>>);
+  vlrx::heap_array<int> array{1, 2, 3};
+  REQUIRE(std::to_address(array.begin() + 1) == array.data() + 1);
+  increment(array);
+  REQUIRE(sum_of(array) == 9);
+  const auto &const_array = array;
+  const std::span<const int> view = const_array;
+  REQUIRE(view.data() == array.data());
+  vlrx::small_heap_array<int, 4> small{1, 1};
+  increment(small);
+  REQUIRE(sum_of(small) == 4);
+  const vlrx::shared_heap_array<int> shared{array.begin(), array.end()};
+  auto copy = shared;
+  increment(copy);
+  REQUIRE(sum_of(shared) == 9);
+  REQUIRE(sum_of(copy) == 12);
+}
+
+namespace {
+
+constexpr std::uint32_t crc32_of_byte(const std::uint64_t byte) {
+  auto crc = static_cast<std::uint32_t>(byte);
+  for (int bit{}; bit < 8; ++bit) {
+    crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+  }
+  return crc;
+}
+
+// built in a heap_array at compile time and copied into static storage
+constexpr auto crc32_table = [] {
+  const vlrx::heap_array<std::uint32_t> table(256, vlrx::from_generator,
+                                              crc32_of_byte);
+  std::array<std::uint32_t, 256> result{};
+  std::copy(table.begin(), table.end(), result.begin());
+  return result;
+}();
+
+static_assert(crc32_table[1] == 0x77073096u);
+static_assert(crc32_table[255] == 0x2D02EF8Du);
+
+constexpr bool heap_array_works_in_constant_expressions() {
+  const vlrx::heap_array<int> values{3, 1, 2};
+  const vlrx::heap_array<int> zeroed(4);
+  const vlrx::heap_array<int> filled(2, 7);
+  vlrx::heap_array<int> overwritten(2, vlrx::for_overwrite);
+  overwritten[0] = 7;
+  overwritten.at(1) = 7;
+  auto copy = values;
+  std::sort(copy.begin(), copy.end());
+  const vlrx::heap_array<int> moved{std::move(copy)};
+  copy = filled;
+  vlrx::heap_array<std::string> strings{"a", "bc"};
+  strings = vlrx::heap_array<std::string>(3, "d");
+  return moved == vlrx::heap_array<int>{1, 2, 3} && values > moved &&
+         zeroed.back() == 0 && copy == filled && overwritten == filled &&
+         std::accumulate(values.rbegin(), values.rend(), 0) == 6 &&
+         strings.size() == 3 && strings.front() == "d";
+}
+
+static_assert(heap_array_works_in_constant_expressions());
+
+} // namespace
+
+TEST_CASE("Heap arrays are built and used in constant expressions",
+          "[constexpr]") {
+  const vlrx::heap_array<std::uint32_t> table(256, vlrx::from_generator,
+                                              crc32_of_byte);
+  REQUIRE(std::equal(table.begin(), table.end(), crc32_table.begin()));
+  REQUIRE(heap_array_works_in_constant_expressions());
+}
+#endif
+
+TEST_CASE("Stateless allocator does not increase size of the container",
+          "[allocator][size]") {
+  static_assert(sizeof(vlrx::heap_array<int>) ==
+                sizeof(int *) + sizeof(std::uint64_t));
+  static_assert(sizeof(vlrx::heap_array<int, std::uint64_t,
+                                        std::allocator<int>>) ==
+                sizeof(vlrx::heap_array<int>));
+}
+
+TEST_CASE("Allocator is used for every allocation and propagated",
+          "[allocator][copy][move][swap]") {
+  std::int64_t allocations{};
+  std::int64_t allocations1{};
+  {
+    using array_type =
+        vlrx::heap_array<int, std::uint64_t, counting_allocator<int>>;
+    array_type test_array{{1, 2, 3}, counting_allocator<int>{&allocations}};
+    REQUIRE(allocations == 1);
+    array_type copy{test_array};
+    REQUIRE(allocations == 2);
+    array_type other{{4, 5}, counting_allocator<int>{&allocations1}};
+    REQUIRE(allocations1 == 1);
+    other = copy; // propagates allocator, old buffer is released by its owner
+    REQUIRE(allocations1 == 0);
+    REQUIRE(allocations == 3);
+    REQUIRE(other == test_array);
+    array_type moved_to{std::move(other)};
+    REQUIRE(allocations == 3);
+    REQUIRE(moved_to.get_allocator() == counting_allocator<int>{&allocations});
+    array_type swapped{{7}, counting_allocator<int>{&allocations1}};
+    swap(swapped, moved_to);
+    REQUIRE(swapped.get_allocator() == counting_allocator<int>{&allocations});
+    REQUIRE(moved_to.get_allocator() ==
+            counting_allocator<int>{&allocations1});
+  }
+  REQUIRE(allocations == 0);
+  REQUIRE(allocations1 == 0);
+}
+
+TEST_CASE("pmr heap_array allocates from the memory resource",
+          "[allocator][pmr]") {
+  std::byte buffer[1024];
+  std::pmr::monotonic_buffer_resource resource{
+      buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+  vlrx::pmr::heap_array<int> test_array{{1, 2, 3, 4, 5}, &resource};
+  REQUIRE(static_cast<void *>(test_array.data()) >=
+          static_cast<void *>(buffer));
+  REQUIRE(static_cast<void *>(test_array.data()) <
+          static_cast<void *>(buffer + sizeof(buffer)));
+  vlrx::pmr::heap_array<int> moved_to{std::move(test_array),
+                                      std::pmr::new_delete_resource()};
+  REQUIRE(moved_to == vlrx::pmr::heap_array<int>{1, 2, 3, 4, 5});
+  vlrx::pmr::heap_array<int> assigned{{1}, &resource};
+  assigned = std::move(moved_to); // allocators differ, elements are moved
+  REQUIRE(assigned.get_allocator().resource() == &resource);
+  REQUIRE(assigned == vlrx::pmr::heap_array<int>{1, 2, 3, 4, 5});
+}
+
+TEST_CASE("Sized constructors value-initialize, copy value or default-init",
+          "[construction][sized][for overwrite]") {
+  {
+    const vlrx::heap_array<int> test_array(1000);
+    REQUIRE(test_array.size() == 1000);
+    REQUIRE(std::all_of(test_array.begin(), test_array.end(),
+                        [](const int val) { return val == 0; }));
+  }
+  {
+    const vlrx::heap_array<double *> test_array(3);
+    REQUIRE(test_array[2] == nullptr);
+  }
+  {
+    const vlrx::heap_array<int> test_array(4, 7);
+    REQUIRE(test_array == vlrx::heap_array<int>{7, 7, 7, 7});
+  }
+  {
+    vlrx::heap_array<int> test_array(5, vlrx::for_overwrite);
+    REQUIRE(test_array.size() == 5);
+    std::fill(test_array.begin(), test_array.end(), 2);
+    REQUIRE(test_array == vlrx::heap_array<int>{2, 2, 2, 2, 2});
+  }
+  {
+    const vlrx::heap_array<std::string> test_array(3, vlrx::for_overwrite);
+    REQUIRE(test_array[1].empty());
+  }
+  {
+    std::uint16_t counter{};
+    {
+      vlrx::heap_array<mock_struct> test_array(3, mock_struct{&counter});
+    }
+    REQUIRE(counter == 4); // 3 from array + 1 from temporary
+  }
+  {
+    const vlrx::heap_array<int> test_array(0);
+    REQUIRE(test_array.empty());
+    REQUIRE(test_array.data() == nullptr);
+  }
+}
+
+TEST_CASE("Sized constructor works with allocators without allocate_zeroed",
+          "[construction][sized][allocator]") {
+  std::int64_t allocations{};
+  {
+    const vlrx::heap_array<long, std::uint64_t, counting_allocator<long>>
+        test_array(16, counting_allocator<long>{&allocations});
+    REQUIRE(allocations == 1);
+    REQUIRE(test_array[15] == 0);
+  }
+  REQUIRE(allocations == 0);
+}
+
+TEST_CASE("It is possible to create heap_array from iterators and ranges",
+          "[construction][iterators][range]") {
+  const std::vector<int> source{1, 2, 3, 4};
+  const vlrx::heap_array<int> test_array(source.begin(), source.end());
+  REQUIRE(test_array == vlrx::heap_array<int>{1, 2, 3, 4});
+  const std::forward_list<int> list{5, 6, 7};
+  const vlrx::heap_array<int> from_list{vlrx::from_range, list};
+  REQUIRE(from_list == vlrx::heap_array<int>{5, 6, 7});
+  const vlrx::heap_array<int> from_array{test_array.begin() + 1,
+                                         test_array.end()};
+  REQUIRE(from_array == vlrx::heap_array<int>{2, 3, 4});
+}
+
+TEST_CASE("Move-only types are supported",
+          "[construction][move only][move iterator][generator]") {
+  std::vector<std::unique_ptr<int>> source;
+  source.push_back(std::make_unique<int>(1));
+  source.push_back(std::make_unique<int>(2));
+  vlrx::heap_array<std::unique_ptr<int>> test_array(
+      std::make_move_iterator(source.begin()),
+      std::make_move_iterator(source.end()));
+  REQUIRE(*test_array[1] == 2);
+  REQUIRE(source[1] == nullptr);
+  vlrx::heap_array<std::unique_ptr<int>> moved_to{std::move(test_array)};
+  REQUIRE(*moved_to[0] == 1);
+  test_array = std::move(moved_to);
+  REQUIRE(*test_array[0] == 1);
+
+  move_only_struct::moves = 0;
+  const vlrx::heap_array<move_only_struct> generated(
+      4, vlrx::from_generator,
+      [](const std::uint64_t idx) {
+        return move_only_struct{static_cast<int>(idx * 2)};
+      });
+  REQUIRE(generated[3].value_ == 6);
+  REQUIRE(move_only_struct::moves == 0); // built in place
+}
+
+TEST_CASE("Trivially copyable elements are copied and assigned in bulk",
+          "[copy][assignment][trivially copyable]") {
+  vlrx::heap_array<pod_struct> test_array(3);
+  test_array[1] = pod_struct{1, 2.0, "abc"};
+  const vlrx::heap_array<pod_struct> copy{test_array};
+  REQUIRE(copy[1].int_field == 1);
+  REQUIRE(copy[1].double_field == 2.0);
+  REQUIRE(std::string{copy[1].chars} == "abc");
+  vlrx::heap_array<pod_struct> assigned(3, vlrx::for_overwrite);
+  const auto data = assigned.data();
+  assigned = copy;
+  REQUIRE(assigned.data() == data); // same size, buffer is reused
+  REQUIRE(assigned[1].int_field == 1);
+  vlrx::heap_array<double> doubles(4, 0.5);
+  REQUIRE(doubles == vlrx::heap_array<double>{0.5, 0.5, 0.5, 0.5});
+  doubles = vlrx::heap_array<double>{1.0, 2.0};
+  REQUIRE(doubles == vlrx::heap_array<double>{1.0, 2.0});
+  vlrx::heap_array<double> empty{};
+  doubles = empty;
+  REQUIRE(doubles.empty());
+
+  // elements are constructed from the value, not assigned
+  struct const_member {
+    const int value;
+  };
+  static_assert(!std::is_copy_assignable_v<const_member>);
+  const vlrx::heap_array<const_member> constants(3, const_member{7});
+  REQUIRE(constants[2].value == 7);
+  const vlrx::heap_array<const_member> constants_copy{constants};
+  REQUIRE(constants_copy[0].value == 7);
+}
+
+TEST_CASE("Aligned layout aligns the buffer and pads it with zeroes",
+          "[layout][alignment][padding]") {
+  static_assert(sizeof(vlrx::aligned_heap_array<float>) ==
+                sizeof(vlrx::heap_array<float>));
+  static_assert(vlrx::heap_array<float>::alignment == alignof(float));
+  static_assert(vlrx::aligned_heap_array<float, 32>::alignment == 32);
+  const vlrx::aligned_heap_array<float> test_array{1.0f, 2.0f, 3.0f};
+  REQUIRE(reinterpret_cast<std::uintptr_t>(test_array.data()) % 64 == 0);
+  REQUIRE(test_array.aligned_data() == test_array.data());
+  REQUIRE(test_array.padded_size() == 16);
+  for (std::uint64_t idx{test_array.size()}; idx < test_array.padded_size();
+       ++idx) {
+    REQUIRE(test_array.data()[idx] == 0.0f);
+  }
+  const vlrx::aligned_heap_array<float> copy{test_array};
+  REQUIRE(copy == test_array);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(copy.data()) % 64 == 0);
+  const vlrx::aligned_heap_array<double> zeroed(17);
+  REQUIRE(zeroed.padded_size() == 24);
+  REQUIRE(zeroed[16] == 0.0);
+  const vlrx::heap_array<float> natural{1.0f, 2.0f, 3.0f};
+  REQUIRE(natural.padded_size() == natural.size());
+}
+
+TEST_CASE("Aligned layout works with non-trivial and pmr-allocated types",
+          "[layout][alignment][allocator]") {
+  const vlrx::heap_array<std::string, std::uint64_t,
+                         vlrx::heap_allocator<std::string>,
+                         vlrx::cache_line_layout>
+      strings{"a", "b"};
+  REQUIRE(strings[1] == "b");
+  REQUIRE(reinterpret_cast<std::uintptr_t>(strings.data()) % 64 == 0);
+  const vlrx::heap_array<int, std::uint64_t,
+                         std::pmr::polymorphic_allocator<int>,
+                         vlrx::aligned_layout<32>>
+      ints(5, 1);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(ints.data()) % 32 == 0);
+  REQUIRE(ints.padded_size() == 8);
+}
+
+TEST_CASE("Compact layout stores size in the heap buffer",
+          "[layout][compact][size]") {
+  static_assert(sizeof(vlrx::compact_heap_array<int>) == sizeof(int *));
+  static_assert(sizeof(vlrx::compact_heap_array<char, std::uint32_t>) ==
+                sizeof(char *));
+  static_assert(sizeof(vlrx::heap_array<float, std::uint64_t,
+                                        vlrx::heap_allocator<float>,
+                                        vlrx::compact_layout<
+                                            vlrx::cache_line_layout>>) ==
+                sizeof(float *));
+  const vlrx::compact_heap_array<int> empty{};
+  REQUIRE(empty.empty());
+  REQUIRE(empty.size() == 0);
+  REQUIRE(empty.data() == nullptr);
+  REQUIRE(empty.padded_size() == 0);
+  vlrx::compact_heap_array<int> test_array{1, 2, 3};
+  REQUIRE(test_array.size() == 3);
+  REQUIRE(test_array.back() == 3);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(test_array.data()) % alignof(int) ==
+          0);
+  vlrx::compact_heap_array<int> copy{test_array};
+  REQUIRE(copy == test_array);
+  copy = vlrx::compact_heap_array<int>{4, 5};
+  REQUIRE(copy.size() == 2);
+  swap(copy, test_array);
+  REQUIRE(copy.size() == 3);
+  REQUIRE(test_array == vlrx::compact_heap_array<int>{4, 5});
+  vlrx::compact_heap_array<int> moved_to{std::move(test_array)};
+  REQUIRE(test_array.empty());
+  REQUIRE(moved_to.size() == 2);
+  const vlrx::compact_heap_array<char, std::uint8_t> chars(5, 'a');
+  REQUIRE(chars.size() == 5);
+  REQUIRE(chars.padded_size() >= 5);
+  const vlrx::compact_heap_array<double> zeroed(7);
+  REQUIRE(zeroed.size() == 7);
+  REQUIRE(zeroed[6] == 0.0);
+  const vlrx::heap_array<
+      float, std::uint64_t, vlrx::heap_allocator<float>,
+      vlrx::compact_layout<vlrx::cache_line_layout>>
+      aligned{1.0f, 2.0f};
+  REQUIRE(reinterpret_cast<std::uintptr_t>(aligned.data()) % 64 == 0);
+  REQUIRE(aligned.size() == 2);
+  REQUIRE(aligned.padded_size() == 16);
+}
+
+TEST_CASE("Compact layout works with non-trivial types",
+          "[layout][compact][destructors]") {
+  std::uint16_t counter{};
+  {
+    vlrx::heap_array<mock_struct, std::uint64_t,
+                     vlrx::heap_allocator<mock_struct>, vlrx::compact_layout<>>
+        test_array(4, mock_struct{&counter});
+    REQUIRE(test_array.size() == 4);
+  }
+  REQUIRE(counter == 5);
+}
+
+TEST_CASE("Small heap array keeps small arrays inline",
+          "[small heap array][inline][allocator]") {
+  std::int64_t allocations{};
+  using array_type =
+      vlrx::small_heap_array<int, 4, std::uint64_t, counting_allocator<int>>;
+  {
+    const array_type small{{1, 2, 3}, counting_allocator<int>{&allocations}};
+    REQUIRE(small.is_inline());
+    REQUIRE(allocations == 0);
+    REQUIRE(small.size() == 3);
+    REQUIRE(small[2] == 3);
+    REQUIRE(small.at(1) == 2);
+    REQUIRE_THROWS(small.at(3));
+    REQUIRE(reinterpret_cast<const unsigned char *>(small.data()) >=
+            reinterpret_cast<const unsigned char *>(&small));
+    REQUIRE(reinterpret_cast<const unsigned char *>(small.data()) <
+            reinterpret_cast<const unsigned char *>(&small) + sizeof(small));
+    array_type big{{1, 2, 3, 4, 5}, counting_allocator<int>{&allocations}};
+    REQUIRE_FALSE(big.is_inline());
+    REQUIRE(allocations == 1);
+    array_type copy{small};
+    REQUIRE(copy == small);
+    copy = big;
+    REQUIRE(allocations == 2);
+    REQUIRE(copy == big);
+    copy = small;
+    REQUIRE(allocations == 1);
+    REQUIRE(copy.is_inline());
+    swap(copy, big);
+    REQUIRE(copy.size() == 5);
+    REQUIRE(big == small);
+    array_type moved_to{std::move(copy)};
+    REQUIRE(copy.empty());
+    REQUIRE(moved_to.size() == 5);
+    REQUIRE(allocations == 1);
+  }
+  REQUIRE(allocations == 0);
+}
+
+TEST_CASE("Small heap array shares iterators and semantics with heap array",
+          "[small heap array][iterators][comparison][move only]") {
+  static_assert(
+      std::is_same_v<vlrx::small_heap_array<int, 8>::iterator,
+                     vlrx::heap_array<int>::iterator>);
+  const vlrx::small_heap_array<int, 2> lhs{1, 2, 3};
+  const vlrx::small_heap_array<int, 2> rhs{1, 2};
+  REQUIRE(rhs < lhs);
+  REQUIRE(lhs != rhs);
+  REQUIRE(*lhs.rbegin() == 3);
+  REQUIRE(std::equal(lhs.begin(), lhs.end(),
+                     vlrx::heap_array<int>{1, 2, 3}.begin()));
+  std::uint16_t counter{};
+  {
+    vlrx::small_heap_array<mock_struct, 2> inline_array(
+        2, mock_struct{&counter});
+    vlrx::small_heap_array<mock_struct, 2> heap_array(3,
+                                                      mock_struct{&counter});
+    inline_array.swap(heap_array);
+    REQUIRE(inline_array.size() == 3);
+    REQUIRE(heap_array.size() == 2);
+  }
+  REQUIRE(counter == 9); // 2 temporaries + 5 elements + 2 inline elements
+                         // moved from during swap
+  vlrx::small_heap_array<std::unique_ptr<int>, 2> pointers(
+      2, vlrx::from_generator,
+      [](const std::uint64_t idx) {
+        return std::make_unique<int>(static_cast<int>(idx));
+      });
+  auto moved_pointers{std::move(pointers)};
+  REQUIRE(*moved_pointers[1] == 1);
+}
+
+TEST_CASE("Mmap allocator maps big buffers and uses heap for small ones",
+          "[allocator][mmap][huge pages]") {
+  const vlrx::mmap_heap_array<int> small{1, 2, 3};
+  REQUIRE(small == vlrx::mmap_heap_array<int>{1, 2, 3});
+  constexpr std::uint64_t big_size{vlrx::huge_page_size / sizeof(double) + 1};
+  vlrx::mmap_heap_array<double> big(big_size);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(big.data()) %
+              vlrx::huge_page_size ==
+          0);
+  REQUIRE(big[big_size - 1] == 0.0);
+  big[big_size - 1] = 1.0;
+  const vlrx::mmap_heap_array<double, std::uint64_t,
+                              vlrx::huge_pages::explicit_pool>
+      explicit_pool(big_size, 2.0);
+  REQUIRE(explicit_pool[big_size / 2] == 2.0);
+  const vlrx::mmap_heap_array<double, std::uint64_t, vlrx::huge_pages::none>
+      copy(big.begin(), big.end());
+  REQUIRE(copy[big_size - 1] == 1.0);
+  const vlrx::heap_array<std::uint8_t, std::uint64_t,
+                         vlrx::mmap_allocator<std::uint8_t>,
+                         vlrx::compact_layout<>>
+      compact(vlrx::huge_page_size, std::uint8_t{3});
+  REQUIRE(compact.size() == vlrx::huge_page_size);
+  REQUIRE(compact.back() == 3);
+}
+
+struct relocatable_handle {
+  relocatable_handle() = default;
+  explicit relocatable_handle(int value)
+      : value_{std::make_unique<int>(value)} {}
+  std::unique_ptr<int> value_;
+};
+
+template <>
+struct vlrx::is_trivially_relocatable<relocatable_handle> : std::true_type {};
+
+TEST_CASE("Reallocate keeps elements and value-initializes added ones",
+          "[reallocate][relocation]") {
+  vlrx::heap_array<int> ints{1, 2, 3};
+  ints.reallocate(1000);
+  REQUIRE(ints.size() == 1000);
+  REQUIRE(ints[2] == 3);
+  REQUIRE(ints[999] == 0);
+  ints.reallocate(2);
+  REQUIRE(ints == vlrx::heap_array<int>{1, 2});
+  REQUIRE_FALSE(ints.reallocate(2));
+  ints.reallocate(0);
+  REQUIRE(ints.empty());
+  REQUIRE(ints.reallocate(3));
+  REQUIRE(ints == vlrx::heap_array<int>{0, 0, 0});
+  ints.reallocate(5, vlrx::for_overwrite);
+  REQUIRE(ints.size() == 5);
+
+  vlrx::compact_heap_array<double> compact{1.0, 2.0};
+  compact.reallocate(4);
+  REQUIRE(compact == vlrx::compact_heap_array<double>{1.0, 2.0, 0.0, 0.0});
+  vlrx::aligned_heap_array<float> aligned(20, 1.0f);
+  aligned.reallocate(3);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(aligned.data()) % 64 == 0);
+  REQUIRE(aligned.padded_size() == 16);
+  REQUIRE(aligned.data()[3] == 0.0f);
+  REQUIRE(aligned.data()[15] == 0.0f);
+
+  vlrx::heap_array<std::string> strings{"a", "b", "c"};
+  REQUIRE(strings.reallocate(4));
+  REQUIRE(strings == vlrx::heap_array<std::string>{"a", "b", "c", ""});
+  strings.reallocate(1);
+  REQUIRE(strings == vlrx::heap_array<std::string>{"a"});
+
+  move_only_struct::moves = 0;
+  vlrx::heap_array<move_only_struct> move_only(
+      3, vlrx::from_generator, [](const std::uint64_t idx) {
+        return move_only_struct{static_cast<int>(idx)};
+      });
+  move_only.reallocate(2);
+  REQUIRE(move_only[1].value_ == 1);
+  REQUIRE(move_only_struct::moves == 2);
+  REQUIRE_THROWS_AS(move_only.reallocate(3), std::length_error);
+  REQUIRE(move_only.size() == 2);
+
+  vlrx::heap_array<relocatable_handle> handles(
+      2, vlrx::from_generator, [](const std::uint64_t idx) {
+        return relocatable_handle{static_cast<int>(idx)};
+      });
+  handles.reallocate(3, vlrx::for_overwrite);
+  handles[2].value_ = std::make_unique<int>(2);
+  handles.reallocate(1);
+  REQUIRE(*handles[0].value_ == 0);
+}
+
+template <typename Array> constexpr bool is_nothrow_movable() {
+  return std::is_nothrow_move_constructible_v<Array> &&
+         std::is_nothrow_move_assignable_v<Array> &&
+         std::is_nothrow_swappable_v<Array>;
+}
+
+// a moved-from array is empty and may be assigned, swapped and destroyed
+template <typename Array> void check_moved_from(Array &&source) {
+  const Array expected{source};
+  Array moved_to{std::move(source)};
+  REQUIRE(moved_to == expected);
+  REQUIRE(source.empty());
+  REQUIRE(source.size() == 0);
+  REQUIRE(source.data() == nullptr);
+  REQUIRE(source.begin() == source.end());
+  REQUIRE(source == Array{});
+  Array assigned{expected};
+  assigned = std::move(moved_to);
+  REQUIRE(assigned == expected);
+  REQUIRE(moved_to.empty());
+  moved_to = std::move(source);
+  REQUIRE(moved_to.empty());
+  swap(source, assigned);
+  REQUIRE(source == expected);
+  REQUIRE(assigned.empty());
+  assigned = source;
+  REQUIRE(assigned == expected);
+}
+
+TEST_CASE("Moves and swaps do not throw and leave empty arrays behind",
+          "[move][swap][noexcept]") {
+  static_assert(is_nothrow_movable<vlrx::heap_array<int>>());
+  static_assert(is_nothrow_movable<vlrx::heap_array<std::string>>());
+  static_assert(is_nothrow_movable<vlrx::compact_heap_array<int>>());
+  static_assert(is_nothrow_movable<vlrx::aligned_heap_array<float>>());
+  using counted_array =
+      vlrx::heap_array<int, std::uint64_t, counting_allocator<int>>;
+  static_assert(is_nothrow_movable<counted_array>());
+  static_assert(is_nothrow_movable<vlrx::small_heap_array<int, 4>>());
+  static_assert(is_nothrow_movable<vlrx::heap_mdarray<int, 2>>());
+  static_assert(is_nothrow_movable<vlrx::shared_heap_array<int>>());
+  static_assert(is_nothrow_movable<vlrx::packed_heap_array<3>>());
+  // elements are moved one by one between unequal memory resources
+  static_assert(
+      std::is_nothrow_move_constructible_v<vlrx::pmr::heap_array<int>>);
+  static_assert(
+      !std::is_nothrow_move_assignable_v<vlrx::pmr::heap_array<int>>);
+
+  check_moved_from(vlrx::heap_array<std::string>{"a", "b", "c"});
+  check_moved_from(vlrx::compact_heap_array<int>{1, 2, 3});
+  check_moved_from(vlrx::aligned_heap_array<double>{1.0, 2.0});
+  std::int64_t live_allocations{};
+  {
+    const counting_allocator<int> alloc{&live_allocations};
+    counted_array source({4, 5}, alloc);
+    counted_array moved_to{std::move(source)};
+    REQUIRE(source.data() == nullptr);
+    source = counted_array({6}, alloc);
+    source = std::move(moved_to);
+    REQUIRE(source == counted_array({4, 5}, alloc));
+    REQUIRE(moved_to.empty());
+    REQUIRE(live_allocations == 1);
+  }
+  REQUIRE(live_allocations == 0);
+
+  // growing vectors move arrays instead of copying them
+  vlrx::instrumentation::reset();
+  std::vector<vlrx::heap_array<int>> arrays;
+  for (int idx{}; idx < 100; ++idx) {
+    arrays.emplace_back(vlrx::heap_array<int>{idx, idx});
+  }
+  REQUIRE(vlrx::instrumentation::snapshot().copy_constructions == 0);
+  REQUIRE(arrays[99] == vlrx::heap_array<int>{99, 99});
+}
+
+TEST_CASE("Arrays are trivially relocatable and relocated in bulk",
+          "[relocation]") {
+  static_assert(vlrx::is_trivially_relocatable_v<vlrx::heap_array<int>>);
+  static_assert(
+      vlrx::is_trivially_relocatable_v<vlrx::heap_array<std::string>>);
+  static_assert(
+      vlrx::is_trivially_relocatable_v<vlrx::compact_heap_array<int>>);
+  static_assert(vlrx::is_trivially_relocatable_v<vlrx::heap_mdarray<int, 3>>);
+  static_assert(
+      vlrx::is_trivially_relocatable_v<vlrx::shared_heap_array<int>>);
+  static_assert(vlrx::is_trivially_relocatable_v<vlrx::bit_heap_array<>>);
+  // inline elements would be left behind
+  static_assert(
+      !vlrx::is_trivially_relocatable_v<vlrx::small_heap_array<int, 4>>);
+
+  using string_array = vlrx::heap_array<std::string>;
+  std::allocator<string_array> alloc;
+  auto *source = alloc.allocate(3);
+  auto *dest = alloc.allocate(3);
+  for (std::size_t idx{}; idx < 3; ++idx) {
+    new (source + idx) string_array(idx + 1, std::to_string(idx));
+  }
+  vlrx::instrumentation::reset();
+  REQUIRE(vlrx::uninitialized_relocate_n(source, 3, dest) == dest + 3);
+  REQUIRE(vlrx::instrumentation::snapshot().moves == 0);
+  REQUIRE(dest[2] == string_array(3, "2"));
+  std::destroy_n(dest, 3);
+  REQUIRE(vlrx::uninitialized_relocate_n(source, 0, dest) == dest);
+
+  std::allocator<std::string> string_alloc;
+  auto *strings = string_alloc.allocate(2);
+  auto *relocated = string_alloc.allocate(2);
+  new (strings) std::string(100, 'a');
+  new (strings + 1) std::string("b");
+  vlrx::uninitialized_relocate_n(strings, 2, relocated);
+  REQUIRE(relocated[0] == std::string(100, 'a'));
+  REQUIRE(relocated[1] == "b");
+  std::destroy_n(relocated, 2);
+  string_alloc.deallocate(relocated, 2);
+  string_alloc.deallocate(strings, 2);
+  alloc.deallocate(dest, 3);
+  alloc.deallocate(source, 3);
+
+  // nested arrays are moved bitwise when the outer one is reallocated
+  vlrx::heap_array<vlrx::heap_array<int>> nested(
+      2, vlrx::from_generator, [](const std::uint64_t idx) {
+        return vlrx::heap_array<int>(idx + 1, static_cast<int>(idx));
+      });
+  vlrx::instrumentation::reset();
+  nested.reallocate(1000);
+  REQUIRE(vlrx::instrumentation::snapshot().moves == 0);
+  REQUIRE(nested[1] == vlrx::heap_array<int>{1, 1});
+  REQUIRE(nested[999].empty());
+}
+
+TEST_CASE("Reallocate resizes mapped buffers without copying",
+          "[reallocate][mmap][instrumentation]") {
+  constexpr std::uint64_t big_size{vlrx::huge_page_size / sizeof(double) * 2};
+  vlrx::mmap_heap_array<double> big(big_size, 1.0);
+  vlrx::instrumentation::reset();
+  big.reallocate(big_size * 4);
+  REQUIRE(big[big_size - 1] == 1.0);
+  REQUIRE(big[big_size] == 0.0);
+  REQUIRE(big.back() == 0.0);
+  big.reallocate(big_size / 2);
+  REQUIRE(big.back() == 1.0);
+  if constexpr (vlrx::instrumentation::enabled) {
+    const auto counters = vlrx::instrumentation::snapshot();
+    REQUIRE(counters.allocations == 2);
+    REQUIRE(counters.copy_constructions == 0);
+  }
+  // a block which can not grow in place stays huge page aligned
+  const auto end = reinterpret_cast<std::uintptr_t>(big.data()) +
+                   big.size() * sizeof(double);
+  void *blocker = ::mmap(reinterpret_cast<void *>(end), vlrx::huge_page_size,
+                         PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                         -1, 0);
+  REQUIRE(blocker == reinterpret_cast<void *>(end));
+  const auto *before = big.data();
+  big.reallocate(big_size * 8);
+  REQUIRE(big.data() != before);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(big.data()) %
+              vlrx::huge_page_size ==
+          0);
+  REQUIRE(big[big_size / 2 - 1] == 1.0);
+  ::munmap(blocker, vlrx::huge_page_size);
+  // buffers crossing the mapping threshold are copied
+  big.reallocate(3);
+  REQUIRE(big == vlrx::mmap_heap_array<double>{1.0, 1.0, 1.0});
+}
+
+TEST_CASE("Saved heap array is mapped from file without copying",
+          "[file][mmap][view]") {
+  const auto path =
+      (std::filesystem::temp_directory_path() / "vlrx_heap_array_test.bin")
+          .string();
+  const vlrx::heap_array<pod_struct> test_array(
+      1000, vlrx::from_generator, [](const std::uint64_t idx) {
+        return pod_struct{static_cast<int>(idx), 0.5 * idx, "pod"};
+      });
+  vlrx::save_to_file(test_array, path);
+  {
+    const vlrx::mapped_array_view<pod_struct> view{path};
+    REQUIRE(view.size() == 1000);
+    REQUIRE(view.verify_checksum());
+    REQUIRE(view[999].int_field == 999);
+    REQUIRE(view.at(10).double_field == 5.0);
+    REQUIRE_THROWS(view.at(1000));
+    REQUIRE(reinterpret_cast<std::uintptr_t>(view.data()) %
+                alignof(pod_struct) ==
+            0);
+    REQUIRE(std::distance(view.begin(), view.end()) == 1000);
+    REQUIRE(view.rbegin()->int_field == 999);
+    REQUIRE_THROWS(vlrx::mapped_array_view<double>{path});
+    vlrx::mapped_array_view<pod_struct> moved_to{};
+    moved_to = vlrx::mapped_array_view<pod_struct>{path};
+    REQUIRE(moved_to.back().int_field == 999);
+    // the file is replaced, not overwritten under the open views
+    vlrx::save_to_file(vlrx::heap_array<pod_struct>(3), path);
+    REQUIRE(view[999].int_field == 999);
+    REQUIRE(view.verify_checksum());
+    REQUIRE(vlrx::mapped_array_view<pod_struct>{path}.size() == 3);
+    REQUIRE(!std::filesystem::exists(path + ".tmp"));
+  }
+  vlrx::save_to_file(vlrx::heap_array<std::uint64_t>{}, path);
+  {
+    const vlrx::mapped_array_view<std::uint64_t> view{path};
+    REQUIRE(view.empty());
+    REQUIRE(view.verify_checksum());
+  }
+  std::filesystem::remove(path);
+  REQUIRE_THROWS(vlrx::mapped_array_view<std::uint64_t>{path});
+}
+
+struct string_codec {
+  void encode(const std::string &value, std::string &out) const {
+    out += value;
+  }
+
+  std::string decode(const char *data, const std::size_t size) const {
+    return std::string{data, size};
+  }
+};
+
+TEST_CASE("Trivially copyable arrays are streamed in chunks",
+          "[stream][serialization]") {
+  const vlrx::heap_array<std::uint64_t> test_array(
+      1000, vlrx::from_generator,
+      [](const std::uint64_t idx) { return idx * idx; });
+  std::stringstream stream;
+  vlrx::write_to(stream, test_array, 64);
+  const auto read =
+      vlrx::read_from<vlrx::heap_array<std::uint64_t>>(stream, 100);
+  REQUIRE(read == test_array);
+  std::stringstream empty_stream;
+  vlrx::write_to(empty_stream, vlrx::heap_array<int>{});
+  REQUIRE(vlrx::read_from<vlrx::heap_array<int>>(empty_stream).empty());
+  std::stringstream wrong_type;
+  vlrx::write_to(wrong_type, test_array);
+  REQUIRE_THROWS(vlrx::read_from<vlrx::heap_array<std::uint32_t>>(wrong_type));
+  std::stringstream truncated{stream.str().substr(0, 100)};
+  REQUIRE_THROWS(vlrx::read_from<vlrx::heap_array<std::uint64_t>>(truncated));
+}
+
+TEST_CASE("Non-trivial arrays are streamed with codec",
+          "[stream][serialization][codec]") {
+  const vlrx::heap_array<std::string> test_array(
+      500, vlrx::from_generator, [](const std::uint64_t idx) {
+        return std::string(idx % 37, static_cast<char>('a' + idx % 26));
+      });
+  std::stringstream stream;
+  vlrx::write_to(stream, test_array, string_codec{}, 128);
+  const auto read = vlrx::read_from<vlrx::heap_array<std::string>>(
+      stream, string_codec{}, 100);
+  REQUIRE(read == test_array);
+  std::stringstream truncated{stream.str().substr(0, 1000)};
+  REQUIRE_THROWS(vlrx::read_from<vlrx::heap_array<std::string>>(
+      truncated, string_codec{}, 100));
+
+  // a corrupt count is not allocated up front
+  auto corrupt = stream.str();
+  const std::uint64_t count{std::uint64_t{1} << 40};
+  std::memcpy(corrupt.data() + offsetof(vlrx::detail::stream_header, count),
+              &count, sizeof(count));
+  std::stringstream corrupt_stream{corrupt};
+  REQUIRE_THROWS_AS(vlrx::read_from<vlrx::heap_array<std::string>>(
+                        corrupt_stream, string_codec{}, 100),
+                    std::runtime_error);
+}
+
+struct watching_codec : string_codec {
+  void encode(const std::string &value, std::string &out) {
+    written.push_back(static_cast<std::int64_t>(stream->tellp()));
+    string_codec::encode(value, out);
+  }
+
+  std::stringstream *stream;
+  std::vector<std::int64_t> written;
+};
+
+TEST_CASE("Codec writes chunks while encoding",
+          "[stream][serialization][codec]") {
+  const vlrx::heap_array<std::string> test_array(100, std::string(10, 'x'));
+  std::stringstream stream;
+  watching_codec codec{{}, &stream, {}};
+  vlrx::write_to(stream, test_array, codec, 64);
+  REQUIRE(codec.written.back() >
+          static_cast<std::int64_t>(sizeof(vlrx::detail::stream_header)) +
+              64);
+  REQUIRE(vlrx::read_from<vlrx::heap_array<std::string>>(
+              stream, string_codec{}, 32) == test_array);
+}
+
+TEST_CASE("Reading stops at the end of the array in the stream",
+          "[stream][serialization][codec]") {
+  const vlrx::heap_array<std::string> first{"a", "bc", "def"};
+  const vlrx::heap_array<std::string> second(
+      300, vlrx::from_generator,
+      [](const std::uint64_t idx) { return std::to_string(idx); });
+  const vlrx::heap_array<std::uint32_t> numbers{1, 2, 3};
+  std::stringstream stream;
+  vlrx::write_to(stream, first, string_codec{}, 16);
+  vlrx::write_to(stream, second, string_codec{}, 16);
+  vlrx::write_to(stream, numbers, 4);
+  stream << "tail";
+  REQUIRE(vlrx::read_from<vlrx::heap_array<std::string>>(
+              stream, string_codec{}, 16) == first);
+  REQUIRE(stream.tellg() != -1);
+  REQUIRE(vlrx::read_from<vlrx::heap_array<std::string>>(
+              stream, string_codec{}, 64) == second);
+  REQUIRE(vlrx::read_from<vlrx::heap_array<std::uint32_t>>(stream, 4) ==
+          numbers);
+  std::string tail;
+  stream >> tail;
+  REQUIRE(tail == "tail");
+
+  std::stringstream empty_arrays;
+  vlrx::write_to(empty_arrays, vlrx::heap_array<std::string>{}, string_codec{});
+  vlrx::write_to(empty_arrays, first, string_codec{});
+  REQUIRE(vlrx::read_from<vlrx::heap_array<std::string>>(empty_arrays,
+                                                          string_codec{})
+              .empty());
+  REQUIRE(vlrx::read_from<vlrx::heap_array<std::string>>(
+              empty_arrays, string_codec{}) == first);
+}
+
+TEST_CASE("Parallel policy constructs, copies and destroys in page chunks",
+          "[parallel][construction]") {
+  const vlrx::parallel_policy<> policy{4};
+  constexpr std::uint64_t size{1 << 20};
+  const vlrx::heap_array<std::uint64_t> zeroes(size, policy);
+  REQUIRE(std::all_of(zeroes.begin(), zeroes.end(),
+                      [](const std::uint64_t value) { return value == 0; }));
+  const vlrx::heap_array<int> sevens(size, 7, policy);
+  REQUIRE(std::all_of(sevens.begin(), sevens.end(),
+                      [](const int value) { return value == 7; }));
+  const auto generator = [](const std::uint64_t idx) { return idx * 3; };
+  const vlrx::heap_array<std::uint64_t> generated(size, vlrx::from_generator,
+                                                  generator, policy);
+  REQUIRE(generated ==
+          vlrx::heap_array<std::uint64_t>(size, vlrx::from_generator,
+                                          generator));
+  const vlrx::heap_array<std::uint64_t> copy(generated, policy);
+  REQUIRE(copy == generated);
+
+  vlrx::heap_array<std::string> strings(
+      size / 8, vlrx::from_generator,
+      [](const std::uint64_t idx) { return std::to_string(idx); }, policy);
+  const vlrx::heap_array<std::string> strings_copy(strings, policy);
+  REQUIRE(strings_copy == strings);
+  REQUIRE(strings[12345] == "12345");
+  strings.reset(policy);
+  REQUIRE(strings.empty());
+}
+
+struct counted_struct {
+  explicit counted_struct(const std::uint64_t idx) {
+    if (idx == throw_at) {
+      throw std::runtime_error("Construction failed");
+    }
+    ++live;
+  }
+  counted_struct(const counted_struct &) = delete;
+  ~counted_struct() { --live; }
+  static inline std::atomic<std::int64_t> live{};
+  static inline std::uint64_t throw_at{};
+};
+
+TEST_CASE("Parallel construction destroys all chunks if any of them throws",
+          "[parallel][exceptions]") {
+  constexpr std::uint64_t size{1 << 20};
+  counted_struct::throw_at = size / 3;
+  REQUIRE_THROWS_AS(
+      vlrx::heap_array<counted_struct>(
+          size, vlrx::from_generator,
+          [](const std::uint64_t idx) { return counted_struct{idx}; },
+          vlrx::parallel_policy<>{4, vlrx::numa_placement::interleaved}),
+      std::runtime_error);
+  REQUIRE(counted_struct::live == 0);
+  counted_struct::throw_at = size;
+  {
+    const vlrx::heap_array<counted_struct> test_array(
+        size, vlrx::from_generator,
+        [](const std::uint64_t idx) { return counted_struct{idx}; },
+        vlrx::parallel_policy<>{4, vlrx::numa_placement::bound, 0});
+    REQUIRE(counted_struct::live == size);
+  }
+  REQUIRE(counted_struct::live == 0);
+}
+
+struct serial_executor {
+  explicit serial_executor(unsigned) {}
+  std::size_t concurrency() const noexcept { return 3; }
+  template <typename Task>
+  void bulk(const std::size_t count, Task &&task) const {
+    for (std::size_t idx{}; idx < count; ++idx) {
+      ++tasks;
+      task(idx);
+    }
+  }
+  static inline std::size_t tasks{};
+};
+
+TEST_CASE("Parallel policy runs chunks on custom executor",
+          "[parallel][executor]") {
+  const vlrx::parallel_policy<serial_executor> policy{1};
+  const vlrx::heap_array<double> big(1 << 20, 1.5, policy);
+  REQUIRE(serial_executor::tasks == 3);
+  REQUIRE(std::all_of(big.begin(), big.end(),
+                      [](const double value) { return value == 1.5; }));
+  const vlrx::heap_array<double> small(100, 1.5, policy);
+  REQUIRE(serial_executor::tasks == 3);
+  REQUIRE(small[99] == 1.5);
+}
+
+TEST_CASE("Structure-of-arrays keeps every field in an aligned column",
+          "[soa][construction][column]") {
+  const vlrx::heap_soa_array<int, double, char> zeroes(10);
+  REQUIRE(zeroes.size() == 10);
+  REQUIRE(zeroes[9] == std::tuple<int, double, char>{0, 0.0, '\0'});
+
+  vlrx::heap_soa_array<int, double, char> test_array(
+      100, vlrx::from_generator, [](const std::uint64_t idx) {
+        return std::tuple{static_cast<int>(idx), idx * 0.5,
+                          static_cast<char>('a' + idx % 26)};
+      });
+  const auto ints = test_array.column<0>();
+  const auto doubles = test_array.column<1>();
+  const auto chars = test_array.column<2>();
+  REQUIRE(ints.size() == 100);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(ints.data()) % 64 == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(doubles.data()) % 64 == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(chars.data()) % 64 == 0);
+  REQUIRE(ints[42] == 42);
+  REQUIRE(doubles[42] == 21.0);
+  REQUIRE(chars[27] == 'b');
+  REQUIRE(std::accumulate(ints.begin(), ints.end(), 0) == 4950);
+
+  std::get<1>(test_array[3]) = 7.5;
+  REQUIRE(doubles[3] == 7.5);
+  auto [int_field, double_field, char_field] = *(test_array.begin() + 5);
+  int_field = -5;
+  REQUIRE(test_array.column<0>()[5] == -5);
+  REQUIRE(double_field == 2.5);
+  REQUIRE(char_field == 'f');
+  REQUIRE(test_array.end() - test_array.begin() == 100);
+  REQUIRE_THROWS_AS(test_array.at(100), std::out_of_range);
+
+  const auto copy = test_array;
+  REQUIRE(copy == test_array);
+  auto moved = std::move(test_array);
+  REQUIRE(test_array.empty());
+  REQUIRE(moved == copy);
+  const vlrx::heap_soa_array<int, double, char> filled(3, 1, 2.0, 'c');
+  REQUIRE(std::all_of(filled.begin(), filled.end(), [](const auto &row) {
+    return row == std::tuple<int, double, char>{1, 2.0, 'c'};
+  }));
+}
+
+TEST_CASE("Structure-of-arrays destroys fields if construction throws",
+          "[soa][exceptions]") {
+  std::uint16_t destroyed{};
+  REQUIRE_THROWS_AS(
+      (vlrx::heap_soa_array<mock_struct, std::string>(
+          10, vlrx::from_generator,
+          [&](const std::uint64_t idx) {
+            if (idx == 5) {
+              throw std::runtime_error("Construction failed");
+            }
+            return std::tuple{mock_struct{nullptr}, std::to_string(idx)};
+          })),
+      std::runtime_error);
+  {
+    const vlrx::heap_soa_array<mock_struct, std::string> test_array(
+        4, mock_struct{&destroyed}, std::string(100, 'x'));
+    const auto copy = test_array;
+    REQUIRE(std::get<1>(copy[3]) == std::string(100, 'x'));
+    destroyed = 0;
+  }
+  REQUIRE(destroyed == 8);
+}
+
+TEST_CASE("Extents mix static and dynamic dimensions", "[mdarray][extents]") {
+  constexpr vlrx::extents<std::uint32_t, 3, vlrx::dynamic_extent, 4> ext{5};
+  static_assert(ext.rank() == 3 && ext.rank_dynamic() == 1);
+  static_assert(ext.extent(0) == 3 && ext.extent(1) == 5 &&
+                ext.extent(2) == 4);
+  static_assert(ext == vlrx::extents<std::uint32_t, 3, vlrx::dynamic_extent,
+                                     4>{3, 5, 4});
+  REQUIRE(ext.size() == 60);
+  const vlrx::dextents<std::uint64_t, 2> dynamic{7, 9};
+  REQUIRE(dynamic.extent(1) == 9);
+}
+
+TEST_CASE("Multidimensional array supports row-major and column-major layouts",
+          "[mdarray][layout]") {
+  vlrx::heap_mdarray<int, 3> row_major(2, 3, 4);
+  vlrx::heap_mdarray<int, 3, vlrx::layout_left> column_major(2, 3, 4);
+  REQUIRE(row_major.size() == 24);
+  for (std::uint64_t i{}; i < 2; ++i) {
+    for (std::uint64_t j{}; j < 3; ++j) {
+      for (std::uint64_t k{}; k < 4; ++k) {
+        row_major(i, j, k) = static_cast<int>(i * 100 + j * 10 + k);
+        column_major(i, j, k) = static_cast<int>(i * 100 + j * 10 + k);
+      }
+    }
+  }
+  REQUIRE(row_major.data()[1] == 1);
+  REQUIRE(row_major.data()[4] == 10);
+  REQUIRE(column_major.data()[1] == 100);
+  REQUIRE(column_major.data()[2] == 10);
+  REQUIRE(row_major.mapping().stride(0) == 12);
+  REQUIRE(column_major.mapping().stride(2) == 6);
+  REQUIRE(row_major[{1, 2, 3}] == 123);
+  REQUIRE_THROWS_AS(row_major.at(0, 3, 0), std::out_of_range);
+
+  std::vector<int> visited;
+  column_major.for_each_index(
+      [&](const std::uint64_t i, const std::uint64_t j, const std::uint64_t k) {
+        visited.push_back(column_major(i, j, k));
+      });
+  REQUIRE(std::equal(visited.begin(), visited.end(),
+                     column_major.data()));
+
+  const auto copy = row_major;
+  REQUIRE(copy == row_major);
+  const vlrx::heap_mdarray<double, 2> filled(
+      vlrx::dextents<std::uint64_t, 2>{3, 3}, 1.5);
+  REQUIRE(filled(2, 2) == 1.5);
+}
+
+TEST_CASE("Default multidimensional arrays hold their static extents",
+          "[mdarray][construction]") {
+  vlrx::basic_heap_mdarray<float, vlrx::extents<std::uint64_t, 3, 3>> square;
+  REQUIRE(square.size() == 9);
+  REQUIRE(square.mapping().stride(0) == 3);
+  REQUIRE(square(2, 2) == 0.0f);
+  square.at(1, 1) = 1.0f;
+  REQUIRE(square.data()[4] == 1.0f);
+  REQUIRE_THROWS_AS(square.at(3, 0), std::out_of_range);
+
+  vlrx::basic_heap_mdarray<int, vlrx::extents<std::uint32_t, 2, 4>,
+                           vlrx::layout_left>
+      column_major;
+  column_major(1, 3) = 7;
+  REQUIRE(column_major.data()[7] == 7);
+  vlrx::basic_heap_mdarray<int, vlrx::extents<std::uint32_t, 5, 6>,
+                           vlrx::layout_tiled<4>>
+      tiled;
+  tiled.at(4, 5) = 3;
+  REQUIRE(tiled(4, 5) == 3);
+  const vlrx::layout_stride::mapping<vlrx::extents<std::uint32_t, 2, 3>>
+      strided;
+  REQUIRE(strided(1, 2) == 5);
+
+  const vlrx::heap_mdarray<int, 2> dynamic;
+  REQUIRE(dynamic.empty());
+  REQUIRE_THROWS_AS(dynamic.at(0, 0), std::out_of_range);
+
+  vlrx::basic_heap_mdarray<int, vlrx::extents<std::int32_t, 2, 2>> signed_;
+  REQUIRE_THROWS_AS(signed_.at(-1, 0), std::out_of_range);
+  REQUIRE_THROWS_AS(signed_.at(1, -2), std::out_of_range);
+  signed_.at(1, 1) = 4;
+  REQUIRE(signed_(1, 1) == 4);
+}
+
+TEST_CASE("Sub-views of multidimensional arrays do not copy elements",
+          "[mdarray][view]") {
+  vlrx::heap_mdarray<int, 2> matrix(4, 5);
+  matrix.for_each_index([&](const std::uint64_t i, const std::uint64_t j) {
+    matrix(i, j) = static_cast<int>(i * 10 + j);
+  });
+  const auto sub =
+      matrix.view().subview(std::pair{1, 3}, vlrx::full_extent);
+  REQUIRE(sub.extent(0) == 2);
+  REQUIRE(sub.extent(1) == 5);
+  REQUIRE(sub(0, 0) == 10);
+  REQUIRE(sub(1, 4) == 24);
+  const auto inner = sub.subview(vlrx::full_extent, std::pair{2, 4});
+  REQUIRE(inner(1, 1) == 23);
+  REQUIRE(inner.stride(0) == 5);
+  REQUIRE(!inner.mapping().is_exhaustive());
+  inner(0, 0) = -1;
+  REQUIRE(matrix(1, 2) == -1);
+  const auto &const_matrix = matrix;
+  REQUIRE(const_matrix.view()(1, 2) == -1);
+}
+
+TEST_CASE("Tiled layout keeps tiles contiguous", "[mdarray][layout][tiled]") {
+  vlrx::heap_mdarray<int, 2, vlrx::layout_tiled<4>> matrix(6, 10);
+  REQUIRE(matrix.mapping().required_span_size() == 8 * 12);
+  REQUIRE(matrix.container().size() == 96);
+  REQUIRE(!matrix.mapping().is_exhaustive());
+  matrix.for_each_index([&](const std::uint64_t i, const std::uint64_t j) {
+    matrix(i, j) = static_cast<int>(i * 100 + j);
+  });
+  REQUIRE(matrix.data()[0] == 0);
+  REQUIRE(matrix.data()[3] == 3);
+  REQUIRE(matrix.data()[4] == 100);
+  REQUIRE(matrix.data()[16] == 4);
+  REQUIRE(matrix(5, 9) == 509);
+  std::vector<std::uint64_t> offsets;
+  matrix.for_each_index([&](const std::uint64_t i, const std::uint64_t j) {
+    offsets.push_back(matrix.mapping()(i, j));
+  });
+  REQUIRE(offsets.size() == 60);
+  REQUIRE(std::is_sorted(offsets.begin(), offsets.end()));
+}
+
+namespace {
+
+struct tagged_event {
+  vlrx::instrumentation::event kind;
+  std::size_t bytes;
+  std::string tag;
+};
+
+std::vector<tagged_event> &recorded_events() {
+  static std::vector<tagged_event> events;
+  return events;
+}
+
+void record_event(const vlrx::instrumentation::event kind,
+                  const std::size_t bytes, const char *tag) {
+  recorded_events().push_back({kind, bytes, tag != nullptr ? tag : ""});
+}
+
+} // namespace
+
+TEST_CASE("Instrumentation counts allocations, copies and moves",
+          "[instrumentation]") {
+  REQUIRE(vlrx::instrumentation::enabled);
+  vlrx::instrumentation::reset();
+  {
+    vlrx::heap_array<std::uint32_t> first(10);
+    auto copy = first;
+    vlrx::heap_array<std::uint32_t> same_size(10);
+    same_size = first;
+    vlrx::heap_array<std::uint32_t> other_size(3);
+    other_size = first;
+    auto moved = std::move(copy);
+    const auto counters = vlrx::instrumentation::snapshot();
+    REQUIRE(counters.allocations == 5);
+    REQUIRE(counters.deallocations == 1);
+    REQUIRE(counters.live_bytes == 4 * 40);
+    REQUIRE(counters.copy_constructions == 1);
+    REQUIRE(counters.reusing_copy_assignments == 1);
+    REQUIRE(counters.reallocating_copy_assignments == 1);
+    REQUIRE(counters.moves == 1);
+  }
+  auto counters = vlrx::instrumentation::snapshot();
+  REQUIRE(counters.deallocations == 5);
+  REQUIRE(counters.live_bytes == 0);
+
+  // copying with a propagated allocator is a single reallocating assignment
+  std::int64_t allocations{};
+  std::int64_t allocations1{};
+  using array_type =
+      vlrx::heap_array<std::uint32_t, std::uint64_t,
+                       counting_allocator<std::uint32_t>>;
+  const array_type source(10, counting_allocator<std::uint32_t>{&allocations});
+  array_type target(10, counting_allocator<std::uint32_t>{&allocations1});
+  vlrx::instrumentation::reset();
+  target = source;
+  counters = vlrx::instrumentation::snapshot();
+  REQUIRE(counters.copy_constructions == 0);
+  REQUIRE(counters.reusing_copy_assignments == 0);
+  REQUIRE(counters.reallocating_copy_assignments == 1);
+  REQUIRE(allocations1 == 0);
+}
+
+TEST_CASE("Instrumentation observer sees tags of the calling thread",
+          "[instrumentation]") {
+  recorded_events().clear();
+  vlrx::instrumentation::set_observer(record_event);
+  {
+    const vlrx::instrumentation::scoped_tag outer{"parser"};
+    vlrx::heap_array<std::uint64_t> array(4);
+    {
+      const vlrx::instrumentation::scoped_tag inner{"cache"};
+      REQUIRE(std::string{vlrx::instrumentation::current_tag()} == "cache");
+      const auto copy = array;
+    }
+    REQUIRE(std::string{vlrx::instrumentation::current_tag()} == "parser");
+  }
+  vlrx::instrumentation::set_observer(nullptr);
+  REQUIRE(vlrx::instrumentation::current_tag() == nullptr);
+  vlrx::heap_array<std::uint64_t> unobserved(4);
+  using vlrx::instrumentation::event;
+  const auto &events = recorded_events();
+  REQUIRE(events.size() == 5);
+  REQUIRE(events[0].kind == event::allocation);
+  REQUIRE(events[0].bytes == 32);
+  REQUIRE(events[0].tag == "parser");
+  REQUIRE(events[1].kind == event::allocation);
+  REQUIRE(events[1].tag == "cache");
+  REQUIRE(events[2].kind == event::copy_construction);
+  REQUIRE(events[2].bytes == 32);
+  REQUIRE(events[3].kind == event::deallocation);
+  REQUIRE(events[3].tag == "cache");
+  REQUIRE(events[4].kind == event::deallocation);
+  REQUIRE(events[4].tag == "parser");
+}
+
+TEST_CASE("Shared heap array shares the buffer until it is modified",
+          "[shared_heap_array][copy]") {
+  static_assert(sizeof(vlrx::shared_heap_array<int>) == sizeof(void *));
+  vlrx::shared_heap_array<std::string> empty;
+  REQUIRE(empty.empty());
+  REQUIRE(empty.use_count() == 0);
+  vlrx::shared_heap_array<std::string> original{"a", "b", "c"};
+  REQUIRE(original.use_count() == 1);
+  const auto snapshot = original;
+  REQUIRE(original.use_count() == 2);
+  REQUIRE(snapshot.data() == std::as_const(original).data());
+  REQUIRE(snapshot == original);
+  original[1] = "x";
+  REQUIRE(original.use_count() == 1);
+  REQUIRE(snapshot.use_count() == 1);
+  REQUIRE(snapshot[1] == "b");
+  REQUIRE(original[1] == "x");
+  REQUIRE(snapshot < original);
+  auto moved = std::move(original);
+  REQUIRE(original.empty());
+  REQUIRE(moved.size() == 3);
+  moved = snapshot;
+  REQUIRE(moved.use_count() == 2);
+  REQUIRE(std::equal(moved.cbegin(), moved.cend(), snapshot.begin()));
+  const vlrx::shared_heap_array<std::uint32_t> zeroes(100);
+  REQUIRE(std::all_of(zeroes.begin(), zeroes.end(),
+                      [](const std::uint32_t value) { return value == 0; }));
+  const vlrx::shared_heap_array<std::uint64_t> squares(
+      4, vlrx::from_generator,
+      [](const std::uint64_t idx) { return idx * idx; });
+  REQUIRE(squares.back() == 9);
+}
+
+TEST_CASE("Shared heap array converts from and to heap array",
+          "[shared_heap_array][heap_array]") {
+  vlrx::heap_array<std::string> array{"one", "two"};
+  const vlrx::shared_heap_array<std::string> copied{array};
+  REQUIRE(array.size() == 2);
+  const vlrx::shared_heap_array<std::string> moved{std::move(array)};
+  REQUIRE(array.empty());
+  REQUIRE(moved == copied);
+  auto shared = moved;
+  auto copy = std::move(shared).to_heap_array();
+  REQUIRE(shared.empty());
+  REQUIRE(moved.use_count() == 1);
+  REQUIRE(copy == (vlrx::heap_array<std::string>{"one", "two"}));
+  auto unique = moved;
+  auto unique_copy = moved.to_heap_array();
+  REQUIRE(unique_copy.size() == 2);
+  unique = vlrx::shared_heap_array<std::string>{"three"};
+  const auto taken = std::move(unique).to_heap_array();
+  REQUIRE(taken[0] == "three");
+  vlrx::shared_heap_array<int> ints{1, 2, 3};
+  REQUIRE(ints.to_heap_array() == (vlrx::heap_array<int>{1, 2, 3}));
+}
+
+TEST_CASE("Shared heap array snapshots do not see later writes",
+          "[shared_heap_array][copy]") {
+  vlrx::shared_heap_array<int> original{1, 2, 3};
+  auto &first = original[0];
+  auto *elements = original.data();
+  const auto snapshot = original;
+  REQUIRE(snapshot.data() != std::as_const(original).data());
+  first = 42;
+  elements[1] = 43;
+  REQUIRE(snapshot == (vlrx::shared_heap_array<int>{1, 2, 3}));
+  REQUIRE(original == (vlrx::shared_heap_array<int>{42, 43, 3}));
+  REQUIRE(original.use_count() == 1);
+  vlrx::shared_heap_array<int> assigned;
+  assigned = original;
+  REQUIRE(assigned.data() != elements);
+  original.back() = 44;
+  REQUIRE(assigned[2] == 3);
+
+  // buffers which were only read stay shared
+  const auto second = snapshot;
+  REQUIRE(snapshot.use_count() == 2);
+  REQUIRE(second.data() == snapshot.data());
+  auto moved = std::move(original);
+  REQUIRE(moved.data() == elements);
+  const auto copy_of_moved = moved;
+  REQUIRE(copy_of_moved.data() != elements);
+
+  // a table filled through operator[] is shared again after share()
+  vlrx::shared_heap_array<std::uint64_t> table(100);
+  for (std::uint64_t idx{}; idx < table.size(); ++idx) {
+    table[idx] = idx * 3;
+  }
+  table.share();
+  const auto table_snapshot = table;
+  REQUIRE(table_snapshot.data() == std::as_const(table).data());
+  REQUIRE(table.use_count() == 2);
+  table.share();
+  REQUIRE(table.use_count() == 2);
+  table[0] = 1;
+  REQUIRE(table_snapshot[0] == 0);
+}
+
+struct counted_move_struct {
+  explicit counted_move_struct(int value) : value_{value} {}
+  counted_move_struct(const counted_move_struct &) = default;
+  counted_move_struct(counted_move_struct &&other) noexcept
+      : value_{other.value_} {
+    ++moves;
+  }
+  int value_;
+  static inline int moves{};
+};
+
+TEST_CASE("Shared heap array moves elements out of unique buffers",
+          "[shared_heap_array][heap_array]") {
+  static_assert(std::is_trivially_copy_constructible_v<counted_move_struct>);
+  vlrx::shared_heap_array<counted_move_struct> unique(
+      3, vlrx::from_generator,
+      [](const std::uint64_t idx) {
+        return counted_move_struct{static_cast<int>(idx)};
+      });
+  auto shared = unique;
+  counted_move_struct::moves = 0;
+  const auto copied = std::move(shared).to_heap_array();
+  REQUIRE(counted_move_struct::moves == 0);
+  REQUIRE(unique.use_count() == 1);
+  const auto moved = std::move(unique).to_heap_array();
+  REQUIRE(counted_move_struct::moves == 3);
+  REQUIRE(unique.empty());
+  REQUIRE(moved[2].value_ == 2);
+  REQUIRE(copied[2].value_ == 2);
+}
+
+template <typename T>
+struct non_propagating_allocator : counting_allocator<T> {
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+
+  using counting_allocator<T>::counting_allocator;
+};
+
+TEST_CASE("Shared heap array follows allocator propagation",
+          "[shared_heap_array][allocator]") {
+  std::int64_t ours{};
+  std::int64_t theirs{};
+  {
+    using array_type = vlrx::shared_heap_array<int, std::uint64_t,
+                                               counting_allocator<int>>;
+    const array_type source{{1, 2, 3}, counting_allocator<int>{&theirs}};
+    array_type target{{4}, counting_allocator<int>{&ours}};
+    target = source; // propagates allocator, so the buffer is shared
+    REQUIRE(ours == 0);
+    REQUIRE(std::as_const(target).data() == source.data());
+    REQUIRE(target.get_allocator() == source.get_allocator());
+  }
+  REQUIRE(theirs == 0);
+  {
+    using array_type = vlrx::shared_heap_array<int, std::uint64_t,
+                                               non_propagating_allocator<int>>;
+    array_type source{{1, 2, 3}, non_propagating_allocator<int>{&theirs}};
+    array_type target{{4}, non_propagating_allocator<int>{&ours}};
+    target = source; // keeps allocator, so the elements are copied
+    REQUIRE(ours == 1);
+    REQUIRE(std::as_const(target).data() != std::as_const(source).data());
+    REQUIRE(target == source);
+    REQUIRE(source.use_count() == 1);
+    array_type moved_to{{5}, non_propagating_allocator<int>{&ours}};
+    moved_to = std::move(source);
+    REQUIRE(ours == 2);
+    REQUIRE(theirs == 1);
+    REQUIRE(moved_to == target);
+    REQUIRE(moved_to.get_allocator() ==
+            non_propagating_allocator<int>{&ours});
+    swap(moved_to, target);
+    REQUIRE(target.get_allocator() == non_propagating_allocator<int>{&ours});
+  }
+  REQUIRE(ours == 0);
+  REQUIRE(theirs == 0);
+}
+
+TEST_CASE("Shared heap array snapshots are taken concurrently",
+          "[shared_heap_array][threads]") {
+  const vlrx::shared_heap_array<std::uint64_t> table(
+      1000, vlrx::from_generator, [](const std::uint64_t idx) { return idx; });
+  std::vector<std::thread> readers;
+  std::atomic<std::uint64_t> total{};
+  for (int reader{}; reader < 4; ++reader) {
+    readers.emplace_back([&] {
+      std::uint64_t sum{};
+      for (std::uint64_t idx{}; idx < 1000; ++idx) {
+        auto snapshot = table;
+        if (idx % 100 == 0) {
+          snapshot[idx] = 0;
+        }
+        sum += std::as_const(snapshot)[idx];
+      }
+      total += sum;
+    });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  REQUIRE(total == 4 * (999 * 1000 / 2 - 4500));
+  REQUIRE(table.use_count() == 1);
+}
+
+TEST_CASE("Publisher keeps acquired versions alive until they are released",
+          "[publisher]") {
+  vlrx::heap_array_publisher<int> publisher{vlrx::heap_array<int>{1, 2}, 2};
+  auto reader = publisher.make_reader();
+  {
+    auto other = publisher.make_reader();
+    REQUIRE_THROWS_AS(publisher.make_reader(), std::runtime_error);
+  }
+  auto third = publisher.make_reader();
+  {
+    const auto first = reader.acquire();
+    REQUIRE(*first == (vlrx::heap_array<int>{1, 2}));
+    publisher.publish(vlrx::heap_array<int>{3});
+    REQUIRE(publisher.retired_count() == 1);
+    const auto nested = reader.acquire();
+    REQUIRE(nested->size() == 1);
+    REQUIRE(first.get()[1] == 2);
+    const auto independent = third.acquire();
+    REQUIRE((*independent)[0] == 3);
+  }
+  publisher.reclaim();
+  REQUIRE(publisher.retired_count() == 0);
+  publisher.publish(vlrx::heap_array<int>{4, 5, 6});
+  REQUIRE(publisher.retired_count() == 0);
+  REQUIRE(reader.acquire()->back() == 6);
+}
+
+TEST_CASE("Publisher readers see consistent versions under frequent updates",
+          "[publisher][threads]") {
+  constexpr std::uint64_t versions{2000};
+  constexpr std::uint64_t size{64};
+  const auto version = [&](const std::uint64_t number) {
+    return vlrx::heap_array<std::uint64_t>(
+        size, vlrx::from_generator,
+        [&](const std::uint64_t idx) { return number * size + idx; });
+  };
+  vlrx::heap_array_publisher<std::uint64_t> publisher{version(0)};
+  std::atomic<bool> done{};
+  std::atomic<std::uint64_t> inconsistent{};
+  std::vector<std::thread> readers;
+  for (int idx{}; idx < 3; ++idx) {
+    readers.emplace_back([&] {
+      auto reader = publisher.make_reader();
+      std::uint64_t last_seen{};
+      while (!done.load()) {
+        const auto current = reader.acquire();
+        const auto number = current->front() / size;
+        for (std::uint64_t i{}; i < size; ++i) {
+          if ((*current)[i] != number * size + i) {
+            ++inconsistent;
+          }
+        }
+        if (number < last_seen) {
+          ++inconsistent;
+        }
+        last_seen = number;
+      }
+    });
+  }
+  for (std::uint64_t number{1}; number <= versions; ++number) {
+    publisher.publish(version(number));
+    if (number % 64 == 0) {
+      std::this_thread::yield();
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  REQUIRE(inconsistent == 0);
+  publisher.reclaim();
+  REQUIRE(publisher.retired_count() == 0);
+}
+
+TEST_CASE("Pool allocator recycles buffers of the same size class",
+          "[pool_allocator]") {
+  using array = vlrx::pooled_heap_array<std::uint64_t>;
+  // a fresh thread starts with empty statistics
+  std::vector<vlrx::pool_statistics> statistics;
+  bool recycled{};
+  bool zeroed{};
+  std::thread{[&] {
+    const void *first_data{};
+    {
+      const array first(100, 7);
+      first_data = first.data();
+    }
+    statistics.push_back(vlrx::thread_pool_statistics());
+    {
+      // 97 elements fall into the same size class as 100
+      const array second(97);
+      recycled = second.data() == first_data;
+      zeroed = std::all_of(
+          second.begin(), second.end(),
+          [](const std::uint64_t value) { return value == 0; });
+    }
+    statistics.push_back(vlrx::thread_pool_statistics());
+    {
+      std::vector<array> arrays;
+      arrays.reserve(600);
+      for (int idx{}; idx < 600; ++idx) {
+        arrays.emplace_back(100);
+      }
+    }
+    statistics.push_back(vlrx::thread_pool_statistics());
+    {
+      // buffers above the pooled size are not cached
+      const array big(std::uint64_t{1} << 16);
+    }
+    statistics.push_back(vlrx::thread_pool_statistics());
+    vlrx::trim_thread_pool();
+    statistics.push_back(vlrx::thread_pool_statistics());
+  }}.join();
+  REQUIRE(statistics[0].misses == 1);
+  REQUIRE(statistics[0].cached_bytes == 1024);
+  REQUIRE(recycled);
+  REQUIRE(zeroed);
+  REQUIRE(statistics[1].hits == 1);
+  REQUIRE(statistics[1].misses == 1);
+  REQUIRE(statistics[2].releases == 88);
+  REQUIRE(statistics[2].cached_bytes == 512 * 1024);
+  REQUIRE(statistics[3].misses == statistics[2].misses);
+  REQUIRE(statistics[4].cached_bytes == 0);
+}
+
+TEST_CASE("Pool allocator hands buffers freed elsewhere back to the owner",
+          "[pool_allocator][threads]") {
+  using array = vlrx::pooled_heap_array<std::string>;
+  vlrx::pool_statistics after_remote_free{};
+  vlrx::pool_statistics after_reuse{};
+  bool recycled{};
+  std::thread{[&] {
+    auto owned = std::make_unique<array>(10, "value");
+    const void *data = owned->data();
+    std::thread{[&] { owned.reset(); }}.join();
+    after_remote_free = vlrx::thread_pool_statistics();
+    const array reused(10);
+    recycled = reused.data() == data;
+    after_reuse = vlrx::thread_pool_statistics();
+  }}.join();
+  REQUIRE(after_remote_free.remote_frees == 1);
+  REQUIRE(recycled);
+  REQUIRE(after_reuse.hits == 1);
+  const auto total = vlrx::total_pool_statistics();
+  REQUIRE(total.remote_frees >= 1);
+  REQUIRE(total.cached_bytes == 0);
+}
+
+TEST_CASE("Pool allocator bounds blocks freed by other threads",
+          "[pool_allocator][threads]") {
+  // blocks of the biggest class, two of which are kept per free list
+  using array = vlrx::pooled_heap_array<char>;
+  constexpr std::uint64_t block_size{200000};
+  constexpr std::size_t block_count{20};
+  constexpr auto class_bytes = vlrx::detail::max_pooled_bytes;
+  std::vector<array> arrays;
+  vlrx::pool_statistics owner_after_remote_frees{};
+  std::thread{[&] {
+    for (std::size_t idx{}; idx < block_count; ++idx) {
+      arrays.emplace_back(block_size);
+    }
+    std::vector<array> freed_elsewhere(
+        std::make_move_iterator(arrays.begin() + block_count / 2),
+        std::make_move_iterator(arrays.end()));
+    arrays.resize(block_count / 2);
+    // the owner is alive, but does not allocate any more
+    std::thread{[&] { freed_elsewhere.clear(); }}.join();
+    owner_after_remote_frees = vlrx::thread_pool_statistics();
+  }}.join();
+  REQUIRE(owner_after_remote_frees.remote_frees == 2);
+  REQUIRE(owner_after_remote_frees.releases == block_count / 2 - 2);
+  REQUIRE(owner_after_remote_frees.cached_bytes == 2 * class_bytes);
+
+  // the owner has exited, so its blocks go back to malloc
+  const auto before = vlrx::total_pool_statistics();
+  arrays.clear();
+  const auto after = vlrx::total_pool_statistics();
+  REQUIRE(after.releases - before.releases == block_count / 2);
+  REQUIRE(after.remote_frees == before.remote_frees);
+  REQUIRE(after.cached_bytes == 0);
+}
+
+namespace {
+
+template <typename T> void check_simd_kernels(const std::uint64_t size) {
+  const vlrx::heap_array<T> values(
+      size, vlrx::from_generator, [](const std::uint64_t idx) {
+        const auto value = static_cast<int>((idx * 37 + 11) % 101);
+        return static_cast<T>(std::is_signed_v<T> ? value - 50 : value);
+      });
+  REQUIRE(vlrx::simd::sum(values) ==
+          std::accumulate(values.begin(), values.end(), T{}));
+  REQUIRE(vlrx::simd::count(values, T{7}) ==
+          static_cast<std::size_t>(
+              std::count(values.begin(), values.end(), T{7})));
+  REQUIRE(vlrx::simd::find(values, T{120}) == size);
+  if (size > 0) {
+    const auto min = std::min_element(values.begin(), values.end());
+    const auto max = std::max_element(values.begin(), values.end());
+    REQUIRE(vlrx::simd::min(values) == *min);
+    REQUIRE(vlrx::simd::max(values) == *max);
+    REQUIRE(vlrx::simd::argmin(values) ==
+            static_cast<std::size_t>(min - values.begin()));
+    REQUIRE(vlrx::simd::argmax(values) ==
+            static_cast<std::size_t>(max - values.begin()));
+    const auto needle = values[size - 1];
+    REQUIRE(vlrx::simd::find(values, needle) ==
+            static_cast<std::size_t>(
+                std::find(values.begin(), values.end(), needle) -
+                values.begin()));
+  }
+
+  auto expected = values;
+  auto result = values;
+  for (auto &value : expected) {
+    value = static_cast<T>(value * 2);
+  }
+  vlrx::simd::scale(result, 2);
+  REQUIRE(result == expected);
+  for (std::uint64_t idx{}; idx < size; ++idx) {
+    expected[idx] = static_cast<T>(expected[idx] + 3 * values[idx]);
+  }
+  vlrx::simd::axpy(3, values, result);
+  REQUIRE(result == expected);
+  for (std::uint64_t idx{}; idx < size; ++idx) {
+    expected[idx] = std::clamp(values[idx], T{10}, T{40});
+  }
+  result = values;
+  vlrx::simd::clamp(result, 10, 40);
+  REQUIRE(result == expected);
+  vlrx::simd::fill(result, 5);
+  REQUIRE(static_cast<std::uint64_t>(std::count(
+              result.begin(), result.end(), T{5})) == size);
+}
+
+} // namespace
+
+TEST_CASE("SIMD kernels match standard algorithms at every level",
+          "[simd][dispatch]") {
+  using vlrx::simd::level;
+  for (const auto limit :
+       {level::scalar, level::sse2, level::avx2, level::avx512}) {
+    if (limit > vlrx::simd::supported_level()) {
+      break;
+    }
+    vlrx::simd::set_level_limit(limit);
+    REQUIRE(vlrx::simd::active_level() == limit);
+    for (const std::uint64_t size : {0, 1, 7, 16, 33, 100, 1000, 4099}) {
+      check_simd_kernels<std::int8_t>(size);
+      check_simd_kernels<std::uint8_t>(size);
+      check_simd_kernels<std::int16_t>(size);
+      check_simd_kernels<std::int32_t>(size);
+      check_simd_kernels<std::uint64_t>(size);
+      check_simd_kernels<float>(size);
+      check_simd_kernels<double>(size);
+    }
+  }
+  vlrx::simd::set_level_limit(level::avx512);
+  REQUIRE(vlrx::simd::active_level() == vlrx::simd::supported_level());
+  const long double extended[]{2.0L, -1.0L, 3.0L};
+  REQUIRE(vlrx::simd::sum(extended) == 4.0L);
+  REQUIRE(vlrx::simd::argmin(extended) == 1);
+}
+
+TEST_CASE("Search index finds the same positions as binary search",
+          "[heap_search_index][lower_bound]") {
+  const vlrx::heap_search_index<std::uint64_t> empty{
+      vlrx::heap_array<std::uint64_t>{}};
+  REQUIRE(empty.empty());
+  REQUIRE(empty.lower_bound(5) == 0);
+  REQUIRE_FALSE(empty.contains(5));
+  // every shape of the deepest level, keys between and around the sorted
+  // ones, and duplicates which have to resolve to the first of them
+  for (std::uint64_t size{1}; size <= 70; ++size) {
+    const vlrx::heap_array<std::uint64_t> sorted(
+        size, vlrx::from_generator,
+        [](const std::uint64_t idx) { return idx / 3 * 4 + 1; });
+    const vlrx::heap_search_index<std::uint64_t> index{sorted};
+    REQUIRE(index.size() == size);
+    const vlrx::heap_array<std::uint64_t> keys(
+        sorted.back() + 3, vlrx::from_generator,
+        [](const std::uint64_t key) { return key; });
+    vlrx::heap_array<std::uint64_t> positions(keys.size());
+    vlrx::heap_array<bool> found(keys.size());
+    index.lower_bound(keys.data(), keys.size(), positions.data());
+    index.contains(keys.data(), keys.size(), found.data());
+    for (const auto key : keys) {
+      const auto expected = static_cast<std::uint64_t>(
+          std::lower_bound(sorted.begin(), sorted.end(), key) -
+          sorted.begin());
+      const bool present =
+          std::binary_search(sorted.begin(), sorted.end(), key);
+      REQUIRE(index.lower_bound(key) == expected);
+      REQUIRE(index.contains(key) == present);
+      REQUIRE(positions[key] == expected);
+      REQUIRE(found[key] == present);
+    }
+  }
+}
+
+TEST_CASE("Search index accepts custom order and other ranges",
+          "[heap_search_index][compare]") {
+  const std::vector<std::string> names{"zeta", "kappa", "delta", "alpha"};
+  const vlrx::heap_search_index<std::string, std::uint32_t,
+                                std::greater<std::string>>
+      index{names};
+  REQUIRE(index.lower_bound("zeta") == 0);
+  REQUIRE(index.lower_bound("gamma") == 2);
+  REQUIRE(index.lower_bound("a") == 4);
+  REQUIRE(index.contains("delta"));
+  REQUIRE_FALSE(index.contains("omega"));
+  const std::string keys[]{"omega", "alpha", "kappa"};
+  std::uint32_t positions[3]{};
+  index.lower_bound(keys, 3, positions);
+  REQUIRE(positions[0] == 1);
+  REQUIRE(positions[1] == 3);
+  REQUIRE(positions[2] == 1);
+
+  // node indices of a narrow size type must not wrap around
+  std::vector<std::uint16_t> narrow(127);
+  std::iota(narrow.begin(), narrow.end(), std::uint16_t{1});
+  using narrow_index_type =
+      vlrx::heap_search_index<std::uint16_t, std::uint8_t>;
+  const narrow_index_type narrow_index{narrow};
+  REQUIRE(narrow_index.lower_bound(1000) == 127);
+  REQUIRE(narrow_index.lower_bound(127) == 126);
+  REQUIRE(narrow_index.contains(1));
+  narrow.push_back(128);
+  REQUIRE_THROWS_AS(narrow_index_type{narrow}, std::length_error);
+}
+
+namespace {
+
+enum class category : std::uint8_t { none, small, medium, large };
+
+// compares operations of a packed array with a heap array of the same values
+template <typename Array, typename Generator>
+void check_packed_array(const std::uint64_t size, Generator generator) {
+  using value_type = typename Array::value_type;
+  const vlrx::heap_array<value_type> expected(size, vlrx::from_generator,
+                                              generator);
+  Array array(size, vlrx::from_generator, generator);
+  REQUIRE(array.size() == size);
+  REQUIRE(array.words().size() ==
+          (size + Array::elements_per_word - 1) / Array::elements_per_word);
+  REQUIRE(std::equal(array.begin(), array.end(), expected.begin(),
+                     expected.end()));
+  REQUIRE(Array{expected} == array);
+  REQUIRE(array.to_heap_array() == expected);
+  REQUIRE_THROWS_AS(array.at(size), std::out_of_range);
+
+  std::vector<value_type> needles{value_type{}};
+  if (size > 0) {
+    needles.push_back(expected[size / 2]);
+    needles.push_back(expected[size - 1]);
+  }
+  for (const auto needle : needles) {
+    REQUIRE(array.count(needle) ==
+            static_cast<std::uint64_t>(
+                std::count(expected.begin(), expected.end(), needle)));
+    for (const auto from : {std::uint64_t{}, size / 3}) {
+      REQUIRE(array.find(needle, from) ==
+              static_cast<std::uint64_t>(
+                  std::find(expected.begin() + from, expected.end(), needle) -
+                  expected.begin()));
+    }
+  }
+
+  // ranges which start and end inside words
+  auto reversed = expected;
+  std::reverse(reversed.begin(), reversed.end());
+  auto expected_after = expected;
+  const auto first = std::min<std::uint64_t>(size, 3);
+  const auto count = size - first - std::min<std::uint64_t>(size - first, 2);
+  array.set(first, reversed.data() + first, count);
+  for (auto idx = first; idx < first + count; ++idx) {
+    expected_after[idx] = reversed[idx];
+  }
+  REQUIRE(std::equal(array.begin(), array.end(), expected_after.begin(),
+                     expected_after.end()));
+  vlrx::heap_array<value_type> part(count, vlrx::for_overwrite);
+  array.get(first, count, part.data());
+  REQUIRE(std::equal(part.begin(), part.end(), reversed.begin() + first));
+
+  for (std::uint64_t idx{}; idx < size; ++idx) {
+    array[idx] = expected[idx];
+  }
+  REQUIRE(array == Array{expected});
+  if (size > 1) {
+    swap(array[0], array[size - 1]);
+    REQUIRE(array.front() == expected[size - 1]);
+    REQUIRE(array.back() == expected[0]);
+  }
+  array.fill(expected.empty() ? value_type{} : expected[0]);
+  REQUIRE(array == Array(size, expected.empty() ? value_type{} : expected[0]));
+}
+
+} // namespace
+
+TEST_CASE("Packed heap array keeps narrow values in whole words",
+          "[packed_heap_array][bits]") {
+  // the number of words is kept by the word array, not in its heap buffer
+  static_assert(sizeof(vlrx::packed_heap_array<3>) ==
+                sizeof(vlrx::heap_array<std::uint64_t>) +
+                    sizeof(std::uint64_t));
+  static_assert(vlrx::packed_heap_array<3>::elements_per_word == 21);
+  static_assert(std::is_same_v<vlrx::packed_heap_array<12>::value_type,
+                               std::uint16_t>);
+  for (const std::uint64_t size : {0, 1, 20, 21, 22, 64, 65, 1000}) {
+    check_packed_array<vlrx::bit_heap_array<>>(
+        size, [](const std::uint64_t idx) { return idx % 3 == 0; });
+    check_packed_array<vlrx::packed_heap_array<3>>(
+        size, [](const std::uint64_t idx) { return idx * 5 % 8; });
+    check_packed_array<vlrx::packed_heap_array<7>>(
+        size, [](const std::uint64_t idx) { return idx * 37 % 128; });
+    check_packed_array<vlrx::packed_heap_array<12, std::uint16_t>>(
+        size, [](const std::uint64_t idx) { return idx * 2654435761 % 4096; });
+    check_packed_array<vlrx::packed_heap_array<5, std::int8_t>>(
+        size, [](const std::uint64_t idx) {
+          return static_cast<std::int8_t>(static_cast<int>(idx % 32) - 16);
+        });
+    check_packed_array<vlrx::packed_heap_array<2, category>>(
+        size, [](const std::uint64_t idx) {
+          return static_cast<category>(idx * 7 % 4);
+        });
+    check_packed_array<vlrx::packed_heap_array<64>>(
+        size,
+        [](const std::uint64_t idx) { return ~idx * 0x9E3779B97F4A7C15; });
+  }
+}
+
+TEST_CASE("Packed heap array proxies behave like references",
+          "[packed_heap_array][proxy]") {
+  vlrx::packed_heap_array<4> nibbles{1, 2, 3, 15};
+  nibbles[0] = nibbles[3];
+  nibbles[1] = 17; // truncated to the lowest four bits
+  REQUIRE(nibbles == vlrx::packed_heap_array<4>{15, 1, 3, 15});
+  std::sort(nibbles.begin(), nibbles.end());
+  REQUIRE(nibbles == vlrx::packed_heap_array<4>{1, 3, 15, 15});
+  REQUIRE(nibbles < vlrx::packed_heap_array<4>{2});
+  const auto found = std::find(nibbles.cbegin(), nibbles.cend(), 3);
+  REQUIRE(found - nibbles.cbegin() == 1);
+  auto moved = std::move(nibbles);
+  REQUIRE(nibbles.empty());
+  REQUIRE(moved.size() == 4);
+  vlrx::bit_heap_array<> flags(130);
+  REQUIRE(flags.count(true) == 0);
+  REQUIRE(flags.find(true) == flags.size());
+  flags[129] = true;
+  flags[64] = true;
+  REQUIRE(flags.count(true) == 2);
+  REQUIRE(flags.find(true) == 64);
+  REQUIRE(flags.find(true, 65) == 129);
+  REQUIRE(flags.find(false, 64) == 65);
+}